@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "effect_codegen.hpp"
+#include <string_view>
+#include <unordered_map>
+
+using namespace reshadefx;
+
+std::vector<codegen::id> codegen::remove_unreferenced_functions()
+{
+	std::unordered_set<id> referenced_functions;
+	for (const std::pair<std::string, shader_type> &entry_point : _module.entry_points)
+	{
+		if (const function *const func = find_function(entry_point.first); func != nullptr)
+		{
+			referenced_functions.insert(func->id);
+			// List of referenced functions already includes those called indirectly, so no need to recurse
+			referenced_functions.insert(func->referenced_functions.begin(), func->referenced_functions.end());
+		}
+	}
+
+	std::vector<id> removed_functions;
+	_functions.erase(std::remove_if(_functions.begin(), _functions.end(),
+		[&referenced_functions, &removed_functions](const std::unique_ptr<function> &func) {
+			if (referenced_functions.find(func->id) != referenced_functions.end())
+				return false;
+			removed_functions.push_back(func->id);
+			return true;
+		}), _functions.end());
+
+	return removed_functions;
+}
+
+static bool is_identifier_start(char c)
+{
+	return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+}
+static bool is_identifier_char(char c)
+{
+	return is_identifier_start(c) || (c >= '0' && c <= '9');
+}
+static bool is_identifier(std::string_view name)
+{
+	return !name.empty() && is_identifier_start(name[0]) && std::all_of(name.begin(), name.end(), is_identifier_char);
+}
+
+/// <summary>
+/// A single line of generated code, which may declare or assign to a variable.
+/// </summary>
+struct code_line
+{
+	std::string_view text;
+	// Range of all identifiers in this line (excluding member names and swizzles following a dot) in the list of identifiers of the function
+	size_t identifiers_begin = 0;
+	size_t identifiers_end = 0;
+	// Name of the variable this line declares or assigns to, or empty if it is any other kind of statement
+	std::string_view target;
+	bool is_declaration = false;
+	bool has_side_effects = false;
+	bool removed = false;
+};
+
+static void parse_line(code_line &line, std::vector<std::string_view> &identifiers, const std::unordered_set<std::string> &functions_with_side_effects)
+{
+	const std::string_view text = line.text;
+	line.identifiers_begin = line.identifiers_end = identifiers.size();
+
+	size_t statement_begin = text.find_first_not_of('\t');
+	if (statement_begin == std::string_view::npos || text[statement_begin] == '#')
+		return; // Preprocessor directives like '#line' may contain file names, which should not be mistaken for identifiers
+
+	for (size_t i = statement_begin; i < text.size();)
+	{
+		if (is_identifier_start(text[i]))
+		{
+			size_t k = i;
+			while (k < text.size() && is_identifier_char(text[k]))
+				++k;
+
+			if (i == 0 || text[i - 1] != '.')
+			{
+				const std::string_view name = text.substr(i, k - i);
+				identifiers.push_back(name);
+				line.identifiers_end = identifiers.size();
+
+				// Calls to functions that may write to memory or to their output parameters have to be kept, even if their result is unused
+				if (k < text.size() && text[k] == '(' && (
+						name.compare(0, 6, "atomic") == 0 ||
+						name.compare(0, 11, "imageAtomic") == 0 ||
+						name.compare(0, 11, "Interlocked") == 0 ||
+						functions_with_side_effects.find(std::string(name)) != functions_with_side_effects.end()))
+					line.has_side_effects = true;
+			}
+
+			i = k;
+		}
+		else if (text[i] >= '0' && text[i] <= '9')
+		{
+			// Skip numeric literals, including suffixes and exponents, so that they are not mistaken for identifiers
+			for (++i; i < text.size() && (is_identifier_char(text[i]) || text[i] == '.' || ((text[i] == '+' || text[i] == '-') && (text[i - 1] == 'e' || text[i - 1] == 'E'))); ++i)
+				continue;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// Only consider simple statements of the form "type name = value;", "type name;" or "name.member = value;"
+	if (text.back() != ';' || text.find(';') != text.size() - 1)
+		return;
+
+	const size_t assignment = text.find(" = ", statement_begin);
+	const std::string_view lhs = text.substr(statement_begin, (assignment != std::string_view::npos ? assignment : text.size() - 1) - statement_begin);
+
+	if (const size_t name_begin = lhs.rfind(' '); name_begin != std::string_view::npos)
+	{
+		std::string_view name = lhs.substr(name_begin + 1);
+		// Array declarations have the array length after the name
+		if (const size_t array_begin = name.find('['); array_begin != std::string_view::npos && name.back() == ']')
+			name = name.substr(0, array_begin);
+
+		if (!is_identifier(name) || lhs.compare(0, 7, "return ") == 0)
+			return;
+
+		// All words in front of the name have to be part of the type
+		for (size_t word_begin = 0, word_end = 0; word_begin < name_begin; word_begin = word_end + 1)
+			if (word_end = lhs.find(' ', word_begin); !is_identifier(lhs.substr(word_begin, word_end - word_begin)))
+				return;
+
+		line.target = name;
+		line.is_declaration = true;
+	}
+	else if (assignment != std::string_view::npos && is_identifier_start(lhs[0]))
+	{
+		size_t name_end = 0;
+		while (name_end < lhs.size() && is_identifier_char(lhs[name_end]))
+			++name_end;
+
+		// Anything following the name has to be a member, index or swizzle, which all write to part of the variable
+		if (name_end != lhs.size() && lhs[name_end] != '.' && lhs[name_end] != '[')
+			return;
+
+		line.target = lhs.substr(0, name_end);
+	}
+}
+
+void codegen::remove_unused_local_variables(std::string &function_code, const std::unordered_set<std::string> &functions_with_side_effects)
+{
+	std::vector<code_line> lines;
+	std::vector<std::string_view> identifiers;
+	for (size_t line_begin = 0, line_end; line_begin < function_code.size(); line_begin = line_end + 1)
+	{
+		if ((line_end = function_code.find('\n', line_begin)) == std::string::npos)
+			line_end = function_code.size();
+
+		code_line &line = lines.emplace_back();
+		line.text = std::string_view(function_code).substr(line_begin, line_end - line_begin);
+		parse_line(line, identifiers, functions_with_side_effects);
+	}
+
+	std::unordered_map<std::string_view, size_t> use_counts;
+	// Lines assigning to each local variable (the continue block of a loop may be duplicated, so a variable can have multiple declarations as well)
+	std::unordered_map<std::string_view, std::vector<size_t>> assignments;
+
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		for (size_t k = lines[i].identifiers_begin; k < lines[i].identifiers_end; ++k)
+			use_counts[identifiers[k]]++;
+
+		if (!lines[i].target.empty())
+			assignments[lines[i].target].push_back(i);
+	}
+
+	std::vector<std::string_view> worklist;
+	for (const auto &[name, assignment_lines] : assignments)
+		// Only variables declared in this function can be removed, not parameters or global variables
+		if (std::any_of(assignment_lines.begin(), assignment_lines.end(), [&lines](size_t i) { return lines[i].is_declaration; }))
+			worklist.push_back(name);
+
+	bool removed_any = false;
+
+	while (!worklist.empty())
+	{
+		const std::string_view name = worklist.back();
+		worklist.pop_back();
+
+		const auto it = assignments.find(name);
+		if (it == assignments.end() || !std::any_of(it->second.begin(), it->second.end(), [&lines](size_t i) { return lines[i].is_declaration; }))
+			continue;
+
+		// Variable is unused if every occurrence of its name is the target of an assignment (which also means that it is not passed to an output parameter or read in its own assignments)
+		size_t num_assignments = 0;
+		bool has_side_effects = false;
+		for (const size_t i : it->second)
+		{
+			if (lines[i].removed)
+				continue;
+			num_assignments++;
+			has_side_effects |= lines[i].has_side_effects;
+		}
+
+		if (num_assignments == 0 || has_side_effects || use_counts[name] != num_assignments)
+			continue;
+
+		for (const size_t i : it->second)
+		{
+			if (lines[i].removed)
+				continue;
+
+			lines[i].removed = true;
+			removed_any = true;
+
+			// Variables read by the removed line may have become unused now too
+			for (size_t k = lines[i].identifiers_begin; k < lines[i].identifiers_end; ++k)
+			{
+				use_counts[identifiers[k]]--;
+				if (identifiers[k] != name)
+					worklist.push_back(identifiers[k]);
+			}
+		}
+	}
+
+	if (!removed_any)
+		return;
+
+	std::string result;
+	result.reserve(function_code.size());
+
+	// Only the last of multiple consecutive '#line' directives has any effect, so skip the others, which are left over from removed lines
+	std::string_view line_directive;
+	for (const code_line &line : lines)
+	{
+		if (line.removed)
+			continue;
+
+		if (line.text.compare(0, 6, "#line ") == 0)
+		{
+			line_directive = line.text;
+			continue;
+		}
+
+		if (!line_directive.empty())
+		{
+			result += line_directive;
+			result += '\n';
+			line_directive = std::string_view();
+		}
+
+		result += line.text;
+		result += '\n';
+	}
+
+	function_code = std::move(result);
+}
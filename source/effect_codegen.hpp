@@ -7,6 +7,10 @@
 
 #include "effect_module.hpp"
 #include <memory> // std::unique_ptr
+#include <memory_resource>
+#include <functional>
+#include <unordered_set>
+#include <cstring> // std::memcmp
 #include <algorithm> // std::find_if
 
 namespace reshadefx
@@ -19,6 +23,12 @@ namespace reshadefx
 		friend class parser;
 
 	public:
+		/// <summary>
+		/// Function that calls <c>func</c> once for every index from zero to <c>count</c> (exclusive), possibly spread across multiple threads, and only returns once all calls have finished.
+		/// This lets the caller decide on which threads work is executed (e.g. on its own thread pool).
+		/// </summary>
+		using parallel_executor = std::function<void(size_t count, const std::function<void(size_t index)> &func)>;
+
 		/// <summary>
 		/// Virtual destructor to guarantee that memory of the implementations deriving from this interface is properly destroyed.
 		/// </summary>
@@ -29,6 +39,12 @@ namespace reshadefx
 		/// </summary>
 		const effect_module &module() const { return _module; }
 
+		/// <summary>
+		/// Propagates copies and constants, folds constant operations and removes dead code in the generated code.
+		/// This is optional and should be called after parsing succeeded and before finalizing the code. Backends that produce source code only remove unused local variables and functions, which reduces the amount of code the driver compiler has to process.
+		/// </summary>
+		virtual void optimize_code() {}
+
 		/// <summary>
 		/// Finalizes and returns the generated code for the entire module (all entry points).
 		/// </summary>
@@ -38,6 +54,12 @@ namespace reshadefx
 		/// </summary>
 		/// <param name="entry_point_name">Name of the entry point function to generate code for.</param>
 		virtual std::basic_string<char> finalize_code_for_entry_point(const std::string &entry_point_name) const = 0;
+		/// <summary>
+		/// Finalizes and returns the generated code for every entry point in the module, in the same order as <see cref="effect_module::entry_points"/>.
+		/// This is equivalent to calling <see cref="finalize_code_for_entry_point"/> for each of them, but only generates the parts shared between entry points once.
+		/// </summary>
+		/// <param name="executor">Optional executor to spread the work for the different entry points across threads with. If not set, all work is done on the calling thread.</param>
+		virtual std::vector<std::basic_string<char>> finalize_code_for_entry_points(const parallel_executor &executor = nullptr) const = 0;
 
 	protected:
 		/// <summary>
@@ -373,6 +395,96 @@ namespace reshadefx
 
 		id make_id() { return _next_id++; }
 
+		/// <summary>
+		/// Calls the specified <paramref name="finalize"/> function for every entry point in the module and collects the results, using the specified <paramref name="executor"/> if set.
+		/// </summary>
+		template <typename F>
+		std::vector<std::basic_string<char>> finalize_each_entry_point(const parallel_executor &executor, F finalize) const
+		{
+			std::vector<std::basic_string<char>> results(_module.entry_points.size());
+
+			const auto finalize_one = [this, &results, &finalize](size_t i) {
+				if (const function *const entry_point = find_function(_module.entry_points[i].first); entry_point != nullptr)
+					results[i] = finalize(*entry_point);
+			};
+
+			if (executor == nullptr || results.size() <= 1)
+			{
+				for (size_t i = 0; i < results.size(); ++i)
+					finalize_one(i);
+			}
+			else
+			{
+				executor(results.size(), finalize_one);
+			}
+
+			return results;
+		}
+
+		/// <summary>
+		/// Removes all functions that are not referenced by any entry point.
+		/// </summary>
+		/// <returns>IDs of the removed functions, so that back-ends can release the code they generated for them.</returns>
+		std::vector<id> remove_unreferenced_functions();
+		/// <summary>
+		/// Removes local variables that are never read from the code of a function generated by a back-end that produces source code, together with all assignments to them.
+		/// Removing a variable can make the variables its value was computed from unused as well, so this repeats until no more variables can be removed.
+		/// </summary>
+		/// <param name="function_code">Code of the function, with each statement on its own line.</param>
+		/// <param name="functions_with_side_effects">Names of functions which may have side effects, so that values computed by calling them are kept even if unused.</param>
+		static void remove_unused_local_variables(std::string &function_code, const std::unordered_set<std::string> &functions_with_side_effects);
+
+		/// <summary>
+		/// Hash function for data types, which ignores qualifiers the same way comparing types does.
+		/// </summary>
+		struct type_hash
+		{
+			size_t operator()(const type &type) const
+			{
+				size_t hash = static_cast<size_t>(type.base);
+				hash = hash * 31 + type.rows;
+				hash = hash * 31 + type.cols;
+				hash = hash * 31 + type.array_length;
+				hash = hash * 31 + type.struct_definition;
+				return hash;
+			}
+			size_t operator()(const std::vector<type> &types) const
+			{
+				size_t hash = types.size();
+				for (const type &type : types)
+					hash = hash * 31 + operator()(type);
+				return hash;
+			}
+		};
+		/// <summary>
+		/// Hash and comparison functions for a data type with constant data, which treat constants as equal when their type, components and array elements match, so that back-ends can reuse existing constant definitions.
+		/// </summary>
+		struct constant_hash
+		{
+			size_t operator()(const std::pair<type, constant> &key) const
+			{
+				size_t hash = type_hash()(key.first);
+				for (const uint32_t value : key.second.as_uint)
+					hash = hash * 31 + value;
+				for (const constant &element : key.second.array_data)
+					for (const uint32_t value : element.as_uint)
+						hash = hash * 31 + value;
+				return hash;
+			}
+			bool operator()(const std::pair<type, constant> &lhs, const std::pair<type, constant> &rhs) const
+			{
+				if (!(lhs.first == rhs.first && std::memcmp(&lhs.second.as_uint[0], &rhs.second.as_uint[0], sizeof(uint32_t) * 16) == 0 && lhs.second.array_data.size() == rhs.second.array_data.size()))
+					return false;
+				for (size_t i = 0; i < lhs.second.array_data.size(); ++i)
+					if (std::memcmp(&lhs.second.array_data[i].as_uint[0], &rhs.second.array_data[i].as_uint[0], sizeof(uint32_t) * 16) != 0)
+						return false;
+				return true;
+			}
+		};
+
+		// Memory for data that is only needed while generating code, which is released all at once when the code generator is destroyed instead of object by object
+		std::pmr::monotonic_buffer_resource _arena;
+
 		effect_module _module;
 		std::vector<struct_type> _structs;
 		std::vector<std::unique_ptr<function>> _functions;
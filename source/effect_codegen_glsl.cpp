@@ -9,7 +9,7 @@
 #include <cassert>
 #include <cstring> // std::memcmp
 #include <charconv> // std::from_chars, std::to_chars
-#include <algorithm> // std::find, std::find_if, std::max
+#include <algorithm> // std::find_if, std::max
 #include <unordered_set>
 
 using namespace reshadefx;
@@ -34,7 +34,10 @@ public:
 		_vulkan_semantics(vulkan_semantics),
 		_uniforms_to_spec_constants(uniforms_to_spec_constants),
 		_enable_16bit_types(enable_16bit_types),
-		_flip_vert_y(flip_vert_y)
+		_flip_vert_y(flip_vert_y),
+		_names(&_arena),
+		_name_counts(&_arena),
+		_blocks(&_arena)
 	{
 		// Create default block and reserve a memory block to avoid frequent reallocations
 		std::string &block = _blocks.emplace(0, std::string()).first->second;
@@ -60,15 +63,18 @@ private:
 	bool _enable_16bit_types = false;
 	bool _flip_vert_y = false;
 
-	std::unordered_map<id, std::string> _names;
-	std::unordered_map<id, std::string> _blocks;
+	std::pmr::unordered_map<id, std::string> _names;
+	// Number of IDs each name is assigned to, so that 'define_name' can check for clashes without going through all names
+	std::pmr::unordered_map<std::string, size_t> _name_counts;
+	std::pmr::unordered_map<id, std::string> _blocks;
 	std::string _ubo_block;
 	std::string _compute_block;
 	std::string _current_function_declaration;
 
 	std::unordered_map<id, id> _remapped_sampler_variables;
 	std::unordered_map<std::string, uint32_t> _semantic_to_location;
-	std::vector<std::tuple<type, constant, id>> _constant_lookup;
+	std::unordered_map<std::pair<type, constant>, id, constant_hash, constant_hash> _constant_lookup;
+	std::unordered_set<id> _constant_ids;
 
 	// Only write compatibility intrinsics to result if they are actually in use
 	bool _uses_fmod = false;
@@ -169,9 +175,70 @@ private:
 		if (entry_point == nullptr)
 			return {};
 
-		std::string code = finalize_preamble();
+		return finalize_code_for_entry_point(*entry_point, finalize_shared_sections());
+	}
+	std::vector<std::string> finalize_code_for_entry_points(const parallel_executor &executor) const override
+	{
+		const shared_sections sections = finalize_shared_sections();
+
+		return finalize_each_entry_point(executor,
+			[this, &sections](const function &entry_point) { return finalize_code_for_entry_point(entry_point, sections); });
+	}
+
+	void optimize_code() override
+	{
+		// Constant expressions were already folded by the parser, so only need to get rid of code the driver compiler would otherwise have to parse and eliminate itself
+		for (const id function_id : remove_unreferenced_functions())
+			_blocks.erase(function_id);
+
+		// Functions may write to output parameters or storage objects, so assume that calls to them always have side effects
+		std::unordered_set<std::string> function_names;
+		for (const std::unique_ptr<function> &func : _functions)
+			function_names.insert(id_to_name(func->id));
 
-		if (entry_point->type != shader_type::pixel)
+		for (const std::unique_ptr<function> &func : _functions)
+			remove_unused_local_variables(_blocks.at(func->id), function_names);
+	}
+
+	/// <summary>
+	/// Code that is identical for all entry points.
+	/// </summary>
+	struct shared_sections
+	{
+		std::string preamble;
+		// Range of the binding index in the code of each sampler and storage definition, so that it can be replaced without searching for it for every entry point
+		std::unordered_map<id, std::pair<size_t, size_t>> binding_locations;
+	};
+
+	shared_sections finalize_shared_sections() const
+	{
+		shared_sections sections;
+		sections.preamble = finalize_preamble();
+
+		const auto find_binding =
+			[this, &sections](id block) {
+				const std::string &code = _blocks.at(block);
+				size_t beg = code.find("layout(binding = ");
+				if (beg == std::string::npos)
+					return; // Definition is empty when the target does not support it
+				beg += 17;
+				const size_t end = code.find_first_of("),", beg);
+				sections.binding_locations.emplace(block, std::make_pair(beg, end));
+			};
+
+		for (const sampler &info : _module.samplers)
+			find_binding(info.id);
+		for (const storage &info : _module.storages)
+			find_binding(info.id);
+
+		return sections;
+	}
+
+	std::string finalize_code_for_entry_point(const function &entry_point, const shared_sections &sections) const
+	{
+		std::string code = sections.preamble;
+
+		if (entry_point.type != shader_type::pixel)
 			code +=
 				// OpenGL does not allow using 'discard' in the vertex shader profile
 				"#define discard\n"
@@ -180,7 +247,7 @@ private:
 				"#define dFdy(y) y\n"
 				"#define fwidth(p) p\n";
 
-		if (entry_point->type != shader_type::compute)
+		if (entry_point.type != shader_type::compute)
 			code +=
 				// OpenGL does not allow using 'shared' in vertex/fragment shader profile
 				"#define shared\n"
@@ -197,43 +264,48 @@ private:
 				"#define memoryBarrier()\n"
 				"#define groupMemoryBarrier()\n";
 
-		const auto replace_binding =
-			[](std::string &code, uint32_t binding) {
-				const size_t beg = code.find("layout(binding = ") + 17;
-				const size_t end = code.find_first_of("),", beg);
-				code.replace(beg, end - beg, std::to_string(binding));
+		const auto append_with_binding =
+			[this, &code, &sections](id block, uint32_t binding) {
+				const std::string &block_code = _blocks.at(block);
+				if (const auto binding_location = sections.binding_locations.find(block);
+					binding_location != sections.binding_locations.end())
+				{
+					code.append(block_code, 0, binding_location->second.first);
+					code += std::to_string(binding);
+					code.append(block_code, binding_location->second.second, std::string::npos);
+				}
+				else
+				{
+					code += block_code;
+				}
 			};
 
 		// Add referenced sampler definitions
-		for (uint32_t binding = 0; binding < entry_point->referenced_samplers.size(); ++binding)
+		for (uint32_t binding = 0; binding < entry_point.referenced_samplers.size(); ++binding)
 		{
-			if (entry_point->referenced_samplers[binding] == 0)
+			if (entry_point.referenced_samplers[binding] == 0)
 				continue;
 
-			std::string block_code = _blocks.at(entry_point->referenced_samplers[binding]);
-			replace_binding(block_code, binding);
-			code += block_code;
+			append_with_binding(entry_point.referenced_samplers[binding], binding);
 		}
 
 		// Add referenced storage definitions
-		for (uint32_t binding = 0; binding < entry_point->referenced_storages.size(); ++binding)
+		for (uint32_t binding = 0; binding < entry_point.referenced_storages.size(); ++binding)
 		{
-			if (entry_point->referenced_storages[binding] == 0)
+			if (entry_point.referenced_storages[binding] == 0)
 				continue;
 
-			std::string block_code = _blocks.at(entry_point->referenced_storages[binding]);
-			replace_binding(block_code, binding);
-			code += block_code;
+			append_with_binding(entry_point.referenced_storages[binding], binding);
 		}
 
 		// Add global definitions (struct types, global variables, ...)
 		code += _blocks.at(0);
 
 		// Add referenced function definitions
+		const std::unordered_set<id> referenced_functions(entry_point.referenced_functions.begin(), entry_point.referenced_functions.end());
 		for (const std::unique_ptr<function> &func : _functions)
 		{
-			if (func->id != entry_point->id &&
-				std::find(entry_point->referenced_functions.begin(), entry_point->referenced_functions.end(), func->id) == entry_point->referenced_functions.end())
+			if (func->id != entry_point.id && referenced_functions.find(func->id) == referenced_functions.end())
 				continue;
 
 			code += _blocks.at(func->id);
@@ -515,7 +587,7 @@ private:
 	}
 	void write_location(std::string &s, const location &loc) const
 	{
-		if (loc.source.empty() || !_debug_info)
+		if (loc.source().empty() || !_debug_info)
 			return;
 
 		s += "#line " + std::to_string(loc.line) + '\n';
@@ -603,10 +675,15 @@ private:
 		if constexpr (naming_type != naming::reserved)
 			name = escape_name(std::move(name));
 		if constexpr (naming_type == naming::general)
-			if (std::find_if(_names.begin(), _names.end(),
-					[&name](const auto &names_it) { return names_it.second == name; }) != _names.end())
+			if (const auto counts_it = _name_counts.find(name);
+				counts_it != _name_counts.end() && counts_it->second != 0)
 				name += '_' + std::to_string(id); // Append a numbered suffix if the name already exists
-		_names[id] = std::move(name);
+
+		std::string &id_name = _names[id];
+		if (!id_name.empty())
+			_name_counts[id_name]--;
+		id_name = std::move(name);
+		_name_counts[id_name]++;
 	}
 
 	uint32_t semantic_to_location(const std::string &semantic, uint32_t max_attributes = 1)
@@ -880,10 +957,7 @@ private:
 	{
 		// Constant variables with a constant initializer can just point to the initializer SSA variable, since they cannot be modified anyway, thus saving an unnecessary assignment
 		if (initializer_value != 0 && type.has(type::q_const) &&
-			std::find_if(_constant_lookup.begin(), _constant_lookup.end(),
-				[initializer_value](const auto &x) {
-					return initializer_value == std::get<2>(x);
-				}) != _constant_lookup.end())
+			_constant_ids.find(initializer_value) != _constant_ids.end())
 			return initializer_value;
 
 		const id res = make_id();
@@ -1450,7 +1524,7 @@ private:
 	id   emit_load(const expression &exp, bool force_new_id) override
 	{
 		if (exp.is_constant)
-			return emit_constant(exp.type, exp.constant);
+			return emit_constant(exp.type, exp.constant());
 		else if (exp.chain.empty() && !force_new_id) // Can refer to values without access chain directly
 			return exp.base;
 
@@ -1618,19 +1692,14 @@ private:
 		{
 			assert(data_type.has(type::q_const));
 
-			if (const auto it = std::find_if(_constant_lookup.begin(), _constant_lookup.end(),
-					[&data_type, &data](const std::tuple<type, constant, id> &x) {
-						if (!(std::get<0>(x) == data_type && std::memcmp(&std::get<1>(x).as_uint[0], &data.as_uint[0], sizeof(uint32_t) * 16) == 0 && std::get<1>(x).array_data.size() == data.array_data.size()))
-							return false;
-						for (size_t i = 0; i < data.array_data.size(); ++i)
-							if (std::memcmp(&std::get<1>(x).array_data[i].as_uint[0], &data.array_data[i].as_uint[0], sizeof(uint32_t) * 16) != 0)
-								return false;
-						return true;
-					});
+			if (const auto it = _constant_lookup.find(std::make_pair(data_type, data));
 				it != _constant_lookup.end())
-				return std::get<2>(*it); // Reuse existing constant instead of duplicating the definition
+				return it->second; // Reuse existing constant instead of duplicating the definition
 			else if (data_type.is_array())
-				_constant_lookup.push_back({ data_type, data, res });
+			{
+				_constant_lookup.emplace(std::make_pair(data_type, data), res);
+				_constant_ids.insert(res);
+			}
 
 			// Put constant variable into global scope, so that it can be reused in different blocks
 			std::string &code = _blocks.at(0);
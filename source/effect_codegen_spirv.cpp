@@ -8,7 +8,7 @@
 #include <cassert>
 #include <cstring> // std::memcmp
 #include <charconv> // std::from_chars
-#include <algorithm> // std::find_if, std::max, std::sort
+#include <algorithm> // std::find_if, std::max, std::remove_if, std::sort
 #include <unordered_set>
 
 // Use the C++ variant of the SPIR-V headers
@@ -33,9 +33,10 @@ struct spirv_instruction
 	spv::Op op;
 	spv::Id type;
 	spv::Id result;
-	std::vector<spv::Id> operands;
+	std::pmr::vector<spv::Id> operands;
 
 	explicit spirv_instruction(spv::Op op = spv::OpNop) : op(op), type(0), result(0) {}
+	spirv_instruction(spv::Op op, std::pmr::memory_resource *resource) : op(op), type(0), result(0), operands(resource) {}
 	spirv_instruction(spv::Op op, spv::Id result) : op(op), type(result), result(0) {}
 	spirv_instruction(spv::Op op, spv::Id type, spv::Id result) : op(op), type(type), result(result) {}
 
@@ -88,8 +89,7 @@ struct spirv_instruction
 		// ...           | ...
 		// WordCount - 1 | Operand N (N is determined by WordCount minus the 1 to 3 words used for the opcode, instruction type <id>, and instruction Result <id>).
 
-		const uint32_t word_count = 1 + (type != 0) + (result != 0) + static_cast<uint32_t>(operands.size());
-		write_word(output, (word_count << spv::WordCountShift) | op);
+		write_word(output, (word_count() << spv::WordCountShift) | op);
 
 		// Optional instruction type ID
 		if (type != 0)
@@ -99,14 +99,21 @@ struct spirv_instruction
 		if (result != 0)
 			write_word(output, result);
 
-		// Write out the operands
-		for (const uint32_t operand : operands)
-			write_word(output, operand);
+		// Write out all operands at once
+		output.append(reinterpret_cast<const char *>(operands.data()), operands.size() * sizeof(uint32_t));
 	}
 
 	static void write_word(std::basic_string<char> &output, uint32_t word)
 	{
-		output.insert(output.end(), reinterpret_cast<const char *>(&word), reinterpret_cast<const char *>(&word + 1));
+		output.append(reinterpret_cast<const char *>(&word), sizeof(word));
+	}
+
+	/// <summary>
+	/// Gets the number of words this instruction occupies in a SPIR-V module.
+	/// </summary>
+	uint32_t word_count() const
+	{
+		return 1 + (type != 0) + (result != 0) + static_cast<uint32_t>(operands.size());
 	}
 
 	operator uint32_t() const
@@ -125,11 +132,39 @@ struct spirv_basic_block
 	std::vector<spirv_instruction> instructions;
 
 	/// <summary>
-	/// Append another basic block the end of this one.
+	/// Append another basic block the end of this one, by moving its instructions over and leaving it empty.
+	/// </summary>
+	void append(spirv_basic_block &&block)
+	{
+		if (instructions.empty())
+			instructions = std::move(block.instructions);
+		else
+			instructions.insert(instructions.end(), std::make_move_iterator(block.instructions.begin()), std::make_move_iterator(block.instructions.end()));
+
+		// Release the memory of the other block, since it is no longer used after being merged into this one
+		block.instructions.clear();
+		block.instructions.shrink_to_fit();
+	}
+
+	/// <summary>
+	/// Write all instructions in this basic block to a SPIR-V module.
+	/// </summary>
+	/// <param name="output">The output stream to append the instructions to.</param>
+	void write(std::basic_string<char> &output) const
+	{
+		for (const spirv_instruction &inst : instructions)
+			inst.write(output);
+	}
+
+	/// <summary>
+	/// Gets the number of words all instructions in this basic block occupy in a SPIR-V module.
 	/// </summary>
-	void append(const spirv_basic_block &block)
+	size_t word_count() const
 	{
-		instructions.insert(instructions.end(), block.instructions.begin(), block.instructions.end());
+		size_t word_count = 0;
+		for (const spirv_instruction &inst : instructions)
+			word_count += inst.word_count();
+		return word_count;
 	}
 };
 
@@ -143,7 +178,8 @@ public:
 		_vulkan_semantics(vulkan_semantics),
 		_uniforms_to_spec_constants(uniforms_to_spec_constants),
 		_enable_16bit_types(enable_16bit_types),
-		_flip_vert_y(flip_vert_y)
+		_flip_vert_y(flip_vert_y),
+		_block_data(&_arena)
 	{
 		_glsl_ext = make_id();
 	}
@@ -160,6 +196,19 @@ private:
 		{
 			return lhs.type == rhs.type && lhs.is_ptr == rhs.is_ptr && lhs.array_stride == rhs.array_stride && lhs.storage == rhs.storage;
 		}
+
+		struct hash
+		{
+			size_t operator()(const type_lookup &lookup) const
+			{
+				size_t hash = type_hash()(lookup.type);
+				hash = hash * 31 + lookup.is_ptr;
+				hash = hash * 31 + lookup.array_stride;
+				hash = hash * 31 + lookup.storage.first;
+				hash = hash * 31 + lookup.storage.second;
+				return hash;
+			}
+		};
 	};
 	struct function_blocks
 	{
@@ -168,16 +217,6 @@ private:
 		spirv_basic_block definition;
 		reshadefx::type return_type;
 		std::vector<reshadefx::type> param_types;
-
-		friend bool operator==(const function_blocks &lhs, const function_blocks &rhs)
-		{
-			if (lhs.param_types.size() != rhs.param_types.size())
-				return false;
-			for (size_t i = 0; i < lhs.param_types.size(); ++i)
-				if (!(lhs.param_types[i] == rhs.param_types[i]))
-					return false;
-			return lhs.return_type == rhs.return_type;
-		}
 	};
 
 	bool _debug_info = false;
@@ -195,7 +234,7 @@ private:
 	spirv_basic_block _variables;
 
 	std::vector<function_blocks> _functions_blocks;
-	std::unordered_map<id, spirv_basic_block> _block_data;
+	std::pmr::unordered_map<id, spirv_basic_block> _block_data;
 	spirv_basic_block *_current_block_data = nullptr;
 
 	spv::Id _glsl_ext = 0;
@@ -204,9 +243,10 @@ private:
 	std::vector<spv::Id> _global_ubo_types;
 	function_blocks *_current_function_blocks = nullptr;
 
-	std::vector<std::pair<type_lookup, spv::Id>> _type_lookup;
-	std::vector<std::tuple<type, constant, spv::Id>> _constant_lookup;
-	std::vector<std::pair<function_blocks, spv::Id>> _function_type_lookup;
+	std::unordered_map<type_lookup, spv::Id, type_lookup::hash> _type_lookup;
+	std::unordered_map<std::pair<type, constant>, spv::Id, constant_hash, constant_hash> _constant_lookup;
+	// Lookup table from the return type followed by all parameter types to the matching function type
+	std::unordered_map<std::vector<type>, spv::Id, type_hash> _function_type_lookup;
 	std::unordered_map<std::string, spv::Id> _string_lookup;
 	std::unordered_map<spv::Id, std::pair<spv::StorageClass, spv::ImageFormat>> _storage_lookup;
 	std::unordered_map<std::string, uint32_t> _semantic_to_location;
@@ -216,12 +256,12 @@ private:
 
 	void add_location(const location &loc, spirv_basic_block &block)
 	{
-		if (loc.source.empty() || !_debug_info)
+		if (loc.source().empty() || !_debug_info)
 			return;
 
 		spv::Id file;
 
-		if (const auto it = _string_lookup.find(loc.source);
+		if (const auto it = _string_lookup.find(loc.source());
 			it != _string_lookup.end())
 		{
 			file = it->second;
@@ -230,8 +270,8 @@ private:
 		{
 			file =
 				add_instruction(spv::OpString, 0, _debug_a)
-					.add_string(loc.source.c_str());
-			_string_lookup.emplace(loc.source, file);
+					.add_string(loc.source().c_str());
+			_string_lookup.emplace(loc.source(), file);
 		}
 
 		// https://www.khronos.org/registry/spir-v/specs/unified1/SPIRV.html#OpLine
@@ -261,7 +301,17 @@ private:
 	}
 	spirv_instruction &add_instruction_without_result(spv::Op op, spirv_basic_block &block)
 	{
-		return block.instructions.emplace_back(op);
+		// Operands of instructions live as long as the code generator, so allocate them from its arena
+		return block.instructions.emplace_back(op, &_arena);
+	}
+
+	size_t estimate_code_size() const
+	{
+		// A little more is needed than what is in the sections for the fixed instructions added during finalization
+		size_t word_count = 64 + _entries.word_count() + _execution_modes.word_count() + _debug_a.word_count() + _debug_b.word_count() + _annotations.word_count() + _types_and_constants.word_count() + _variables.word_count() + _global_ubo_types.size();
+		for (const function_blocks &func : _functions_blocks)
+			word_count += func.declaration.word_count() + func.variables.word_count() + func.definition.word_count();
+		return word_count * sizeof(uint32_t);
 	}
 
 	void finalize_header_section(std::basic_string<char> &spirv) const
@@ -304,15 +354,13 @@ private:
 		if (_debug_info)
 		{
 			// All debug instructions
-			for (const spirv_instruction &inst : _debug_a.instructions)
-				inst.write(spirv);
+			_debug_a.write(spirv);
 		}
 	}
 	void finalize_type_and_constants_section(std::basic_string<char> &spirv) const
 	{
 		// All type declarations
-		for (const spirv_instruction &inst : _types_and_constants.instructions)
-			inst.write(spirv);
+		_types_and_constants.write(spirv);
 
 		// Initialize the UBO type now that all member types are known
 		if (_global_ubo_type == 0 || _global_ubo_variable == 0)
@@ -336,29 +384,26 @@ private:
 	std::basic_string<char> finalize_code() const override
 	{
 		std::basic_string<char> spirv;
+		// Reserve enough space for all sections up front, to avoid reallocating the output while writing them
+		spirv.reserve(estimate_code_size());
 		finalize_header_section(spirv);
 
 		// All entry point declarations
-		for (const spirv_instruction &inst : _entries.instructions)
-			inst.write(spirv);
+		_entries.write(spirv);
 
 		// All execution mode declarations
-		for (const spirv_instruction &inst : _execution_modes.instructions)
-			inst.write(spirv);
+		_execution_modes.write(spirv);
 
 		finalize_debug_info_section(spirv);
 
-		for (const spirv_instruction &inst : _debug_b.instructions)
-			inst.write(spirv);
+		_debug_b.write(spirv);
 
 		// All annotation instructions
-		for (const spirv_instruction &inst : _annotations.instructions)
-			inst.write(spirv);
+		_annotations.write(spirv);
 
 		finalize_type_and_constants_section(spirv);
 
-		for (const spirv_instruction &inst : _variables.instructions)
-			inst.write(spirv);
+		_variables.write(spirv);
 
 		// All function definitions
 		for (const function_blocks &func : _functions_blocks)
@@ -366,15 +411,13 @@ private:
 			if (func.definition.instructions.empty())
 				continue;
 
-			for (const spirv_instruction &inst : func.declaration.instructions)
-				inst.write(spirv);
+			func.declaration.write(spirv);
 
 			// Grab first label and move it in front of variable declarations
 			func.definition.instructions.front().write(spirv);
 			assert(func.definition.instructions.front().op == spv::OpLabel);
 
-			for (const spirv_instruction &inst : func.variables.instructions)
-				inst.write(spirv);
+			func.variables.write(spirv);
 			for (auto inst_it = func.definition.instructions.begin() + 1; inst_it != func.definition.instructions.end(); ++inst_it)
 				inst_it->write(spirv);
 		}
@@ -387,12 +430,66 @@ private:
 		if (entry_point == nullptr)
 			return {};
 
+		return finalize_code_for_entry_point(*entry_point, finalize_shared_sections());
+	}
+	std::vector<std::basic_string<char>> finalize_code_for_entry_points(const parallel_executor &executor) const override
+	{
+		const shared_sections sections = finalize_shared_sections();
+
+		return finalize_each_entry_point(executor,
+			[this, &sections](const function &entry_point) { return finalize_code_for_entry_point(entry_point, sections); });
+	}
+
+	/// <summary>
+	/// Sections of the SPIR-V module that are identical for all entry points.
+	/// </summary>
+	struct shared_sections
+	{
+		std::basic_string<char> header;
+		std::basic_string<char> debug_info;
+		std::basic_string<char> types_and_constants;
+		size_t total_size = 0;
+	};
+
+	shared_sections finalize_shared_sections() const
+	{
+		shared_sections sections;
+		finalize_header_section(sections.header);
+		finalize_debug_info_section(sections.debug_info);
+		finalize_type_and_constants_section(sections.types_and_constants);
+		sections.total_size = estimate_code_size();
+		return sections;
+	}
+
+	std::basic_string<char> finalize_code_for_entry_point(const function &entry_point, const shared_sections &sections) const
+	{
 		// Build list of IDs to remove
-		std::vector<spv::Id> variables_to_remove;
-		std::vector<spv::Id> functions_to_remove;
+		std::unordered_set<spv::Id> variables_to_remove;
+		std::unordered_set<spv::Id> functions_to_remove;
+
+		// Remove all functions that are not called from this entry point, along with the values defined in them
+		const std::unordered_set<spv::Id> referenced_functions(entry_point.referenced_functions.begin(), entry_point.referenced_functions.end());
+		for (const function_blocks &function : _functions_blocks)
+		{
+			if (function.definition.instructions.empty())
+				continue;
+
+			const spv::Id definition = function.declaration.instructions[function.declaration.instructions[0].op != spv::OpFunction ? 1 : 0].result;
+
+			if (definition == entry_point.id || referenced_functions.find(definition) != referenced_functions.end())
+				continue;
+
+			functions_to_remove.insert(definition);
+
+			for (const spirv_basic_block *block : { &function.declaration, &function.variables, &function.definition })
+				for (const spirv_instruction &inst : block->instructions)
+					if (inst.result != 0)
+						variables_to_remove.insert(inst.result);
+		}
 
 		std::basic_string<char> spirv;
-		finalize_header_section(spirv);
+		spirv.reserve(sections.total_size);
+		spirv += sections.header;
 
 		// The entry point and execution mode declaration
 		for (const spirv_instruction &inst : _entries.instructions)
@@ -400,17 +497,17 @@ private:
 			assert(inst.op == spv::OpEntryPoint);
 
 			// Only add the matching entry point
-			if (inst.operands[1] == entry_point->id)
+			if (inst.operands[1] == entry_point.id)
 			{
 				inst.write(spirv);
 			}
 			else
 			{
-				functions_to_remove.push_back(inst.operands[1]);
+				functions_to_remove.insert(inst.operands[1]);
 
 				// Add interface variables to list of variables to remove
 				for (uint32_t k = 2 + static_cast<uint32_t>((std::strlen(reinterpret_cast<const char *>(&inst.operands[2])) + 4) / 4); k < inst.operands.size(); ++k)
-					variables_to_remove.push_back(inst.operands[k]);
+					variables_to_remove.insert(inst.operands[k]);
 			}
 		}
 
@@ -419,55 +516,67 @@ private:
 			assert(inst.op == spv::OpExecutionMode);
 
 			// Only add execution mode for the matching entry point
-			if (inst.operands[0] == entry_point->id)
+			if (inst.operands[0] == entry_point.id)
 			{
 				inst.write(spirv);
 			}
 		}
 
-		finalize_debug_info_section(spirv);
+		spirv += sections.debug_info;
 
 		for (const spirv_instruction &inst : _debug_b.instructions)
 		{
-			// Remove all names of interface variables and functions for non-matching entry points
-			if (std::find(variables_to_remove.begin(), variables_to_remove.end(), inst.operands[0]) != variables_to_remove.end() ||
-				std::find(functions_to_remove.begin(), functions_to_remove.end(), inst.operands[0]) != functions_to_remove.end())
+			// Remove all names of interface variables for non-matching entry points and of removed functions and their values
+			if (variables_to_remove.find(inst.operands[0]) != variables_to_remove.end() ||
+				functions_to_remove.find(inst.operands[0]) != functions_to_remove.end())
 				continue;
 
 			inst.write(spirv);
 		}
 
+		// Map referenced samplers and storages to their binding index in this entry point (keeping the first one if referenced multiple times)
+		std::unordered_map<spv::Id, uint32_t> sampler_bindings, storage_bindings;
+		for (uint32_t binding = 0; binding < entry_point.referenced_samplers.size(); ++binding)
+			sampler_bindings.emplace(entry_point.referenced_samplers[binding], binding);
+		for (uint32_t binding = 0; binding < entry_point.referenced_storages.size(); ++binding)
+			storage_bindings.emplace(entry_point.referenced_storages[binding], binding);
+
 		// All annotation instructions
-		for (spirv_instruction inst : _annotations.instructions)
+		for (const spirv_instruction &inst : _annotations.instructions)
 		{
 			if (inst.op == spv::OpDecorate)
 			{
-				// Remove all decorations targeting any of the interface variables for non-matching entry points
-				if (std::find(variables_to_remove.begin(), variables_to_remove.end(), inst.operands[0]) != variables_to_remove.end())
+				// Remove all decorations targeting any of the interface variables for non-matching entry points or values in removed functions
+				if (variables_to_remove.find(inst.operands[0]) != variables_to_remove.end())
 					continue;
 
 				// Replace bindings
 				if (inst.operands[1] == spv::DecorationBinding)
 				{
-					if (const auto referenced_sampler_it = std::find(entry_point->referenced_samplers.begin(), entry_point->referenced_samplers.end(), inst.operands[0]);
-						referenced_sampler_it != entry_point->referenced_samplers.end())
-						inst.operands[2] = static_cast<uint32_t>(referenced_sampler_it - entry_point->referenced_samplers.begin());
+					spirv_instruction binding_inst = inst;
+
+					if (const auto referenced_sampler_it = sampler_bindings.find(inst.operands[0]);
+						referenced_sampler_it != sampler_bindings.end())
+						binding_inst.operands[2] = referenced_sampler_it->second;
 					else
-					if (const auto referenced_storage_it = std::find(entry_point->referenced_storages.begin(), entry_point->referenced_storages.end(), inst.operands[0]);
-						referenced_storage_it != entry_point->referenced_storages.end())
-						inst.operands[2] = static_cast<uint32_t>(referenced_storage_it - entry_point->referenced_storages.begin());
+					if (const auto referenced_storage_it = storage_bindings.find(inst.operands[0]);
+						referenced_storage_it != storage_bindings.end())
+						binding_inst.operands[2] = referenced_storage_it->second;
+
+					binding_inst.write(spirv);
+					continue;
 				}
 			}
 
 			inst.write(spirv);
 		}
 
-		finalize_type_and_constants_section(spirv);
+		spirv += sections.types_and_constants;
 
 		for (const spirv_instruction &inst : _variables.instructions)
 		{
 			// Remove all declarations of the interface variables for non-matching entry points
-			if (inst.op == spv::OpVariable && std::find(variables_to_remove.begin(), variables_to_remove.end(), inst.result) != variables_to_remove.end())
+			if (inst.op == spv::OpVariable && variables_to_remove.find(inst.result) != variables_to_remove.end())
 				continue;
 
 			inst.write(spirv);
@@ -482,18 +591,16 @@ private:
 			assert(function.declaration.instructions[function.declaration.instructions[0].op != spv::OpFunction ? 1 : 0].op == spv::OpFunction);
 			const spv::Id definition = function.declaration.instructions[function.declaration.instructions[0].op != spv::OpFunction ? 1 : 0].result;
 
-			if (std::find(functions_to_remove.begin(), functions_to_remove.end(), definition) != functions_to_remove.end())
+			if (functions_to_remove.find(definition) != functions_to_remove.end())
 				continue;
 
-			for (const spirv_instruction &inst : function.declaration.instructions)
-				inst.write(spirv);
+			function.declaration.write(spirv);
 
 			// Grab first label and move it in front of variable declarations
 			function.definition.instructions.front().write(spirv);
 			assert(function.definition.instructions.front().op == spv::OpLabel);
 
-			for (const spirv_instruction &inst : function.variables.instructions)
-				inst.write(spirv);
+			function.variables.write(spirv);
 			for (auto inst_it = function.definition.instructions.begin() + 1; inst_it != function.definition.instructions.end(); ++inst_it)
 				inst_it->write(spirv);
 		}
@@ -501,6 +608,599 @@ private:
 		return spirv;
 	}
 
+	void optimize_code() override
+	{
+		// Reverse lookup of constant definitions, so that instructions operating on constants can be evaluated
+		std::unordered_map<spv::Id, const std::pair<type, constant> *> constants;
+		for (const auto &[key, id] : _constant_lookup)
+			constants.emplace(id, &key);
+
+		std::unordered_set<spv::Id> removed_ids;
+
+		for (function_blocks &func : _functions_blocks)
+		{
+			if (func.definition.instructions.empty())
+				continue;
+
+			optimize_function(func, constants, removed_ids);
+		}
+
+		// Remove constants that are no longer used, like the operands of folded operations
+		std::vector<uint32_t> use_counts(_next_id);
+		const auto count_uses = [&use_counts](const spirv_basic_block &block) {
+			for (const spirv_instruction &inst : block.instructions)
+				if (inst.op != spv::OpName && inst.op != spv::OpMemberName && inst.op != spv::OpDecorate && inst.op != spv::OpMemberDecorate)
+					for (const spv::Id operand : inst.operands)
+						if (operand < use_counts.size())
+							use_counts[operand]++; // This counts literals too, which at worst keeps a constant that is not actually used
+		};
+
+		count_uses(_entries);
+		count_uses(_execution_modes);
+		count_uses(_types_and_constants);
+		count_uses(_variables);
+		for (const function_blocks &func : _functions_blocks)
+		{
+			count_uses(func.declaration);
+			count_uses(func.variables);
+			count_uses(func.definition);
+		}
+
+		// Composite constants are always defined after their elements, so going backwards removes elements that were only used by removed composites as well
+		for (auto inst_it = _types_and_constants.instructions.rbegin(); inst_it != _types_and_constants.instructions.rend(); ++inst_it)
+		{
+			if (inst_it->op != spv::OpConstant && inst_it->op != spv::OpConstantComposite && inst_it->op != spv::OpConstantTrue && inst_it->op != spv::OpConstantFalse && inst_it->op != spv::OpConstantNull)
+				continue;
+
+			if (use_counts[inst_it->result] != 0)
+				continue;
+
+			removed_ids.insert(inst_it->result);
+
+			if (inst_it->op == spv::OpConstantComposite)
+				for (const spv::Id element : inst_it->operands)
+					use_counts[element]--;
+		}
+
+		if (removed_ids.empty())
+			return;
+
+		_types_and_constants.instructions.erase(std::remove_if(_types_and_constants.instructions.begin(), _types_and_constants.instructions.end(),
+			[&removed_ids](const spirv_instruction &inst) { return inst.result != 0 && removed_ids.find(inst.result) != removed_ids.end(); }),
+			_types_and_constants.instructions.end());
+
+		for (auto it = _constant_lookup.begin(); it != _constant_lookup.end();)
+		{
+			if (removed_ids.find(it->second) != removed_ids.end())
+				it = _constant_lookup.erase(it);
+			else
+				++it;
+		}
+
+		// Remove all names and decorations of values that no longer exist
+		const auto targets_removed_id = [&removed_ids](const spirv_instruction &inst) {
+			return (inst.op == spv::OpName || inst.op == spv::OpMemberName || inst.op == spv::OpDecorate || inst.op == spv::OpMemberDecorate) &&
+				removed_ids.find(inst.operands[0]) != removed_ids.end();
+		};
+
+		_debug_b.instructions.erase(std::remove_if(_debug_b.instructions.begin(), _debug_b.instructions.end(), targets_removed_id), _debug_b.instructions.end());
+		_annotations.instructions.erase(std::remove_if(_annotations.instructions.begin(), _annotations.instructions.end(), targets_removed_id), _annotations.instructions.end());
+	}
+
+	/// <summary>
+	/// Forwards values of local variables that are only ever assigned once to their loads, folds operations on constants and removes all instructions whose result ends up unused.
+	/// </summary>
+	void optimize_function(function_blocks &func, std::unordered_map<spv::Id, const std::pair<type, constant> *> &constants, std::unordered_set<spv::Id> &removed_ids)
+	{
+		std::vector<spirv_instruction> &instructions = func.definition.instructions;
+		std::vector<bool> removed(instructions.size(), false);
+
+		// IDs of values defined in a function are allocated together, so they can index flat arrays instead of hash maps
+		spv::Id min_id = std::numeric_limits<spv::Id>::max(), max_id = 0;
+		for (const spirv_basic_block *block : { &func.variables, &func.definition })
+		{
+			for (const spirv_instruction &inst : block->instructions)
+			{
+				if (inst.result == 0)
+					continue;
+				min_id = std::min(min_id, inst.result);
+				max_id = std::max(max_id, inst.result);
+			}
+		}
+		if (min_id > max_id)
+			return;
+		const auto is_local_id = [min_id, max_id](spv::Id id) { return id >= min_id && id <= max_id; };
+
+		// Values that replace the result of removed instructions
+		std::vector<spv::Id> replacements(max_id - min_id + 1);
+		const auto resolve = [&](spv::Id id) {
+			while (is_local_id(id) && replacements[id - min_id] != 0)
+				id = replacements[id - min_id];
+			return id;
+		};
+
+		struct local_variable
+		{
+			spv::Id value = 0;
+			size_t num_stores = 0;
+			bool escapes = false;
+		};
+		std::unordered_map<spv::Id, local_variable> local_variables;
+		for (const spirv_instruction &inst : func.variables.instructions)
+		{
+			if (inst.op != spv::OpVariable)
+				continue;
+
+			local_variable &variable = local_variables[inst.result];
+			// An initializer counts as a store before everything else
+			if (inst.operands.size() > 1)
+			{
+				variable.value = inst.operands[1];
+				variable.num_stores++;
+			}
+		}
+
+		// Find local variables that are only ever loaded from and stored to directly, and those of them that are assigned exactly once in the entry block (which dominates all others)
+		for (size_t i = 0, num_labels = 0; i < instructions.size(); ++i)
+		{
+			const spirv_instruction &inst = instructions[i];
+
+			if (inst.op == spv::OpLabel)
+				num_labels++;
+
+			for (size_t k = 0; k < inst.operands.size(); ++k)
+			{
+				const auto it = local_variables.find(inst.operands[k]);
+				if (it == local_variables.end() || is_literal_operand(inst, k))
+					continue;
+
+				local_variable &variable = it->second;
+
+				if (inst.op == spv::OpStore && k == 0)
+				{
+					variable.value = inst.operands[1];
+					// Stores outside the entry block may not be executed, or executed multiple times
+					variable.num_stores += (num_labels == 1) ? 1 : 2;
+				}
+				else if (inst.op == spv::OpLoad && k == 0)
+				{
+					// Loading before the store reads an undefined value, so cannot forward the stored value to all loads
+					if (variable.num_stores == 0)
+						variable.num_stores = 2;
+				}
+				else
+				{
+					// Any other use (like an access chain or passing the pointer to a function) may read or modify the variable in ways that are not tracked here
+					variable.escapes = true;
+				}
+			}
+		}
+
+		// Forward stored values to loads, either from the single store in the entry block, or from the last store in the same basic block
+		std::unordered_map<spv::Id, spv::Id> block_values;
+		for (size_t i = 0; i < instructions.size(); ++i)
+		{
+			const spirv_instruction &inst = instructions[i];
+
+			if (inst.op == spv::OpLabel)
+			{
+				block_values.clear();
+			}
+			else if (inst.op == spv::OpStore)
+			{
+				if (const auto it = local_variables.find(inst.operands[0]);
+					it != local_variables.end() && !it->second.escapes)
+					block_values[inst.operands[0]] = inst.operands[1];
+			}
+			else if (inst.op == spv::OpLoad)
+			{
+				if (const auto it = local_variables.find(inst.operands[0]);
+					it != local_variables.end() && !it->second.escapes)
+				{
+					spv::Id value = 0;
+					if (it->second.num_stores == 1)
+						value = it->second.value;
+					else if (const auto value_it = block_values.find(inst.operands[0]);
+						value_it != block_values.end())
+						value = value_it->second;
+
+					if (value != 0)
+					{
+						replacements[inst.result - min_id] = value;
+						removed[i] = true;
+						removed_ids.insert(inst.result);
+					}
+				}
+			}
+		}
+
+		// Substitute forwarded values and fold operations on constants (values are always defined before they are used in the instruction stream, except for phi nodes)
+		constant_pool pool;
+		for (size_t i = 0; i < instructions.size(); ++i)
+		{
+			if (removed[i])
+				continue;
+
+			spirv_instruction &inst = instructions[i];
+
+			for (size_t k = 0; k < inst.operands.size(); ++k)
+				if (!is_literal_operand(inst, k))
+					inst.operands[k] = resolve(inst.operands[k]);
+
+			if (const spv::Id folded = fold_constant_operation(inst, constants, pool); folded != 0)
+			{
+				replacements[inst.result - min_id] = folded;
+				removed[i] = true;
+				removed_ids.insert(inst.result);
+			}
+		}
+
+		// Phi nodes can reference values that are defined later in the instruction stream, so substitute those again
+		for (size_t i = 0; i < instructions.size(); ++i)
+		{
+			spirv_instruction &inst = instructions[i];
+
+			if (!removed[i] && inst.op == spv::OpPhi)
+				for (size_t k = 0; k < inst.operands.size(); k += 2)
+					inst.operands[k] = resolve(inst.operands[k]);
+		}
+
+		// Count uses of all values defined in this function, with stores to local variables not counting as a use of the variable (since nothing reads the stored value if there are no loads)
+		std::vector<uint32_t> use_counts(max_id - min_id + 1);
+		std::vector<size_t> definitions(max_id - min_id + 1, std::numeric_limits<size_t>::max());
+		std::unordered_map<spv::Id, std::vector<size_t>> stores;
+		for (size_t i = 0; i < instructions.size(); ++i)
+		{
+			if (removed[i])
+				continue;
+
+			const spirv_instruction &inst = instructions[i];
+
+			if (inst.result != 0)
+				definitions[inst.result - min_id] = i;
+
+			for (size_t k = 0; k < inst.operands.size(); ++k)
+			{
+				if (is_literal_operand(inst, k) || !is_local_id(inst.operands[k]))
+					continue;
+
+				if (inst.op == spv::OpStore && k == 0 && local_variables.find(inst.operands[0]) != local_variables.end())
+					stores[inst.operands[0]].push_back(i);
+				else
+					use_counts[inst.operands[k] - min_id]++;
+			}
+		}
+
+		// Remove unused instructions, which in turn may leave the values they used unused as well
+		std::vector<size_t> worklist;
+		const auto remove_variable = [&](spv::Id variable) {
+			removed_ids.insert(variable);
+			local_variables.erase(variable);
+			for (const size_t store_index : stores[variable])
+				worklist.push_back(store_index);
+		};
+		const auto release_use = [&](spv::Id id) {
+			if (!is_local_id(id) || --use_counts[id - min_id] != 0)
+				return;
+
+			if (local_variables.find(id) != local_variables.end())
+				remove_variable(id);
+			else if (const size_t definition = definitions[id - min_id];
+				definition != std::numeric_limits<size_t>::max() && is_pure_instruction(instructions[definition].op))
+				worklist.push_back(definition);
+		};
+
+		for (size_t i = 0; i < instructions.size(); ++i)
+			if (!removed[i] && instructions[i].result != 0 && is_pure_instruction(instructions[i].op) && use_counts[instructions[i].result - min_id] == 0)
+				worklist.push_back(i);
+
+		std::vector<spv::Id> unused_variables;
+		for (const auto &[variable, info] : local_variables)
+			if (use_counts[variable - min_id] == 0)
+				unused_variables.push_back(variable);
+		for (const spv::Id variable : unused_variables)
+			remove_variable(variable);
+
+		while (!worklist.empty())
+		{
+			const size_t index = worklist.back();
+			worklist.pop_back();
+
+			if (removed[index])
+				continue;
+			removed[index] = true;
+
+			const spirv_instruction &inst = instructions[index];
+
+			if (inst.result != 0)
+				removed_ids.insert(inst.result);
+
+			for (size_t k = 0; k < inst.operands.size(); ++k)
+			{
+				// Stores to local variables were not counted as a use of the variable
+				if (is_literal_operand(inst, k) || (inst.op == spv::OpStore && k == 0))
+					continue;
+
+				release_use(inst.operands[k]);
+			}
+		}
+
+		size_t write_index = 0;
+		for (size_t i = 0; i < instructions.size(); ++i)
+			if (!removed[i] && write_index++ != i)
+				instructions[write_index - 1] = std::move(instructions[i]);
+		instructions.erase(instructions.begin() + write_index, instructions.end());
+
+		// Remove declarations of local variables that are no longer used
+		func.variables.instructions.erase(std::remove_if(func.variables.instructions.begin(), func.variables.instructions.end(),
+			[&removed_ids](const spirv_instruction &inst) { return inst.op == spv::OpVariable && removed_ids.find(inst.result) != removed_ids.end(); }),
+			func.variables.instructions.end());
+	}
+
+	/// <summary>
+	/// Evaluates an arithmetic, logical or comparison instruction if all its operands are constants.
+	/// </summary>
+	/// <returns>SSA ID of the constant that holds the result, or zero if the instruction cannot be folded.</returns>
+	spv::Id fold_constant_operation(const spirv_instruction &inst, std::unordered_map<spv::Id, const std::pair<type, constant> *> &constants, constant_pool &pool)
+	{
+		tokenid op = tokenid::unknown;
+		switch (inst.op)
+		{
+		case spv::OpFNegate:
+		case spv::OpSNegate:
+		case spv::OpFSub:
+		case spv::OpISub:
+			op = tokenid::minus;
+			break;
+		case spv::OpNot:
+			op = tokenid::tilde;
+			break;
+		case spv::OpLogicalNot:
+			op = tokenid::exclaim;
+			break;
+		case spv::OpFAdd:
+		case spv::OpIAdd:
+			op = tokenid::plus;
+			break;
+		case spv::OpFMul:
+		case spv::OpIMul:
+			op = tokenid::star;
+			break;
+		case spv::OpFDiv:
+		case spv::OpSDiv:
+		case spv::OpUDiv:
+			op = tokenid::slash;
+			break;
+		case spv::OpFRem:
+		case spv::OpSRem:
+		case spv::OpUMod:
+			op = tokenid::percent;
+			break;
+		case spv::OpBitwiseAnd:
+			op = tokenid::ampersand;
+			break;
+		case spv::OpBitwiseOr:
+			op = tokenid::pipe;
+			break;
+		case spv::OpBitwiseXor:
+			op = tokenid::caret;
+			break;
+		case spv::OpLogicalAnd:
+			op = tokenid::ampersand_ampersand;
+			break;
+		case spv::OpLogicalOr:
+			op = tokenid::pipe_pipe;
+			break;
+		case spv::OpFOrdLessThan:
+		case spv::OpSLessThan:
+		case spv::OpULessThan:
+			op = tokenid::less;
+			break;
+		case spv::OpFOrdLessThanEqual:
+		case spv::OpSLessThanEqual:
+		case spv::OpULessThanEqual:
+			op = tokenid::less_equal;
+			break;
+		case spv::OpFOrdGreaterThan:
+		case spv::OpSGreaterThan:
+		case spv::OpUGreaterThan:
+			op = tokenid::greater;
+			break;
+		case spv::OpFOrdGreaterThanEqual:
+		case spv::OpSGreaterThanEqual:
+		case spv::OpUGreaterThanEqual:
+			op = tokenid::greater_equal;
+			break;
+		case spv::OpFOrdEqual:
+		case spv::OpIEqual:
+		case spv::OpLogicalEqual:
+			op = tokenid::equal_equal;
+			break;
+		case spv::OpINotEqual:
+		case spv::OpLogicalNotEqual:
+			op = tokenid::exclaim_equal;
+			break;
+		default:
+			// Shifts are not folded, since shifting by the bit width or more is undefined, and an ordered not-equal comparison differs from the C++ one for NaN
+			return 0;
+		}
+
+		const auto lhs_it = constants.find(inst.operands[0]);
+		if (lhs_it == constants.end())
+			return 0;
+		const auto &[lhs_type, lhs_data] = *lhs_it->second;
+
+		if (lhs_type.is_array() || !lhs_type.is_numeric())
+			return 0;
+
+		expression exp;
+		exp.reset_to_rvalue_constant({}, pool, lhs_data, lhs_type);
+
+		if (inst.operands.size() == 1)
+		{
+			if (!exp.evaluate_constant_expression(op))
+				return 0;
+		}
+		else
+		{
+			const auto rhs_it = constants.find(inst.operands[1]);
+			if (rhs_it == constants.end() || rhs_it->second->first != lhs_type)
+				return 0;
+
+			if (!exp.evaluate_constant_expression(op, rhs_it->second->second))
+				return 0;
+		}
+
+		// Only replace the instruction if the evaluated type matches the result type the instruction had
+		if (convert_type(exp.type) != inst.type)
+			return 0;
+
+		const spv::Id result = emit_constant(exp.type, exp.constant(), false);
+		if (const auto it = _constant_lookup.find(std::make_pair(exp.type, exp.constant()));
+			it != _constant_lookup.end())
+			constants.emplace(result, &it->first);
+
+		return result;
+	}
+
+	/// <summary>
+	/// Checks whether the operand at the specified index of an instruction is a literal number instead of an SSA ID.
+	/// </summary>
+	static bool is_literal_operand(const spirv_instruction &inst, size_t index)
+	{
+		switch (inst.op)
+		{
+		case spv::OpVariable:
+			return index == 0; // Storage class
+		case spv::OpExtInst:
+			return index == 1; // Instruction number in the extended instruction set
+		case spv::OpLine:
+		case spv::OpSelectionMerge:
+		case spv::OpCompositeExtract:
+			return index >= 1; // Line and column, selection control or indices
+		case spv::OpLoopMerge:
+		case spv::OpCompositeInsert:
+		case spv::OpVectorShuffle:
+			return index >= 2; // Loop control, indices or components
+		case spv::OpBranchConditional:
+			return index >= 3; // Branch weights
+		case spv::OpSwitch:
+			return index >= 2 && (index % 2) == 0; // Case literals
+		case spv::OpImageSampleImplicitLod:
+		case spv::OpImageSampleExplicitLod:
+		case spv::OpImageFetch:
+		case spv::OpImageRead:
+			return index == 2; // Image operands mask
+		case spv::OpImageGather:
+		case spv::OpImageWrite:
+			return index == 3; // Image operands mask
+		default:
+			return false;
+		}
+	}
+	/// <summary>
+	/// Checks whether an instruction has no effect besides producing its result, so that it can be removed if that result is not used.
+	/// </summary>
+	static bool is_pure_instruction(spv::Op op)
+	{
+		switch (op)
+		{
+		case spv::OpUndef:
+		case spv::OpLoad:
+		case spv::OpAccessChain:
+		case spv::OpImageTexelPointer:
+		case spv::OpPhi:
+		case spv::OpExtInst:
+		case spv::OpVectorExtractDynamic:
+		case spv::OpVectorShuffle:
+		case spv::OpCompositeConstruct:
+		case spv::OpCompositeExtract:
+		case spv::OpCompositeInsert:
+		case spv::OpTranspose:
+		case spv::OpImage:
+		case spv::OpImageSampleImplicitLod:
+		case spv::OpImageSampleExplicitLod:
+		case spv::OpImageFetch:
+		case spv::OpImageGather:
+		case spv::OpImageRead:
+		case spv::OpImageQuerySize:
+		case spv::OpImageQuerySizeLod:
+		case spv::OpConvertFToU:
+		case spv::OpConvertFToS:
+		case spv::OpConvertSToF:
+		case spv::OpConvertUToF:
+		case spv::OpUConvert:
+		case spv::OpSConvert:
+		case spv::OpFConvert:
+		case spv::OpBitcast:
+		case spv::OpSNegate:
+		case spv::OpFNegate:
+		case spv::OpIAdd:
+		case spv::OpFAdd:
+		case spv::OpISub:
+		case spv::OpFSub:
+		case spv::OpIMul:
+		case spv::OpFMul:
+		case spv::OpUDiv:
+		case spv::OpSDiv:
+		case spv::OpFDiv:
+		case spv::OpUMod:
+		case spv::OpSRem:
+		case spv::OpFRem:
+		case spv::OpVectorTimesScalar:
+		case spv::OpMatrixTimesScalar:
+		case spv::OpVectorTimesMatrix:
+		case spv::OpMatrixTimesVector:
+		case spv::OpMatrixTimesMatrix:
+		case spv::OpDot:
+		case spv::OpAny:
+		case spv::OpAll:
+		case spv::OpIsNan:
+		case spv::OpIsInf:
+		case spv::OpLogicalEqual:
+		case spv::OpLogicalNotEqual:
+		case spv::OpLogicalOr:
+		case spv::OpLogicalAnd:
+		case spv::OpLogicalNot:
+		case spv::OpSelect:
+		case spv::OpIEqual:
+		case spv::OpINotEqual:
+		case spv::OpUGreaterThan:
+		case spv::OpSGreaterThan:
+		case spv::OpUGreaterThanEqual:
+		case spv::OpSGreaterThanEqual:
+		case spv::OpULessThan:
+		case spv::OpSLessThan:
+		case spv::OpULessThanEqual:
+		case spv::OpSLessThanEqual:
+		case spv::OpFOrdEqual:
+		case spv::OpFOrdNotEqual:
+		case spv::OpFOrdLessThan:
+		case spv::OpFOrdGreaterThan:
+		case spv::OpFOrdLessThanEqual:
+		case spv::OpFOrdGreaterThanEqual:
+		case spv::OpShiftRightLogical:
+		case spv::OpShiftRightArithmetic:
+		case spv::OpShiftLeftLogical:
+		case spv::OpBitwiseOr:
+		case spv::OpBitwiseXor:
+		case spv::OpBitwiseAnd:
+		case spv::OpNot:
+		case spv::OpBitReverse:
+		case spv::OpBitCount:
+		case spv::OpDPdx:
+		case spv::OpDPdy:
+		case spv::OpFwidth:
+		case spv::OpDPdxFine:
+		case spv::OpDPdyFine:
+		case spv::OpDPdxCoarse:
+		case spv::OpDPdyCoarse:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	spv::Id convert_type(type info, bool is_ptr = false, spv::StorageClass storage = spv::StorageClassFunction, spv::ImageFormat format = spv::ImageFormatUnknown, uint32_t array_stride = 0)
 	{
 		assert(array_stride == 0 || info.is_array());
@@ -523,8 +1223,7 @@ private:
 
 		const type_lookup lookup { info, is_ptr, array_stride, { storage, format } };
 
-		if (const auto lookup_it = std::find_if(_type_lookup.begin(), _type_lookup.end(),
-				[&lookup](const std::pair<type_lookup, spv::Id> &lookup_entry) { return lookup_entry.first == lookup; });
+		if (const auto lookup_it = _type_lookup.find(lookup);
 			lookup_it != _type_lookup.end())
 			return lookup_it->second;
 
@@ -689,14 +1388,18 @@ private:
 			}
 		}
 
-		_type_lookup.push_back({ lookup, type_id });
+		_type_lookup.emplace(lookup, type_id);
 
 		return type_id;
 	}
 	spv::Id convert_type(const function_blocks &info)
 	{
-		if (const auto lookup_it = std::find_if(_function_type_lookup.begin(), _function_type_lookup.end(),
-				[&lookup = info](const std::pair<function_blocks, spv::Id> &lookup_entry) { return lookup_entry.first == lookup; });
+		std::vector<type> lookup;
+		lookup.reserve(1 + info.param_types.size());
+		lookup.push_back(info.return_type);
+		lookup.insert(lookup.end(), info.param_types.begin(), info.param_types.end());
+
+		if (const auto lookup_it = _function_type_lookup.find(lookup);
 			lookup_it != _function_type_lookup.end())
 			return lookup_it->second;
 
@@ -712,7 +1415,7 @@ private:
 			.add(return_type_id)
 			.add(param_type_ids.begin(), param_type_ids.end());
 
-		_function_type_lookup.push_back({ info, inst });
+		_function_type_lookup.emplace(std::move(lookup), inst);
 
 		return inst;
 	}
@@ -740,8 +1443,7 @@ private:
 			lookup.type.struct_definition = static_cast<uint32_t>(elem_info.base);
 		}
 
-		if (const auto lookup_it = std::find_if(_type_lookup.begin(), _type_lookup.end(),
-				[&lookup](const std::pair<type_lookup, spv::Id> &lookup_entry) { return lookup_entry.first == lookup; });
+		if (const auto lookup_it = _type_lookup.find(lookup);
 			lookup_it != _type_lookup.end())
 			return lookup_it->second;
 
@@ -756,7 +1458,7 @@ private:
 				.add(info.is_storage() ? 2 : 1) // Used with a sampler or as storage
 				.add(format);
 
-		_type_lookup.push_back({ lookup, type_id });
+		_type_lookup.emplace(lookup, type_id);
 
 		return type_id;
 	}
@@ -1570,7 +2272,7 @@ private:
 	id   emit_load(const expression &exp, bool) override
 	{
 		if (exp.is_constant) // Constant expressions do not have a complex access chain
-			return emit_constant(exp.type, exp.constant);
+			return emit_constant(exp.type, exp.constant());
 
 		size_t i = 0;
 		spv::Id result = exp.base;
@@ -1978,17 +2680,9 @@ private:
 	{
 		if (!spec_constant) // Specialization constants cannot reuse other constants
 		{
-			if (const auto it = std::find_if(_constant_lookup.begin(), _constant_lookup.end(),
-					[&data_type, &data](std::tuple<type, constant, spv::Id> &x) {
-						if (!(std::get<0>(x) == data_type && std::memcmp(&std::get<1>(x).as_uint[0], &data.as_uint[0], sizeof(uint32_t) * 16) == 0 && std::get<1>(x).array_data.size() == data.array_data.size()))
-							return false;
-						for (size_t i = 0; i < data.array_data.size(); ++i)
-							if (std::memcmp(&std::get<1>(x).array_data[i].as_uint[0], &data.array_data[i].as_uint[0], sizeof(uint32_t) * 16) != 0)
-								return false;
-						return true;
-					});
+			if (const auto it = _constant_lookup.find(std::make_pair(data_type, data));
 				it != _constant_lookup.end())
-				return std::get<2>(*it); // Reuse existing constant instead of duplicating the definition
+				return it->second; // Reuse existing constant instead of duplicating the definition
 		}
 
 		spv::Id result;
@@ -2068,7 +2762,7 @@ private:
 		if (spec_constant) // Keep track of all specialization constants
 			_spec_constants.insert(result);
 		else
-			_constant_lookup.push_back({ data_type, data, result });
+			_constant_lookup.emplace(std::make_pair(data_type, data), result);
 
 		return result;
 	}
@@ -2335,7 +3029,7 @@ private:
 		_current_block_data->instructions.pop_back();
 
 		// Add previous block containing the condition value first
-		_current_block_data->append(_block_data[condition_block]);
+		_current_block_data->append(std::move(_block_data[condition_block]));
 
 		spirv_instruction branch_inst = _current_block_data->instructions.back();
 		assert(branch_inst.op == spv::OpBranchConditional);
@@ -2349,8 +3043,8 @@ private:
 
 		// Append all blocks belonging to the branch
 		_current_block_data->instructions.push_back(branch_inst);
-		_current_block_data->append(_block_data[true_statement_block]);
-		_current_block_data->append(_block_data[false_statement_block]);
+		_current_block_data->append(std::move(_block_data[true_statement_block]));
+		_current_block_data->append(std::move(_block_data[false_statement_block]));
 
 		_current_block_data->instructions.push_back(merge_label);
 	}
@@ -2361,12 +3055,12 @@ private:
 		_current_block_data->instructions.pop_back();
 
 		// Add previous block containing the condition value first
-		_current_block_data->append(_block_data[condition_block]);
+		_current_block_data->append(std::move(_block_data[condition_block]));
 
 		if (true_statement_block != condition_block)
-			_current_block_data->append(_block_data[true_statement_block]);
+			_current_block_data->append(std::move(_block_data[true_statement_block]));
 		if (false_statement_block != condition_block)
-			_current_block_data->append(_block_data[false_statement_block]);
+			_current_block_data->append(std::move(_block_data[false_statement_block]));
 
 		_current_block_data->instructions.push_back(merge_label);
 
@@ -2388,7 +3082,7 @@ private:
 		_current_block_data->instructions.pop_back();
 
 		// Add previous block first
-		_current_block_data->append(_block_data[prev_block]);
+		_current_block_data->append(std::move(_block_data[prev_block]));
 
 		// Fill header block
 		assert(_block_data[header_block].instructions.size() == 2);
@@ -2407,11 +3101,11 @@ private:
 
 		// Add condition block if it exists
 		if (condition_block != 0)
-			_current_block_data->append(_block_data[condition_block]);
+			_current_block_data->append(std::move(_block_data[condition_block]));
 
 		// Append loop body block before continue block
-		_current_block_data->append(_block_data[loop_block]);
-		_current_block_data->append(_block_data[continue_block]);
+		_current_block_data->append(std::move(_block_data[loop_block]));
+		_current_block_data->append(std::move(_block_data[continue_block]));
 
 		_current_block_data->instructions.push_back(merge_label);
 	}
@@ -2424,7 +3118,7 @@ private:
 		_current_block_data->instructions.pop_back();
 
 		// Add previous block containing the selector value first
-		_current_block_data->append(_block_data[selector_block]);
+		_current_block_data->append(std::move(_block_data[selector_block]));
 
 		spirv_instruction switch_inst = _current_block_data->instructions.back();
 		assert(switch_inst.op == spv::OpSwitch);
@@ -2450,7 +3144,7 @@ private:
 		std::sort(blocks.begin(), blocks.end());
 		blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
 		for (const id case_block : blocks)
-			_current_block_data->append(_block_data[case_block]);
+			_current_block_data->append(std::move(_block_data[case_block]));
 
 		_current_block_data->instructions.push_back(merge_label);
 	}
@@ -2554,7 +3248,7 @@ private:
 	{
 		assert(is_in_function()); // Can only leave if there was a function to begin with
 
-		_current_function_blocks->definition = _block_data[_last_block];
+		_current_function_blocks->definition = std::move(_block_data[_last_block]);
 
 		// Append function end instruction
 		add_instruction_without_result(spv::OpFunctionEnd, _current_function_blocks->definition);
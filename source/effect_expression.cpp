@@ -7,7 +7,7 @@
 #include <cmath> // std::fmod
 #include <cassert>
 #include <cstring> // std::memcpy, std::memset
-#include <algorithm> // std::max, std::min
+#include <algorithm> // std::copy_n, std::max, std::min
 
 reshadefx::type reshadefx::type::merge(const type &lhs, const type &rhs)
 {
@@ -168,6 +168,91 @@ std::string reshadefx::type::description() const
 	return result;
 }
 
+reshadefx::constant &reshadefx::constant_pool::add(reshadefx::constant value)
+{
+	if (_next_index_in_block == block_size)
+	{
+		_current_block++;
+		_next_index_in_block = 0;
+	}
+
+	if (_current_block == _blocks.size())
+		_blocks.push_back(std::make_unique<reshadefx::constant[]>(block_size));
+
+	reshadefx::constant &result = _blocks[_current_block][_next_index_in_block++];
+	result = std::move(value);
+	return result;
+}
+
+reshadefx::expression::operation_chain::operation_chain(const operation_chain &other)
+{
+	operator=(other);
+}
+reshadefx::expression::operation_chain::operation_chain(operation_chain &&other) noexcept
+{
+	operator=(std::move(other));
+}
+reshadefx::expression::operation_chain::~operation_chain()
+{
+	if (_data != _inline_data)
+		delete[] _data;
+}
+
+reshadefx::expression::operation_chain &reshadefx::expression::operation_chain::operator=(const operation_chain &other)
+{
+	if (this == &other)
+		return *this;
+
+	_size = 0;
+	if (other._size > _capacity)
+		reserve(other._size);
+
+	std::copy_n(other._data, other._size, _data);
+	_size = other._size;
+
+	return *this;
+}
+reshadefx::expression::operation_chain &reshadefx::expression::operation_chain::operator=(operation_chain &&other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	if (other._data != other._inline_data)
+	{
+		// Take over the heap allocation of the other chain instead of copying it
+		if (_data != _inline_data)
+			delete[] _data;
+
+		_data = other._data;
+		_capacity = other._capacity;
+
+		other._data = other._inline_data;
+		other._capacity = inline_capacity;
+	}
+	else
+	{
+		// Keep any existing heap allocation around, since it is large enough to hold the inline operations too
+		std::copy_n(other._data, other._size, _data);
+	}
+
+	_size = other._size;
+	other._size = 0;
+
+	return *this;
+}
+
+void reshadefx::expression::operation_chain::reserve(uint32_t capacity)
+{
+	operation *const data = new operation[capacity];
+	std::copy_n(_data, _size, data);
+
+	if (_data != _inline_data)
+		delete[] _data;
+
+	_data = data;
+	_capacity = capacity;
+}
+
 void reshadefx::expression::reset_to_lvalue(const reshadefx::location &loc, uint32_t in_base, const reshadefx::type &in_type)
 {
 	type = in_type;
@@ -176,6 +261,7 @@ void reshadefx::expression::reset_to_lvalue(const reshadefx::location &loc, uint
 	is_lvalue = true;
 	is_constant = false;
 	chain.clear();
+	_constant = nullptr;
 
 	// Make sure uniform l-values cannot be assigned to by making them constant
 	if (in_type.has(type::q_uniform))
@@ -193,61 +279,67 @@ void reshadefx::expression::reset_to_rvalue(const reshadefx::location &loc, uint
 	is_lvalue = false;
 	is_constant = false;
 	chain.clear();
+	_constant = nullptr;
 
 	// Strip away global variable qualifiers
 	type.qualifiers &= ~(type::q_extern | type::q_static | type::q_uniform | type::q_groupshared);
 }
 
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, bool data)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, bool data)
 {
 	type = { type::t_bool, 1, 1, type::q_const };
-	base = 0; constant = {}; constant.as_uint[0] = data;
+	reshadefx::constant &value = pool.add({}); value.as_uint[0] = data;
+	base = 0; _constant = &value; _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
 	chain.clear();
 }
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, float data)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, float data)
 {
 	type = { type::t_float, 1, 1, type::q_const };
-	base = 0; constant = {}; constant.as_float[0] = data;
+	reshadefx::constant &value = pool.add({}); value.as_float[0] = data;
+	base = 0; _constant = &value; _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
 	chain.clear();
 }
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, int32_t data)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, int32_t data)
 {
 	type = { type::t_int,  1, 1, type::q_const };
-	base = 0; constant = {}; constant.as_int[0] = data;
+	reshadefx::constant &value = pool.add({}); value.as_int[0] = data;
+	base = 0; _constant = &value; _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
 	chain.clear();
 }
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, uint32_t data)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, uint32_t data)
 {
 	type = { type::t_uint, 1, 1, type::q_const };
-	base = 0; constant = {}; constant.as_uint[0] = data;
+	reshadefx::constant &value = pool.add({}); value.as_uint[0] = data;
+	base = 0; _constant = &value; _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
 	chain.clear();
 }
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, std::string data)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, std::string data)
 {
 	type = { type::t_string, 0, 0, type::q_const };
-	base = 0; constant = {}; constant.string_data = std::move(data);
+	reshadefx::constant &value = pool.add({}); value.string_data = std::move(data);
+	base = 0; _constant = &value; _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
 	chain.clear();
 }
-void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant data, const reshadefx::type &in_type)
+void reshadefx::expression::reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, reshadefx::constant data, const reshadefx::type &in_type)
 {
 	type = in_type;
 	type.qualifiers |= type::q_const;
-	base = 0; constant = std::move(data);
+	base = 0; _constant = &pool.add(std::move(data)); _constant_pool = &pool;
 	location = loc;
 	is_lvalue = false;
 	is_constant = true;
@@ -293,10 +385,12 @@ void reshadefx::expression::add_cast_operation(const reshadefx::type &cast_type)
 					constant.as_float[i] = static_cast<float>(constant.as_int[i]);
 		};
 
-		for (struct constant &element : constant.array_data)
+		reshadefx::constant &value = modify_constant();
+
+		for (struct constant &element : value.array_data)
 			cast_constant(element, type, cast_type);
 
-		cast_constant(constant, type, cast_type);
+		cast_constant(value, type, cast_type);
 	}
 	else
 	{
@@ -371,16 +465,18 @@ void reshadefx::expression::add_constant_index_access(unsigned int index)
 	{
 		if (prev_type.is_array())
 		{
-			constant = constant.array_data[index];
+			_constant = &_constant_pool->add(_constant->array_data[index]);
 		}
 		else if (prev_type.is_matrix()) // Indexing into a matrix returns a row of it as a vector
 		{
+			reshadefx::constant &value = modify_constant();
 			for (unsigned int i = 0; i < prev_type.cols; ++i)
-				constant.as_uint[i] = constant.as_uint[index * prev_type.cols + i];
+				value.as_uint[i] = value.as_uint[index * prev_type.cols + i];
 		}
 		else // Indexing into a vector returns the element as a scalar
 		{
-			constant.as_uint[0] = constant.as_uint[index];
+			reshadefx::constant &value = modify_constant();
+			value.as_uint[0] = value.as_uint[index];
 		}
 	}
 	else
@@ -399,13 +495,15 @@ void reshadefx::expression::add_swizzle_access(const signed char swizzle[4], uns
 
 	if (is_constant)
 	{
-		assert(constant.array_data.empty());
+		assert(_constant->array_data.empty());
+
+		reshadefx::constant &value = modify_constant();
 
 		uint32_t data[16];
-		std::memcpy(data, &constant.as_uint[0], sizeof(data));
+		std::memcpy(data, &value.as_uint[0], sizeof(data));
 		for (unsigned int i = 0; i < length; ++i)
-			constant.as_uint[i] = data[swizzle[i]];
-		std::memset(&constant.as_uint[length], 0, sizeof(uint32_t) * (16 - length)); // Clear the rest of the constant
+			value.as_uint[i] = data[swizzle[i]];
+		std::memset(&value.as_uint[length], 0, sizeof(uint32_t) * (16 - length)); // Clear the rest of the constant
 	}
 	else if (length == 1 && prev_type.is_vector()) // Use indexing when possible since the code generation logic is simpler in SPIR-V
 	{
@@ -417,11 +515,22 @@ void reshadefx::expression::add_swizzle_access(const signed char swizzle[4], uns
 	}
 }
 
+reshadefx::constant &reshadefx::expression::modify_constant()
+{
+	assert(is_constant && _constant != nullptr && _constant_pool != nullptr);
+
+	reshadefx::constant &value = _constant_pool->add(*_constant);
+	_constant = &value;
+	return value;
+}
+
 bool reshadefx::expression::evaluate_constant_expression(reshadefx::tokenid op)
 {
 	if (!is_constant)
 		return false;
 
+	reshadefx::constant &constant = modify_constant();
+
 	switch (op)
 	{
 	case tokenid::exclaim:
@@ -452,6 +561,8 @@ bool reshadefx::expression::evaluate_constant_expression(reshadefx::tokenid op,
 	if (!is_constant)
 		return false;
 
+	reshadefx::constant &constant = modify_constant();
+
 	switch (op)
 	{
 	case tokenid::percent:
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_token.hpp"
+#include <memory>
 
 namespace reshadefx
 {
@@ -151,6 +152,38 @@ namespace reshadefx
 		std::vector<constant> array_data;
 	};
 
+	/// <summary>
+	/// Per-compilation storage for the values of constant expressions, so that expressions only need to carry a pointer to their value.
+	/// Values are not modified once they were added, which allows copies of an expression to share the same value.
+	/// </summary>
+	class constant_pool
+	{
+	public:
+		constant_pool() = default;
+		constant_pool(const constant_pool &) = delete;
+		constant_pool &operator=(const constant_pool &) = delete;
+
+		/// <summary>
+		/// Adds a new value to the pool.
+		/// </summary>
+		/// <param name="value">Constant value to add.</param>
+		/// <returns>Reference to the value in the pool, which stays valid until the pool is cleared.</returns>
+		reshadefx::constant &add(reshadefx::constant value);
+
+		/// <summary>
+		/// Removes all values from the pool, but keeps their memory around to be reused by subsequent additions.
+		/// This invalidates all references to values in the pool, so may only be called when no expression refers to them anymore.
+		/// </summary>
+		void clear() { _current_block = 0; _next_index_in_block = 0; }
+
+	private:
+		static constexpr size_t block_size = 64;
+
+		std::vector<std::unique_ptr<reshadefx::constant[]>> _blocks;
+		size_t _current_block = 0;
+		size_t _next_index_in_block = 0;
+	};
+
 	/// <summary>
 	/// Structures which keeps track of the access chain of an expression
 	/// </summary>
@@ -173,13 +206,58 @@ namespace reshadefx
 			signed char swizzle[4];
 		};
 
+		/// <summary>
+		/// List of operations in an access chain, which stores the first few inline, so that most expressions do not need a heap allocation for it.
+		/// </summary>
+		class operation_chain
+		{
+		public:
+			operation_chain() = default;
+			operation_chain(const operation_chain &other);
+			operation_chain(operation_chain &&other) noexcept;
+			~operation_chain();
+
+			operation_chain &operator=(const operation_chain &other);
+			operation_chain &operator=(operation_chain &&other) noexcept;
+
+			bool empty() const { return _size == 0; }
+			size_t size() const { return _size; }
+
+			const operation *begin() const { return _data; }
+			const operation *end() const { return _data + _size; }
+
+			const operation &operator[](size_t index) const { return _data[index]; }
+
+			void clear() { _size = 0; }
+			void push_back(const operation &op)
+			{
+				if (_size == _capacity)
+					reserve(_capacity * 2);
+				_data[_size++] = op;
+			}
+
+		private:
+			static constexpr uint32_t inline_capacity = 2;
+
+			void reserve(uint32_t capacity);
+
+			operation *_data = _inline_data;
+			uint32_t _size = 0;
+			uint32_t _capacity = inline_capacity;
+			operation _inline_data[inline_capacity];
+		};
+
 		uint32_t base = 0;
 		reshadefx::type type = {};
-		reshadefx::constant constant = {};
 		bool is_lvalue = false;
 		bool is_constant = false;
 		reshadefx::location location;
-		std::vector<operation> chain;
+		operation_chain chain;
+
+		/// <summary>
+		/// Gets the value of this constant expression, or zero if this is not a constant expression.
+		/// </summary>
+		const reshadefx::constant &constant() const { static const reshadefx::constant zero = {}; return _constant != nullptr ? *_constant : zero; }
 
 		/// <summary>
 		/// Initializes the expression to a l-value.
@@ -200,13 +278,14 @@ namespace reshadefx
 		/// Initializes the expression to a constant value.
 		/// </summary>
 		/// <param name="loc">Code location of the constant expression.</param>
+		/// <param name="pool">Pool to store the constant value in, which has to outlive the expression.</param>
 		/// <param name="data">Constant value to initialize to.</param>
-		void reset_to_rvalue_constant(const reshadefx::location &loc, bool data);
-		void reset_to_rvalue_constant(const reshadefx::location &loc, float data);
-		void reset_to_rvalue_constant(const reshadefx::location &loc, int32_t data);
-		void reset_to_rvalue_constant(const reshadefx::location &loc, uint32_t data);
-		void reset_to_rvalue_constant(const reshadefx::location &loc, std::string data);
-		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant data, const reshadefx::type &type);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, bool data);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, float data);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, int32_t data);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, uint32_t data);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, std::string data);
+		void reset_to_rvalue_constant(const reshadefx::location &loc, reshadefx::constant_pool &pool, reshadefx::constant data, const reshadefx::type &type);
 
 		/// <summary>
 		/// Adds a cast operation to the current access chain.
@@ -247,5 +326,14 @@ namespace reshadefx
 		/// <param name="op">Binary operator to apply.</param>
 		/// <param name="rhs">Constant value to use as right-hand side of the binary operation.</param>
 		bool evaluate_constant_expression(reshadefx::tokenid op, const reshadefx::constant &rhs);
+
+	private:
+		/// <summary>
+		/// Replaces the value of this constant expression with a modifiable copy, so that folding operations do not affect other expressions sharing the current value.
+		/// </summary>
+		reshadefx::constant &modify_constant();
+
+		const reshadefx::constant *_constant = nullptr;
+		reshadefx::constant_pool *_constant_pool = nullptr;
 	};
 }
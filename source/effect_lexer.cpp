@@ -4,9 +4,14 @@
  */
 
 #include "effect_lexer.hpp"
+#include <array>
 #include <cassert>
+#include <algorithm> // std::lower_bound, std::max, std::sort
 #include <string_view>
 #include <unordered_map> // Used for static lookup tables
+#include <unordered_set>
+#include <mutex>
+#include <shared_mutex>
 
 using namespace reshadefx;
 
@@ -205,7 +210,7 @@ static const std::unordered_map<tokenid, std::string_view> s_token_lookup = {
 	{ tokenid::storage2d, "storage2D" },
 	{ tokenid::storage3d, "storage3D" },
 };
-static const std::unordered_map<std::string_view, tokenid> s_keyword_lookup = {
+static constexpr std::pair<std::string_view, tokenid> s_keyword_list[] = {
 	{ "asm", tokenid::reserved },
 	{ "asm_fragment", tokenid::reserved },
 	{ "auto", tokenid::reserved },
@@ -439,6 +444,22 @@ static const std::unordered_map<std::string_view, tokenid> s_keyword_lookup = {
 	{ "volatile", tokenid::volatile_ },
 	{ "while", tokenid::while_ }
 };
+// Length of the longest keyword, so that the lookup table below has a group for every keyword and identifiers that are longer can be rejected early
+static constexpr size_t s_max_keyword_length = []() {
+	size_t max_length = 0;
+	for (const std::pair<std::string_view, tokenid> &keyword : s_keyword_list)
+		max_length = std::max(max_length, keyword.first.size());
+	return max_length;
+}();
+// Lookup table which groups keywords by their length and sorts them within each group, so that identifiers can be matched without hashing or allocating a string
+static const auto s_keyword_lookup = []() {
+	std::array<std::vector<std::pair<std::string_view, tokenid>>, s_max_keyword_length + 1> keywords_by_length;
+	for (const std::pair<std::string_view, tokenid> &keyword : s_keyword_list)
+		keywords_by_length[keyword.first.size()].push_back(keyword);
+	for (std::vector<std::pair<std::string_view, tokenid>> &keywords : keywords_by_length)
+		std::sort(keywords.begin(), keywords.end());
+	return keywords_by_length;
+}();
 static const std::unordered_map<std::string_view, tokenid> s_pp_directive_lookup = {
 	{ "define", tokenid::hash_def },
 	{ "undef", tokenid::hash_undef },
@@ -502,6 +523,72 @@ static long long octal_to_decimal(long long n)
 	return n;
 }
 
+// Table of all source file names referenced by locations, which is shared between all compilations (and cleared together with the include cache)
+static std::shared_mutex s_source_names_mutex;
+static std::unordered_set<std::string> s_source_names;
+// Number of preprocessor and parser instances that may still refer to names in the table, which is only cleared once this drops to zero
+static size_t s_source_names_users = 0;
+static bool s_source_names_clear_pending = false;
+
+void reshadefx::location::set_source(const std::string &source)
+{
+	if (source.empty())
+	{
+		_source = nullptr;
+		return;
+	}
+
+	// Avoid any table lookup when the source file did not change
+	if (_source != nullptr && *_source == source)
+		return;
+
+	{
+		const std::shared_lock<std::shared_mutex> lock(s_source_names_mutex);
+
+		if (const auto it = s_source_names.find(source); it != s_source_names.end())
+		{
+			_source = &(*it);
+			return;
+		}
+	}
+
+	const std::unique_lock<std::shared_mutex> lock(s_source_names_mutex);
+
+	// Elements of an unordered set are never moved, so the pointer stays valid
+	_source = &(*s_source_names.insert(source).first);
+}
+void reshadefx::location::clear_source_names()
+{
+	const std::unique_lock<std::shared_mutex> lock(s_source_names_mutex);
+
+	if (s_source_names_users != 0)
+	{
+		s_source_names_clear_pending = true;
+		return;
+	}
+
+	s_source_names.clear();
+	s_source_names_clear_pending = false;
+}
+void reshadefx::location::acquire_source_names()
+{
+	const std::unique_lock<std::shared_mutex> lock(s_source_names_mutex);
+
+	s_source_names_users++;
+}
+void reshadefx::location::release_source_names()
+{
+	const std::unique_lock<std::shared_mutex> lock(s_source_names_mutex);
+
+	assert(s_source_names_users != 0);
+
+	if (--s_source_names_users == 0 && s_source_names_clear_pending)
+	{
+		s_source_names.clear();
+		s_source_names_clear_pending = false;
+	}
+}
+
 std::string reshadefx::token::id_to_name(tokenid id)
 {
 	const auto it = s_token_lookup.find(id);
@@ -510,11 +597,10 @@ std::string reshadefx::token::id_to_name(tokenid id)
 	return "unknown";
 }
 
-reshadefx::token reshadefx::lexer::lex()
+void reshadefx::lexer::lex(token &tok)
 {
 	bool is_at_line_begin = _cur_location.column <= 1;
 
-	token tok;
 next_token:
 	// Reset token data
 	tok.location = _cur_location;
@@ -530,14 +616,14 @@ next_token:
 	{
 	case 0xFF: // EOF
 		tok.id = tokenid::end_of_file;
-		return tok;
+		return;
 	case SPACE:
 		skip_space();
 		if (_ignore_whitespace || is_at_line_begin || *_cur == '\n')
 			goto next_token;
 		tok.id = tokenid::space;
 		tok.length = input_offset() - tok.offset;
-		return tok;
+		return;
 	case '\n':
 		_cur++;
 		_cur_location.line++;
@@ -546,7 +632,7 @@ next_token:
 		if (_ignore_whitespace)
 			goto next_token;
 		tok.id = tokenid::end_of_line;
-		return tok;
+		return;
 	case DIGIT:
 		parse_numeric_literal(tok);
 		break;
@@ -651,7 +737,7 @@ next_token:
 				goto next_token;
 			tok.id = tokenid::single_line_comment;
 			tok.length = input_offset() - tok.offset;
-			return tok;
+			return;
 		}
 		else if (_cur[1] == '*')
 		{
@@ -673,7 +759,7 @@ next_token:
 				goto next_token;
 			tok.id = tokenid::multi_line_comment;
 			tok.length = input_offset() - tok.offset;
-			return tok;
+			return;
 		}
 		else if (_cur[1] == '=')
 			tok.id = tokenid::slash_equal,
@@ -744,7 +830,7 @@ next_token:
 				goto next_token;
 			tok.id = tokenid::space;
 			tok.length = input_offset() - tok.offset;
-			return tok;
+			return;
 		}
 		tok.id = tokenid::backslash;
 		break;
@@ -784,7 +870,7 @@ next_token:
 
 	skip(tok.length);
 
-	return tok;
+	return;
 }
 
 void reshadefx::lexer::skip(size_t length)
@@ -847,13 +933,17 @@ void reshadefx::lexer::parse_identifier(token &tok) const
 	tok.id = tokenid::identifier;
 	tok.offset = input_offset();
 	tok.length = end - begin;
+	// This reuses the existing string storage of the token when lexing into a previous token (see 'lexer::lex')
 	tok.literal_as_string.assign(begin, end);
 
-	if (_ignore_keywords)
+	if (_ignore_keywords || tok.length >= s_keyword_lookup.size())
 		return;
 
-	if (const auto it = s_keyword_lookup.find(tok.literal_as_string);
-		it != s_keyword_lookup.end())
+	const std::string_view name(begin, tok.length);
+	const std::vector<std::pair<std::string_view, tokenid>> &keywords = s_keyword_lookup[tok.length];
+	if (const auto it = std::lower_bound(keywords.begin(), keywords.end(), name,
+			[](const std::pair<std::string_view, tokenid> &keyword, std::string_view name) { return keyword.first < name; });
+		it != keywords.end() && it->first == name)
 		tok.id = it->second;
 }
 bool reshadefx::lexer::parse_pp_directive(token &tok)
@@ -889,7 +979,7 @@ bool reshadefx::lexer::parse_pp_directive(token &tok)
 			token temptok;
 			parse_string_literal(temptok, false);
 
-			_cur_location.source = std::move(temptok.literal_as_string);
+			_cur_location.set_source(temptok.literal_as_string);
 		}
 
 		// Do not return the #line directive as token to the caller
@@ -69,7 +69,13 @@ namespace reshadefx
 		/// Performs lexical analysis on the input string and return the next token in sequence.
 		/// </summary>
 		/// <returns>Next token from the input string.</returns>
-		token lex();
+		token lex() { token tok; lex(tok); return tok; }
+		/// <summary>
+		/// Performs lexical analysis on the input string and overwrites the specified <paramref name="tok"/> with the next token in sequence.
+		/// This reuses the string storage of the previous token, so that lexing does not need to allocate memory in most cases.
+		/// </summary>
+		/// <param name="tok">Token to overwrite.</param>
+		void lex(token &tok);
 
 		/// <summary>
 		/// Advances to the next token that is not whitespace.
@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "effect_module.hpp"
+#include <cstring> // std::memcpy
+
+// Identifies serialized effect modules ("RFXM")
+static constexpr uint32_t s_module_magic = 0x4D584652;
+// Has to be incremented whenever the layout of the serialized data or of the structures in 'effect_module.hpp' changes
+static constexpr uint32_t s_module_version = 1;
+
+static void write(std::string &data, uint32_t value)
+{
+	data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+static void write(std::string &data, float value)
+{
+	data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+static void write(std::string &data, bool value)
+{
+	data.push_back(value ? 1 : 0);
+}
+static void write(std::string &data, const std::string &value)
+{
+	write(data, static_cast<uint32_t>(value.size()));
+	data.append(value);
+}
+// Declare overloads for all structures up front, so that they are visible to the templates serializing arrays of them
+static void write(std::string &data, const reshadefx::type &value);
+static void write(std::string &data, const reshadefx::constant &value);
+static void write(std::string &data, const reshadefx::annotation &value);
+static void write(std::string &data, const reshadefx::texture &value);
+static void write(std::string &data, const reshadefx::sampler &value);
+static void write(std::string &data, const reshadefx::storage &value);
+static void write(std::string &data, const reshadefx::uniform &value);
+static void write(std::string &data, const reshadefx::texture_binding &value);
+static void write(std::string &data, const reshadefx::sampler_binding &value);
+static void write(std::string &data, const reshadefx::storage_binding &value);
+static void write(std::string &data, const reshadefx::pass &value);
+static void write(std::string &data, const reshadefx::technique &value);
+static void write(std::string &data, const std::pair<std::string, reshadefx::shader_type> &value);
+
+template <typename T>
+static void write(std::string &data, const std::vector<T> &values)
+{
+	write(data, static_cast<uint32_t>(values.size()));
+	for (const T &value : values)
+		write(data, value);
+}
+
+static void write(std::string &data, const reshadefx::type &value)
+{
+	write(data, static_cast<uint32_t>(value.base));
+	write(data, static_cast<uint32_t>(value.rows));
+	write(data, static_cast<uint32_t>(value.cols));
+	write(data, static_cast<uint32_t>(value.qualifiers));
+	write(data, value.array_length);
+	write(data, value.struct_definition);
+}
+static void write(std::string &data, const reshadefx::constant &value)
+{
+	for (const uint32_t element : value.as_uint)
+		write(data, element);
+	write(data, value.string_data);
+	write(data, value.array_data);
+}
+static void write(std::string &data, const reshadefx::annotation &value)
+{
+	write(data, value.type);
+	write(data, value.name);
+	write(data, value.value);
+}
+static void write(std::string &data, const reshadefx::texture &value)
+{
+	write(data, value.width);
+	write(data, value.height);
+	write(data, static_cast<uint32_t>(value.depth));
+	write(data, static_cast<uint32_t>(value.levels));
+	write(data, static_cast<uint32_t>(value.type));
+	write(data, static_cast<uint32_t>(value.format));
+	write(data, value.id);
+	write(data, value.name);
+	write(data, value.unique_name);
+	write(data, value.semantic);
+	write(data, value.annotations);
+	write(data, value.render_target);
+	write(data, value.storage_access);
+}
+static void write(std::string &data, const reshadefx::sampler &value)
+{
+	write(data, static_cast<uint32_t>(value.filter));
+	write(data, static_cast<uint32_t>(value.address_u));
+	write(data, static_cast<uint32_t>(value.address_v));
+	write(data, static_cast<uint32_t>(value.address_w));
+	write(data, value.min_lod);
+	write(data, value.max_lod);
+	write(data, value.lod_bias);
+	write(data, value.type);
+	write(data, value.id);
+	write(data, value.name);
+	write(data, value.unique_name);
+	write(data, value.texture_name);
+	write(data, value.annotations);
+	write(data, value.srgb);
+}
+static void write(std::string &data, const reshadefx::storage &value)
+{
+	write(data, static_cast<uint32_t>(value.level));
+	write(data, value.type);
+	write(data, value.id);
+	write(data, value.name);
+	write(data, value.unique_name);
+	write(data, value.texture_name);
+}
+static void write(std::string &data, const reshadefx::uniform &value)
+{
+	write(data, value.type);
+	write(data, value.name);
+	write(data, value.size);
+	write(data, value.offset);
+	write(data, value.annotations);
+	write(data, value.has_initializer_value);
+	write(data, value.initializer_value);
+}
+static void write(std::string &data, const reshadefx::texture_binding &value)
+{
+	write(data, static_cast<uint32_t>(value.index));
+	write(data, value.entry_point_binding);
+	write(data, value.srgb);
+}
+static void write(std::string &data, const reshadefx::sampler_binding &value)
+{
+	write(data, static_cast<uint32_t>(value.index));
+	write(data, value.entry_point_binding);
+}
+static void write(std::string &data, const reshadefx::storage_binding &value)
+{
+	write(data, static_cast<uint32_t>(value.index));
+	write(data, value.entry_point_binding);
+}
+static void write(std::string &data, const reshadefx::pass &value)
+{
+	write(data, value.name);
+	for (const std::string &render_target_name : value.render_target_names)
+		write(data, render_target_name);
+	write(data, value.vs_entry_point);
+	write(data, value.ps_entry_point);
+	write(data, value.cs_entry_point);
+	write(data, value.generate_mipmaps);
+	write(data, value.clear_render_targets);
+	for (int i = 0; i < 8; ++i)
+	{
+		write(data, value.blend_enable[i]);
+		write(data, static_cast<uint32_t>(value.source_color_blend_factor[i]));
+		write(data, static_cast<uint32_t>(value.dest_color_blend_factor[i]));
+		write(data, static_cast<uint32_t>(value.color_blend_op[i]));
+		write(data, static_cast<uint32_t>(value.source_alpha_blend_factor[i]));
+		write(data, static_cast<uint32_t>(value.dest_alpha_blend_factor[i]));
+		write(data, static_cast<uint32_t>(value.alpha_blend_op[i]));
+		write(data, static_cast<uint32_t>(value.render_target_write_mask[i]));
+	}
+	write(data, value.srgb_write_enable);
+	write(data, value.stencil_enable);
+	write(data, static_cast<uint32_t>(value.stencil_read_mask));
+	write(data, static_cast<uint32_t>(value.stencil_write_mask));
+	write(data, static_cast<uint32_t>(value.stencil_reference_value));
+	write(data, static_cast<uint32_t>(value.stencil_comparison_func));
+	write(data, static_cast<uint32_t>(value.stencil_pass_op));
+	write(data, static_cast<uint32_t>(value.stencil_fail_op));
+	write(data, static_cast<uint32_t>(value.stencil_depth_fail_op));
+	write(data, static_cast<uint32_t>(value.topology));
+	write(data, value.num_vertices);
+	write(data, value.viewport_width);
+	write(data, value.viewport_height);
+	write(data, value.viewport_dispatch_z);
+	write(data, value.texture_bindings);
+	write(data, value.sampler_bindings);
+	write(data, value.storage_bindings);
+}
+static void write(std::string &data, const reshadefx::technique &value)
+{
+	write(data, value.name);
+	write(data, value.passes);
+	write(data, value.annotations);
+}
+static void write(std::string &data, const std::pair<std::string, reshadefx::shader_type> &value)
+{
+	write(data, value.first);
+	write(data, static_cast<uint32_t>(value.second));
+}
+
+/// <summary>
+/// Reads values from serialized data, keeping track of whether the data ended prematurely.
+/// </summary>
+struct module_reader
+{
+	const char *cur;
+	const char *end;
+	bool failed = false;
+
+	bool read_bytes(void *dest, size_t size)
+	{
+		if (failed || static_cast<size_t>(end - cur) < size)
+		{
+			failed = true;
+			return false;
+		}
+
+		std::memcpy(dest, cur, size);
+		cur += size;
+		return true;
+	}
+	/// <summary>
+	/// Reads an element count and validates it against the remaining data, so that corrupted data cannot cause huge allocations.
+	/// </summary>
+	uint32_t read_count()
+	{
+		uint32_t count = 0;
+		if (read_bytes(&count, sizeof(count)) && count > static_cast<size_t>(end - cur))
+			failed = true;
+		return failed ? 0 : count;
+	}
+};
+
+static void read(module_reader &reader, uint32_t &value)
+{
+	reader.read_bytes(&value, sizeof(value));
+}
+static void read(module_reader &reader, float &value)
+{
+	reader.read_bytes(&value, sizeof(value));
+}
+static void read(module_reader &reader, bool &value)
+{
+	uint8_t byte = 0;
+	reader.read_bytes(&byte, sizeof(byte));
+	value = byte != 0;
+}
+static void read(module_reader &reader, std::string &value)
+{
+	value.resize(reader.read_count());
+	reader.read_bytes(value.data(), value.size());
+}
+static void read(module_reader &reader, reshadefx::type &value);
+static void read(module_reader &reader, reshadefx::constant &value);
+static void read(module_reader &reader, reshadefx::annotation &value);
+static void read(module_reader &reader, reshadefx::texture &value);
+static void read(module_reader &reader, reshadefx::sampler &value);
+static void read(module_reader &reader, reshadefx::storage &value);
+static void read(module_reader &reader, reshadefx::uniform &value);
+static void read(module_reader &reader, reshadefx::texture_binding &value);
+static void read(module_reader &reader, reshadefx::sampler_binding &value);
+static void read(module_reader &reader, reshadefx::storage_binding &value);
+static void read(module_reader &reader, reshadefx::pass &value);
+static void read(module_reader &reader, reshadefx::technique &value);
+static void read(module_reader &reader, std::pair<std::string, reshadefx::shader_type> &value);
+
+template <typename T>
+static void read(module_reader &reader, std::vector<T> &values)
+{
+	values.resize(reader.read_count());
+	for (T &value : values)
+		read(reader, value);
+}
+template <typename T>
+static void read_as_uint(module_reader &reader, T &value)
+{
+	uint32_t temp = 0;
+	read(reader, temp);
+	value = static_cast<T>(temp);
+}
+
+static void read(module_reader &reader, reshadefx::type &value)
+{
+	uint32_t temp = 0;
+	read(reader, temp);
+	value.base = static_cast<reshadefx::type::datatype>(temp);
+	read(reader, temp);
+	value.rows = temp;
+	read(reader, temp);
+	value.cols = temp;
+	read(reader, temp);
+	value.qualifiers = temp;
+	read(reader, value.array_length);
+	read(reader, value.struct_definition);
+}
+static void read(module_reader &reader, reshadefx::constant &value)
+{
+	for (uint32_t &element : value.as_uint)
+		read(reader, element);
+	read(reader, value.string_data);
+	read(reader, value.array_data);
+}
+static void read(module_reader &reader, reshadefx::annotation &value)
+{
+	read(reader, value.type);
+	read(reader, value.name);
+	read(reader, value.value);
+}
+static void read(module_reader &reader, reshadefx::texture &value)
+{
+	read(reader, value.width);
+	read(reader, value.height);
+	read_as_uint(reader, value.depth);
+	read_as_uint(reader, value.levels);
+	read_as_uint(reader, value.type);
+	read_as_uint(reader, value.format);
+	read(reader, value.id);
+	read(reader, value.name);
+	read(reader, value.unique_name);
+	read(reader, value.semantic);
+	read(reader, value.annotations);
+	read(reader, value.render_target);
+	read(reader, value.storage_access);
+}
+static void read(module_reader &reader, reshadefx::sampler &value)
+{
+	read_as_uint(reader, value.filter);
+	read_as_uint(reader, value.address_u);
+	read_as_uint(reader, value.address_v);
+	read_as_uint(reader, value.address_w);
+	read(reader, value.min_lod);
+	read(reader, value.max_lod);
+	read(reader, value.lod_bias);
+	read(reader, value.type);
+	read(reader, value.id);
+	read(reader, value.name);
+	read(reader, value.unique_name);
+	read(reader, value.texture_name);
+	read(reader, value.annotations);
+	read(reader, value.srgb);
+}
+static void read(module_reader &reader, reshadefx::storage &value)
+{
+	read_as_uint(reader, value.level);
+	read(reader, value.type);
+	read(reader, value.id);
+	read(reader, value.name);
+	read(reader, value.unique_name);
+	read(reader, value.texture_name);
+}
+static void read(module_reader &reader, reshadefx::uniform &value)
+{
+	read(reader, value.type);
+	read(reader, value.name);
+	read(reader, value.size);
+	read(reader, value.offset);
+	read(reader, value.annotations);
+	read(reader, value.has_initializer_value);
+	read(reader, value.initializer_value);
+}
+static void read(module_reader &reader, reshadefx::texture_binding &value)
+{
+	read_as_uint(reader, value.index);
+	read(reader, value.entry_point_binding);
+	read(reader, value.srgb);
+}
+static void read(module_reader &reader, reshadefx::sampler_binding &value)
+{
+	read_as_uint(reader, value.index);
+	read(reader, value.entry_point_binding);
+}
+static void read(module_reader &reader, reshadefx::storage_binding &value)
+{
+	read_as_uint(reader, value.index);
+	read(reader, value.entry_point_binding);
+}
+static void read(module_reader &reader, reshadefx::pass &value)
+{
+	read(reader, value.name);
+	for (std::string &render_target_name : value.render_target_names)
+		read(reader, render_target_name);
+	read(reader, value.vs_entry_point);
+	read(reader, value.ps_entry_point);
+	read(reader, value.cs_entry_point);
+	read(reader, value.generate_mipmaps);
+	read(reader, value.clear_render_targets);
+	for (int i = 0; i < 8; ++i)
+	{
+		read(reader, value.blend_enable[i]);
+		read_as_uint(reader, value.source_color_blend_factor[i]);
+		read_as_uint(reader, value.dest_color_blend_factor[i]);
+		read_as_uint(reader, value.color_blend_op[i]);
+		read_as_uint(reader, value.source_alpha_blend_factor[i]);
+		read_as_uint(reader, value.dest_alpha_blend_factor[i]);
+		read_as_uint(reader, value.alpha_blend_op[i]);
+		read_as_uint(reader, value.render_target_write_mask[i]);
+	}
+	read(reader, value.srgb_write_enable);
+	read(reader, value.stencil_enable);
+	read_as_uint(reader, value.stencil_read_mask);
+	read_as_uint(reader, value.stencil_write_mask);
+	read_as_uint(reader, value.stencil_reference_value);
+	read_as_uint(reader, value.stencil_comparison_func);
+	read_as_uint(reader, value.stencil_pass_op);
+	read_as_uint(reader, value.stencil_fail_op);
+	read_as_uint(reader, value.stencil_depth_fail_op);
+	read_as_uint(reader, value.topology);
+	read(reader, value.num_vertices);
+	read(reader, value.viewport_width);
+	read(reader, value.viewport_height);
+	read(reader, value.viewport_dispatch_z);
+	read(reader, value.texture_bindings);
+	read(reader, value.sampler_bindings);
+	read(reader, value.storage_bindings);
+}
+static void read(module_reader &reader, reshadefx::technique &value)
+{
+	read(reader, value.name);
+	read(reader, value.passes);
+	read(reader, value.annotations);
+}
+static void read(module_reader &reader, std::pair<std::string, reshadefx::shader_type> &value)
+{
+	read(reader, value.first);
+	read_as_uint(reader, value.second);
+}
+
+std::string reshadefx::serialize_module(const effect_module &module, const std::string &generated_code, const std::vector<std::string> &entry_point_code)
+{
+	std::string data;
+	write(data, s_module_magic);
+	write(data, s_module_version);
+
+	write(data, module.textures);
+	write(data, module.samplers);
+	write(data, module.storages);
+	write(data, module.uniforms);
+	write(data, module.spec_constants);
+	write(data, module.total_uniform_size);
+	write(data, module.techniques);
+	write(data, module.entry_points);
+
+	write(data, generated_code);
+	write(data, entry_point_code);
+
+	return data;
+}
+
+bool reshadefx::deserialize_module(const std::string_view data, effect_module &module, std::string &generated_code, std::vector<std::string> &entry_point_code)
+{
+	module_reader reader { data.data(), data.data() + data.size() };
+
+	uint32_t magic = 0, version = 0;
+	read(reader, magic);
+	read(reader, version);
+	if (magic != s_module_magic || version != s_module_version)
+		return false;
+
+	effect_module result;
+	read(reader, result.textures);
+	read(reader, result.samplers);
+	read(reader, result.storages);
+	read(reader, result.uniforms);
+	read(reader, result.spec_constants);
+	read(reader, result.total_uniform_size);
+	read(reader, result.techniques);
+	read(reader, result.entry_points);
+
+	std::string result_generated_code;
+	std::vector<std::string> result_entry_point_code;
+	read(reader, result_generated_code);
+	read(reader, result_entry_point_code);
+
+	if (reader.failed || reader.cur != reader.end || result_entry_point_code.size() != result.entry_points.size())
+		return false;
+
+	module = std::move(result);
+	generated_code = std::move(result_generated_code);
+	entry_point_code = std::move(result_entry_point_code);
+	return true;
+}
+
+bool reshadefx::is_serialized_module(const std::string_view data)
+{
+	return data.size() >= sizeof(s_module_magic) && std::memcmp(data.data(), &s_module_magic, sizeof(s_module_magic)) == 0;
+}
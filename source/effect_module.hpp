@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_expression.hpp"
+#include <string_view>
 
 namespace reshadefx
 {
@@ -412,4 +413,21 @@ namespace reshadefx
 		std::vector<technique> techniques;
 		std::vector<std::pair<std::string, shader_type>> entry_points;
 	};
+
+	/// <summary>
+	/// Serializes an effect module and the code generated for it into a versioned binary representation, so that it can be cached and loaded again without parsing the effect.
+	/// </summary>
+	/// <param name="module">Effect module to serialize.</param>
+	/// <param name="generated_code">Code generated for the whole module (see <see cref="codegen::finalize_code"/>).</param>
+	/// <param name="entry_point_code">Code generated for each entry point, in the same order as <see cref="effect_module::entry_points"/>.</param>
+	std::string serialize_module(const effect_module &module, const std::string &generated_code, const std::vector<std::string> &entry_point_code);
+	/// <summary>
+	/// Deserializes an effect module and the code generated for it that was previously serialized with <see cref="serialize_module"/>.
+	/// </summary>
+	/// <returns><see langword="true"/> if the data was valid and written with the current format version, <see langword="false"/> otherwise (in which case the output arguments are not modified).</returns>
+	bool deserialize_module(const std::string_view data, effect_module &module, std::string &generated_code, std::vector<std::string> &entry_point_code);
+	/// <summary>
+	/// Checks whether the specified data starts with the signature of a serialized effect module.
+	/// </summary>
+	bool is_serialized_module(const std::string_view data);
 }
@@ -78,6 +78,7 @@ namespace reshadefx
 
 		std::unique_ptr<class lexer> _lexer;
 		class codegen *_codegen = nullptr;
+		constant_pool _constants;
 
 		token _token;
 		token _token_next;
@@ -14,14 +14,16 @@
 
 reshadefx::parser::parser()
 {
+	location::acquire_source_names();
 }
 reshadefx::parser::~parser()
 {
+	location::release_source_names();
 }
 
 void reshadefx::parser::error(const location &location, unsigned int code, const std::string &message)
 {
-	_errors += location.source;
+	_errors += location.source();
 	_errors += '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')';
 	_errors += ": error";
 	if (code != 0)
@@ -32,7 +34,7 @@ void reshadefx::parser::error(const location &location, unsigned int code, const
 }
 void reshadefx::parser::warning(const location &location, unsigned int code, const std::string &message)
 {
-	_errors += location.source;
+	_errors += location.source();
 	_errors += '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')';
 	_errors += ": warning";
 	if (code != 0)
@@ -54,8 +56,9 @@ void reshadefx::parser::restore()
 
 void reshadefx::parser::consume()
 {
-	_token = std::move(_token_next);
-	_token_next = _lexer->lex();
+	// Swap instead of move, so that the lexer can reuse the storage of the previous token
+	std::swap(_token, _token_next);
+	_lexer->lex(_token_next);
 }
 void reshadefx::parser::consume_until(tokenid tokid)
 {
@@ -763,12 +766,12 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 			for (expression &element_exp : elements)
 			{
 				element_exp.add_cast_operation(composite_type);
-				result.array_data.push_back(element_exp.constant);
+				result.array_data.push_back(element_exp.constant());
 			}
 
 			composite_type.array_length = static_cast<unsigned int>(elements.size());
 
-			exp.reset_to_rvalue_constant(location, std::move(result), composite_type);
+			exp.reset_to_rvalue_constant(location, _constants, std::move(result), composite_type);
 		}
 		else
 		{
@@ -790,30 +793,30 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 	}
 	else if (accept(tokenid::true_literal))
 	{
-		exp.reset_to_rvalue_constant(location, true);
+		exp.reset_to_rvalue_constant(location, _constants, true);
 	}
 	else if (accept(tokenid::false_literal))
 	{
-		exp.reset_to_rvalue_constant(location, false);
+		exp.reset_to_rvalue_constant(location, _constants, false);
 	}
 	else if (accept(tokenid::int_literal))
 	{
-		exp.reset_to_rvalue_constant(location, _token.literal_as_int);
+		exp.reset_to_rvalue_constant(location, _constants, _token.literal_as_int);
 	}
 	else if (accept(tokenid::uint_literal))
 	{
-		exp.reset_to_rvalue_constant(location, _token.literal_as_uint);
+		exp.reset_to_rvalue_constant(location, _constants, _token.literal_as_uint);
 	}
 	else if (accept(tokenid::float_literal))
 	{
-		exp.reset_to_rvalue_constant(location, _token.literal_as_float);
+		exp.reset_to_rvalue_constant(location, _constants, _token.literal_as_float);
 	}
 	else if (accept(tokenid::double_literal))
 	{
 		// Convert double literal to float literal for now
 		warning(location, 5000, "double literal truncated to float literal");
 
-		exp.reset_to_rvalue_constant(location, static_cast<float>(_token.literal_as_double));
+		exp.reset_to_rvalue_constant(location, _constants, static_cast<float>(_token.literal_as_double));
 	}
 	else if (accept(tokenid::string_literal))
 	{
@@ -823,7 +826,7 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 		while (accept(tokenid::string_literal))
 			value += _token.literal_as_string;
 
-		exp.reset_to_rvalue_constant(location, std::move(value));
+		exp.reset_to_rvalue_constant(location, _constants, std::move(value));
 	}
 	else if (type type = {}; accept_type_class(type)) // Check if this is a constructor call expression
 	{
@@ -893,10 +896,10 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 				argument_exp.add_cast_operation({ type.base, argument_exp.type.rows, argument_exp.type.cols });
 
 				for (unsigned int k = 0; k < argument_exp.type.components(); ++k)
-					result.as_uint[i++] = argument_exp.constant.as_uint[k];
+					result.as_uint[i++] = argument_exp.constant().as_uint[k];
 			}
 
-			exp.reset_to_rvalue_constant(location, std::move(result), type);
+			exp.reset_to_rvalue_constant(location, _constants, std::move(result), type);
 		}
 		else if (arguments.size() > 1)
 		{
@@ -1169,7 +1172,7 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 		else if (symbol.op == symbol_type::constant)
 		{
 			// Constants are loaded into the access chain
-			exp.reset_to_rvalue_constant(location, symbol.constant, symbol.type);
+			exp.reset_to_rvalue_constant(location, _constants, symbol.constant, symbol.type);
 		}
 		else
 		{
@@ -1424,20 +1427,20 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 			if (index_exp.is_constant)
 			{
 				// Check array bounds if known
-				if (exp.type.is_bounded_array() && index_exp.constant.as_uint[0] >= exp.type.array_length)
+				if (exp.type.is_bounded_array() && index_exp.constant().as_uint[0] >= exp.type.array_length)
 				{
 					error(index_exp.location, 3504, "array index out of bounds");
 					return false;
 				}
 
-				exp.add_constant_index_access(index_exp.constant.as_uint[0]);
+				exp.add_constant_index_access(index_exp.constant().as_uint[0]);
 			}
 			else
 			{
 				if (exp.is_constant)
 				{
 					// To handle a dynamic index into a constant means we need to create a local variable first or else any of the indexing instructions do not work
-					const codegen::id temp_variable = _codegen->define_variable(location, exp.type, std::string(), false, _codegen->emit_constant(exp.type, exp.constant));
+					const codegen::id temp_variable = _codegen->define_variable(location, exp.type, std::string(), false, _codegen->emit_constant(exp.type, exp.constant()));
 					exp.reset_to_lvalue(exp.location, temp_variable, exp.type);
 				}
 
@@ -1568,7 +1571,7 @@ bool reshadefx::parser::parse_expression_multary(expression &lhs_exp, unsigned i
 #endif
 
 			// Constant expressions can be evaluated at compile time
-			if (rhs_exp.is_constant && lhs_exp.evaluate_constant_expression(op, rhs_exp.constant))
+			if (rhs_exp.is_constant && lhs_exp.evaluate_constant_expression(op, rhs_exp.constant()))
 				continue;
 
 			const codegen::id lhs_value = _codegen->emit_load(lhs_exp);
@@ -53,6 +53,9 @@ bool reshadefx::parser::parse(std::string input, codegen *backend)
 
 bool reshadefx::parser::parse_top(bool &parse_success)
 {
+	// Constant expressions do not outlive the declaration they are part of, so can reuse the memory of their values for the next one
+	_constants.clear();
+
 	if (accept(tokenid::namespace_))
 	{
 		// Anonymous namespaces are not supported right now, so an identifier is a must
@@ -148,9 +151,9 @@ bool reshadefx::parser::parse_top(bool &parse_success)
 				x.add_cast_operation({ type::t_int, 1, 1 });
 				y.add_cast_operation({ type::t_int, 1, 1 });
 				z.add_cast_operation({ type::t_int, 1, 1 });
-				num_threads[0] = x.constant.as_int[0];
-				num_threads[1] = y.constant.as_int[0];
-				num_threads[2] = z.constant.as_int[0];
+				num_threads[0] = x.constant().as_int[0];
+				num_threads[1] = y.constant().as_int[0];
+				num_threads[2] = z.constant().as_int[0];
 			}
 			else
 			{
@@ -182,7 +185,7 @@ bool reshadefx::parser::parse_top(bool &parse_success)
 			}
 			else
 			{
-				if (!attribute_location.source.empty())
+				if (!attribute_location.source().empty())
 				{
 					error(attribute_location, 0, "attribute is valid only on functions");
 					parse_success = false;
@@ -416,16 +419,16 @@ bool reshadefx::parser::parse_statement(bool scoped)
 						// Check for duplicate case values
 						for (size_t i = 0; i < case_literal_and_labels.size(); i += 2)
 						{
-							if (case_literal_and_labels[i] == case_label.constant.as_uint[0])
+							if (case_literal_and_labels[i] == case_label.constant().as_uint[0])
 							{
 								parse_success = false;
-								error(case_label.location, 3532, "duplicate case " + std::to_string(case_label.constant.as_uint[0]));
+								error(case_label.location, 3532, "duplicate case " + std::to_string(case_label.constant().as_uint[0]));
 								break;
 							}
 						}
 
 						case_blocks.emplace_back(); // This is set to the actual block below
-						case_literal_and_labels.push_back(case_label.constant.as_uint[0]);
+						case_literal_and_labels.push_back(case_label.constant().as_uint[0]);
 						case_literal_and_labels.push_back(current_label);
 					}
 					else
@@ -975,7 +978,7 @@ bool reshadefx::parser::parse_array_length(type &type)
 				return false;
 			}
 
-			type.array_length = length_exp.constant.as_uint[0];
+			type.array_length = length_exp.constant().as_uint[0];
 
 			if (type.array_length < 1 || type.array_length > 65536)
 			{
@@ -1029,7 +1032,7 @@ bool reshadefx::parser::parse_annotations(std::vector<annotation> &annotations)
 
 		if (annotation_exp.is_constant)
 		{
-			annotations.push_back({ annotation_exp.type, std::move(name), std::move(annotation_exp.constant) });
+			annotations.push_back({ annotation_exp.type, std::move(name), annotation_exp.constant() });
 		}
 		else // Continue parsing annotations despite this not being a constant, since the syntax is still correct
 		{
@@ -1392,7 +1395,7 @@ bool reshadefx::parser::parse_function(type type, std::string name, shader_type
 				error(default_value_exp.location, 3011, '\'' + param.name + "': value must be a literal expression");
 			}
 
-			param.default_value = std::move(default_value_exp.constant);
+			param.default_value = default_value_exp.constant();
 			param.has_default_value = true;
 		}
 		else
@@ -1647,7 +1650,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 			}
 
 			if (!type.has(type::q_uniform)) // Zero initialize all global variables
-				initializer.reset_to_rvalue_constant(variable_location, {}, type);
+				initializer.reset_to_rvalue_constant(variable_location, _constants, {}, type);
 		}
 		else if (global && accept('{')) // Textures and samplers can have a property block attached to their declaration
 		{
@@ -1722,7 +1725,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 					// Look up identifier in list of possible enumeration names
 					if (const auto it = s_enum_values.find(_token.literal_as_string);
 						it != s_enum_values.end())
-						property_exp.reset_to_rvalue_constant(_token.location, it->second);
+						property_exp.reset_to_rvalue_constant(_token.location, _constants, it->second);
 					else // No match found, so rewind to parser state before the identifier was consumed and try parsing it as a normal expression
 						restore();
 				}
@@ -1773,7 +1776,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 
 					// All states below expect the value to be of an integer type
 					property_exp.add_cast_operation({ type::t_int, 1, 1 });
-					const int value = property_exp.constant.as_int[0];
+					const int value = property_exp.constant().as_int[0];
 
 					if (value < 0) // There is little use for negative values, so warn in those cases
 						warning(property_exp.location, 3571, "negative value specified for property '" + property_name + '\'');
@@ -1855,7 +1858,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 	if (type.is_numeric() && type.has(type::q_const) && initializer.is_constant && type.array_length < 100)
 	{
 		// Named constants are special symbols
-		symbol = { symbol_type::constant, 0, type, initializer.constant };
+		symbol = { symbol_type::constant, 0, type, initializer.constant() };
 	}
 	else if (type.is_texture())
 	{
@@ -2016,7 +2019,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 
 		uniform_info.annotations = std::move(sampler_info.annotations);
 
-		uniform_info.initializer_value = std::move(initializer.constant);
+		uniform_info.initializer_value = initializer.constant();
 		uniform_info.has_initializer_value = initializer.is_constant;
 
 		const codegen::id id = _codegen->define_uniform(variable_location, uniform_info);
@@ -2143,7 +2146,7 @@ bool reshadefx::parser::parse_technique_pass(pass &info)
 				}
 
 				// Parse optional third dimension (defaults to 1)
-				z.reset_to_rvalue_constant({}, 1);
+				z.reset_to_rvalue_constant({}, _constants, 1);
 				if (accept(',') && !parse_expression_multary(z, 8))
 				{
 					consume_until('}');
@@ -2171,9 +2174,9 @@ bool reshadefx::parser::parse_technique_pass(pass &info)
 				x.add_cast_operation({ type::t_int, 1, 1 });
 				y.add_cast_operation({ type::t_int, 1, 1 });
 				z.add_cast_operation({ type::t_int, 1, 1 });
-				num_threads[0] = x.constant.as_int[0];
-				num_threads[1] = y.constant.as_int[0];
-				num_threads[2] = z.constant.as_int[0];
+				num_threads[0] = x.constant().as_int[0];
+				num_threads[1] = y.constant().as_int[0];
+				num_threads[2] = z.constant().as_int[0];
 
 				if (!expect('>'))
 				{
@@ -2376,7 +2379,7 @@ bool reshadefx::parser::parse_technique_pass(pass &info)
 				// Look up identifier in list of possible enumeration names
 				if (const auto it = s_enum_values.find(_token.literal_as_string);
 					it != s_enum_values.end())
-					state_exp.reset_to_rvalue_constant(_token.location, it->second);
+					state_exp.reset_to_rvalue_constant(_token.location, _constants, it->second);
 				else // No match found, so rewind to parser state before the identifier was consumed and try parsing it as a normal expression
 					restore();
 			}
@@ -2396,7 +2399,7 @@ bool reshadefx::parser::parse_technique_pass(pass &info)
 
 			// All states below expect the value to be of an unsigned integer type
 			state_exp.add_cast_operation({ type::t_uint, 1, 1 });
-			const unsigned int value = state_exp.constant.as_uint[0];
+			const unsigned int value = state_exp.constant().as_uint[0];
 
 #define SET_STATE_VALUE_INDEXED(name, info_name, value) \
 	else if (constexpr size_t name##_len = sizeof(#name) - 1; state_name.compare(0, name##_len, #name) == 0 && \
@@ -8,7 +8,9 @@
 #include <limits>
 #include <cstdio> // fclose, fopen, fread, fseek
 #include <cassert>
-#include <algorithm> // std::find_if
+#include <algorithm> // std::find, std::find_if, std::sort, std::unique
+#include <mutex>
+#include <shared_mutex>
 
 #ifndef _WIN32
 	// On Linux systems the native path encoding is UTF-8 already, so no conversion necessary
@@ -99,6 +101,91 @@ static bool read_file(const std::filesystem::path &path, std::string &file_data)
 	return true;
 }
 
+struct include_cache_entry
+{
+	std::filesystem::file_time_type modified_at;
+	std::shared_ptr<const std::string> file_data;
+};
+
+// Cache of included files, which is shared between all preprocessor instances, so that common headers are only read once when compiling multiple effects in parallel
+static std::shared_mutex s_include_cache_mutex;
+static std::unordered_map<std::string, include_cache_entry> s_include_cache;
+
+static std::shared_ptr<const std::string> read_file_cached(const std::filesystem::path &path, std::filesystem::file_time_type &modified_at)
+{
+	// Query the modification time before reading, so that a change made while reading causes a mismatch next time, rather than going unnoticed
+	std::error_code ec;
+	modified_at = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return nullptr;
+
+	const std::string cache_key = path.lexically_normal().u8string();
+
+	{
+		const std::shared_lock<std::shared_mutex> lock(s_include_cache_mutex);
+
+		// Only reuse the cached file contents if the file was not modified since it was last read
+		if (const auto it = s_include_cache.find(cache_key);
+			it != s_include_cache.end() && it->second.modified_at == modified_at)
+			return it->second.file_data;
+	}
+
+	// Read file outside the lock, so that other threads are not blocked on disk access
+	std::string file_data;
+	if (!read_file(path, file_data))
+		return nullptr;
+
+	auto shared_file_data = std::make_shared<const std::string>(std::move(file_data));
+
+	const std::unique_lock<std::shared_mutex> lock(s_include_cache_mutex);
+
+	s_include_cache[cache_key] = { modified_at, shared_file_data };
+
+	return shared_file_data;
+}
+
+struct reshadefx::precompiled_header
+{
+	// Macro definitions and include paths that were active when this header was recorded
+	size_t macros_hash = 0;
+	std::vector<std::pair<std::string, preprocessor::macro>> macros;
+	std::vector<std::filesystem::path> include_paths;
+
+	// Contents of all files included by this header (including itself) before it was recorded, which are empty for files that were skipped due to '#pragma once'
+	std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> dependencies;
+	// Contents of all files included by this header after it was recorded, to restore the '#pragma once' state
+	std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> file_cache;
+	// Paths that were tried while resolving includes in this header, but did not exist
+	std::vector<std::string> missing_files;
+
+	std::vector<std::pair<std::string, preprocessor::macro>> defined_macros;
+	std::vector<std::string> undefined_macros;
+	std::vector<std::string> used_macros;
+	std::vector<std::string> referenced_predefined_macros;
+	std::vector<std::pair<std::string, std::string>> used_pragmas;
+
+	std::string output;
+	reshadefx::location output_location;
+};
+
+// List of recorded headers for each file path, which is shared between all preprocessor instances (see 'preprocessor::enable_precompiled_headers')
+static std::shared_mutex s_precompiled_header_mutex;
+static std::unordered_map<std::string, std::vector<std::shared_ptr<const reshadefx::precompiled_header>>> s_precompiled_headers;
+
+static size_t hash_macro(const std::string &name, const reshadefx::preprocessor::macro &macro)
+{
+	size_t hash = std::hash<std::string>()(name);
+	hash = hash * 31 + std::hash<std::string>()(macro.replacement_list);
+	for (const std::string &parameter : macro.parameters)
+		hash = hash * 31 + std::hash<std::string>()(parameter);
+	hash = hash * 31 + (macro.is_predefined ? 1 : 0) + (macro.is_variadic ? 2 : 0) + (macro.is_function_like ? 4 : 0);
+	return hash;
+}
+static bool equal_macro(const reshadefx::preprocessor::macro &lhs, const reshadefx::preprocessor::macro &rhs)
+{
+	return lhs.replacement_list == rhs.replacement_list && lhs.parameters == rhs.parameters && lhs.is_predefined == rhs.is_predefined && lhs.is_variadic == rhs.is_variadic && lhs.is_function_like == rhs.is_function_like;
+}
+
 template <char ESCAPE_CHAR = '\\'>
 static std::string escape_string(std::string s)
 {
@@ -109,9 +196,28 @@ static std::string escape_string(std::string s)
 
 reshadefx::preprocessor::preprocessor()
 {
+	location::acquire_source_names();
 }
 reshadefx::preprocessor::~preprocessor()
 {
+	location::release_source_names();
+}
+
+void reshadefx::preprocessor::clear_include_cache()
+{
+	{
+		const std::unique_lock<std::shared_mutex> lock(s_include_cache_mutex);
+
+		s_include_cache.clear();
+	}
+	{
+		const std::unique_lock<std::shared_mutex> lock(s_precompiled_header_mutex);
+
+		s_precompiled_headers.clear();
+	}
+
+	// Precompiled headers were the last to keep locations around outside of a compilation, so the source file names they referred to can go too
+	location::clear_source_names();
 }
 
 void reshadefx::preprocessor::add_include_path(const std::filesystem::path &path)
@@ -122,7 +228,39 @@ void reshadefx::preprocessor::add_include_path(const std::filesystem::path &path
 bool reshadefx::preprocessor::add_macro_definition(const std::string &name, const macro &macro)
 {
 	assert(!name.empty());
-	return _macros.emplace(name, macro).second;
+
+	if (!_macros.emplace(name, macro).second)
+		return false;
+
+	// Keep track of the set of macro definitions, so that matching precompiled headers can be found quickly
+	_macros_hash += hash_macro(name, macro);
+
+	for (include_recording &recording : _include_recordings)
+		recording.modified_macros.push_back(name);
+
+	return true;
+}
+void reshadefx::preprocessor::remove_macro_definition(const std::string &name)
+{
+	const auto it = _macros.find(name);
+	if (it == _macros.end())
+		return;
+
+	_macros_hash -= hash_macro(it->first, it->second);
+	_macros.erase(it);
+
+	for (include_recording &recording : _include_recordings)
+		recording.modified_macros.push_back(name);
+}
+void reshadefx::preprocessor::add_predefined_macro_reference(const std::string &name)
+{
+	if (const auto it = _macros.find(name); it == _macros.end() || !it->second.is_predefined)
+		return;
+
+	_referenced_predefined_macros.insert(name);
+
+	for (include_recording &recording : _include_recordings)
+		recording.header->referenced_predefined_macros.push_back(name);
 }
 
 bool reshadefx::preprocessor::append_file(const std::filesystem::path &path)
@@ -154,10 +292,29 @@ std::vector<std::filesystem::path> reshadefx::preprocessor::included_files() con
 {
 	std::vector<std::filesystem::path> files;
 	files.reserve(_file_cache.size());
-	for (const std::pair<std::string, std::string> &cache_entry : _file_cache)
+	for (const std::pair<const std::string, std::shared_ptr<const std::string>> &cache_entry : _file_cache)
 		files.push_back(std::filesystem::u8path(cache_entry.first));
 	return files;
 }
+std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> reshadefx::preprocessor::included_files_with_modification_time() const
+{
+	std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> files;
+	files.reserve(_file_cache.size());
+	for (const std::pair<const std::string, std::shared_ptr<const std::string>> &cache_entry : _file_cache)
+	{
+		const auto it = _file_modification_times.find(cache_entry.first);
+		files.emplace_back(std::filesystem::u8path(cache_entry.first), it != _file_modification_times.end() ? it->second : std::filesystem::file_time_type::min());
+	}
+	return files;
+}
+std::vector<std::filesystem::path> reshadefx::preprocessor::missing_include_files() const
+{
+	std::vector<std::filesystem::path> files;
+	files.reserve(_missing_files.size());
+	for (const std::string &file_path_string : _missing_files)
+		files.push_back(std::filesystem::u8path(file_path_string));
+	return files;
+}
 std::vector<std::pair<std::string, std::string>> reshadefx::preprocessor::used_macro_definitions() const
 {
 	std::vector<std::pair<std::string, std::string>> defines;
@@ -169,10 +326,16 @@ std::vector<std::pair<std::string, std::string>> reshadefx::preprocessor::used_m
 			defines.emplace_back(name, it->second.replacement_list);
 	return defines;
 }
+std::vector<std::string> reshadefx::preprocessor::referenced_predefined_macros() const
+{
+	std::vector<std::string> names(_referenced_predefined_macros.begin(), _referenced_predefined_macros.end());
+	std::sort(names.begin(), names.end());
+	return names;
+}
 
 void reshadefx::preprocessor::error(const location &location, const std::string &message)
 {
-	_errors += location.source;
+	_errors += location.source();
 	_errors += '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')';
 	_errors += ": preprocessor error: ";
 	_errors += message;
@@ -180,7 +343,7 @@ void reshadefx::preprocessor::error(const location &location, const std::string
 }
 void reshadefx::preprocessor::warning(const location &location, const std::string &message)
 {
-	_errors += location.source;
+	_errors += location.source();
 	_errors += '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')';
 	_errors += ": preprocessor warning: ";
 	_errors += message;
@@ -243,20 +406,21 @@ void reshadefx::preprocessor::consume()
 
 	// Update location information after switching input levels
 	input_level &input = _input_stack[_current_input_index];
-	if (!input.name.empty() && input.name != _output_location.source)
+	if (!input.name.empty() && input.name != _output_location.source())
 	{
 		_output += "#line " + std::to_string(input.next_token.location.line) + " \"" + input.name + "\"\n";
 		// Line number is increased before checking against next token in 'tokenid::end_of_line' handling in 'parse' function below, so compensate for that here
 		_output_location.line = input.next_token.location.line - 1;
-		_output_location.source = input.name;
+		_output_location.set_source(input.name);
 	}
 
 	// Set current token
-	_token = std::move(input.next_token);
-	_current_token_raw_data = input.lexer->input_string().substr(_token.offset, _token.length);
+	// Swap instead of move, so that the lexer can reuse the storage of the previous token
+	std::swap(_token, input.next_token);
+	_current_token_raw_data.assign(input.lexer->input_string(), _token.offset, _token.length);
 
 	// Get the next token
-	input.next_token = input.lexer->lex();
+	input.lexer->lex(input.next_token);
 
 	// Verify string literals (since the lexer cannot throw errors itself)
 	if (_token == tokenid::string_literal && _current_token_raw_data.back() != '\"')
@@ -316,7 +480,7 @@ bool reshadefx::preprocessor::expect(tokenid tokid)
 			return tokid == tokenid::end_of_line || tokid == tokenid::end_of_file;
 
 		token actual_token = _input_stack[_next_input_index].next_token;
-		actual_token.location.source = _output_location.source;
+		actual_token.location.set_source(_output_location.source());
 
 		if (actual_token == tokenid::end_of_line)
 			error(actual_token.location, "syntax error: unexpected new line");
@@ -337,6 +501,11 @@ void reshadefx::preprocessor::parse()
 	// Consume all tokens in the input
 	while (!peek(tokenid::end_of_file))
 	{
+		// Finish recording included files once all their tokens were consumed
+		// This is only successful if the file was left at the end of a line and not while in the middle of a directive or macro expansion
+		while (!_include_recordings.empty() && _next_input_index < _include_recordings.back().input_index)
+			end_precompiled_header(line.empty() && _current_input_index >= _include_recordings.back().input_index);
+
 		consume();
 
 		_recursion_count = 0;
@@ -444,6 +613,10 @@ void reshadefx::preprocessor::parse()
 		}
 	}
 
+	// Any included files that are still being recorded ended together with the input
+	while (!_include_recordings.empty())
+		end_precompiled_header(line.empty());
+
 	// Append the last line after the EOF token was reached to the output
 	_output += line;
 	_output += '\n';
@@ -492,7 +665,7 @@ void reshadefx::preprocessor::parse_undef()
 	if (_token.literal_as_string == "defined")
 		return warning(_token.location, "macro name 'defined' is reserved");
 
-	_macros.erase(_token.literal_as_string);
+	remove_macro_definition(_token.literal_as_string);
 }
 
 void reshadefx::preprocessor::parse_if()
@@ -536,9 +709,16 @@ void reshadefx::preprocessor::parse_ifdef()
 		level.value = is_defined(_token.literal_as_string);
 		level.skipping = !level.value;
 
+		add_predefined_macro_reference(_token.literal_as_string);
+
 		// Only add to used macro list if this #ifdef is active and the macro was not defined before
 		if (const auto it = _macros.find(_token.literal_as_string); it == _macros.end() || it->second.is_predefined)
+		{
 			_used_macros.emplace(_token.literal_as_string);
+
+			for (include_recording &recording : _include_recordings)
+				recording.header->used_macros.push_back(_token.literal_as_string);
+		}
 	}
 
 	_if_stack.push_back(std::move(level));
@@ -563,9 +743,16 @@ void reshadefx::preprocessor::parse_ifndef()
 		level.value = !is_defined(_token.literal_as_string);
 		level.skipping = !level.value;
 
+		add_predefined_macro_reference(_token.literal_as_string);
+
 		// Only add to used macro list if this #ifndef is active and the macro was not defined before
 		if (const auto it = _macros.find(_token.literal_as_string); it == _macros.end() || it->second.is_predefined)
+		{
 			_used_macros.emplace(_token.literal_as_string);
+
+			for (include_recording &recording : _include_recordings)
+				recording.header->used_macros.push_back(_token.literal_as_string);
+		}
 	}
 
 	_if_stack.push_back(std::move(level));
@@ -681,8 +868,8 @@ void reshadefx::preprocessor::parse_pragma()
 	if (pragma == "once")
 	{
 		// Clear file contents, so that future include statements simply push an empty string instead of these file contents again
-		if (const auto it = _file_cache.find(_output_location.source); it != _file_cache.end())
-			it->second.clear();
+		if (const auto it = _file_cache.find(_output_location.source()); it != _file_cache.end())
+			it->second.reset();
 		return;
 	}
 
@@ -716,15 +903,23 @@ void reshadefx::preprocessor::parse_include()
 	}
 
 	std::filesystem::path file_name = std::filesystem::u8path(_token.literal_as_string);
-	std::filesystem::path file_path = std::filesystem::u8path(_output_location.source);
+	std::filesystem::path file_path = std::filesystem::u8path(_output_location.source());
 	file_path.replace_filename(file_name);
 
 	std::error_code ec;
 	if (!std::filesystem::exists(file_path, ec))
+	{
+		add_missing_include_dependency(file_path.u8string());
+
 		for (const std::filesystem::path &include_path : _include_paths)
+		{
 			if (std::filesystem::exists(file_path = include_path / file_name, ec))
 				break;
 
+			add_missing_include_dependency(file_path.u8string());
+		}
+	}
+
 	const std::string file_path_string = file_path.u8string();
 
 	// Detect recursive include and abort to avoid infinite loop
@@ -732,19 +927,24 @@ void reshadefx::preprocessor::parse_include()
 			[&file_path_string](const input_level &level) { return level.name == file_path_string; }) != _input_stack.end())
 		return error(_token.location, "recursive #include");
 
-	std::string input;
+	// File data is empty if this file was included before and contained a '#pragma once'
+	std::shared_ptr<const std::string> file_data;
 	if (const auto it = _file_cache.find(file_path_string); it != _file_cache.end())
 	{
-		input = it->second;
+		file_data = it->second;
 	}
 	else
 	{
-		if (!read_file(file_path, input))
+		std::filesystem::file_time_type modified_at;
+		if ((file_data = read_file_cached(file_path, modified_at)) == nullptr)
 			return error(keyword_location, "could not open included file '" + file_name.u8string() + '\'');
 
-		_file_cache.emplace(file_path_string, input);
+		_file_cache.emplace(file_path_string, file_data);
+		_file_modification_times[file_path_string] = modified_at;
 	}
 
+	add_include_dependency(file_path_string, file_data);
+
 	// Skip end of line character following the include statement before pushing, so that the line number is already pointing to the next line when popping out of it again
 	if (!expect(tokenid::end_of_line))
 		consume_until(tokenid::end_of_line);
@@ -753,7 +953,190 @@ void reshadefx::preprocessor::parse_include()
 	while (_input_stack.size() > (_next_input_index + 1))
 		_input_stack.pop_back();
 
-	push(std::move(input), file_path_string);
+	if (_precompiled_headers && file_data != nullptr)
+	{
+		if (replay_precompiled_header(file_path_string))
+			return;
+
+		begin_precompiled_header(file_path_string, file_data);
+	}
+
+	push(file_data != nullptr ? *file_data : std::string(), file_path_string);
+}
+
+bool reshadefx::preprocessor::replay_precompiled_header(const std::string &file_path_string)
+{
+	std::vector<std::shared_ptr<const precompiled_header>> candidates;
+	{
+		const std::shared_lock<std::shared_mutex> lock(s_precompiled_header_mutex);
+
+		if (const auto it = s_precompiled_headers.find(file_path_string); it != s_precompiled_headers.end())
+			for (const std::shared_ptr<const precompiled_header> &header : it->second)
+				if (header->macros_hash == _macros_hash)
+					candidates.push_back(header);
+	}
+
+	const auto is_matching = [this](const precompiled_header &header) {
+		if (header.macros.size() != _macros.size() || header.include_paths != _include_paths)
+			return false;
+
+		for (const std::pair<std::string, macro> &definition : header.macros)
+			if (const auto it = _macros.find(definition.first);
+				it == _macros.end() || !equal_macro(it->second, definition.second))
+				return false;
+
+		// All included files have to be unchanged and have the same '#pragma once' state as when the header was recorded
+		for (const std::pair<std::string, std::shared_ptr<const std::string>> &dependency : header.dependencies)
+		{
+			if (std::find_if(_input_stack.begin(), _input_stack.end(),
+					[&dependency](const input_level &level) { return level.name == dependency.first; }) != _input_stack.end())
+				return false;
+
+			if (const auto it = _file_cache.find(dependency.first); it != _file_cache.end())
+			{
+				if (it->second != dependency.second)
+					return false;
+			}
+			else
+			{
+				std::filesystem::file_time_type modified_at;
+				if (read_file_cached(std::filesystem::u8path(dependency.first), modified_at) != dependency.second)
+					return false;
+
+				// Remember when the file contents were read, in case this header is replayed and the file thus becomes an include of this preprocessor
+				_file_modification_times[dependency.first] = modified_at;
+			}
+		}
+
+		// A file created at any of the paths that did not exist while recording may now shadow one of the included files
+		std::error_code ec;
+		for (const std::string &file_path_string : header.missing_files)
+			if (std::filesystem::exists(std::filesystem::u8path(file_path_string), ec))
+				return false;
+
+		return true;
+	};
+
+	const auto it = std::find_if(candidates.begin(), candidates.end(),
+		[&is_matching](const std::shared_ptr<const precompiled_header> &header) { return is_matching(*header); });
+	if (it == candidates.end())
+		return false;
+
+	const precompiled_header &header = **it;
+
+	_output += header.output;
+	_output_location = header.output_location;
+
+	for (const std::pair<std::string, macro> &definition : header.defined_macros)
+	{
+		remove_macro_definition(definition.first);
+		add_macro_definition(definition.first, definition.second);
+	}
+	for (const std::string &name : header.undefined_macros)
+		remove_macro_definition(name);
+
+	for (const std::string &name : header.used_macros)
+	{
+		_used_macros.insert(name);
+
+		for (include_recording &recording : _include_recordings)
+			recording.header->used_macros.push_back(name);
+	}
+	for (const std::string &name : header.referenced_predefined_macros)
+	{
+		_referenced_predefined_macros.insert(name);
+
+		for (include_recording &recording : _include_recordings)
+			recording.header->referenced_predefined_macros.push_back(name);
+	}
+
+	_used_pragmas.insert(_used_pragmas.end(), header.used_pragmas.begin(), header.used_pragmas.end());
+
+	for (const std::pair<std::string, std::shared_ptr<const std::string>> &dependency : header.dependencies)
+		add_include_dependency(dependency.first, dependency.second);
+	for (const std::pair<std::string, std::shared_ptr<const std::string>> &cache_entry : header.file_cache)
+		_file_cache[cache_entry.first] = cache_entry.second;
+	for (const std::string &file_path_string : header.missing_files)
+		add_missing_include_dependency(file_path_string);
+
+	return true;
+}
+void reshadefx::preprocessor::begin_precompiled_header(const std::string &file_path_string, std::shared_ptr<const std::string> file_data)
+{
+	include_recording &recording = _include_recordings.emplace_back();
+	// The included file is pushed onto the top of the input stack right after this
+	recording.input_index = _input_stack.size();
+	recording.output_offset = _output.size();
+	recording.errors_offset = _errors.size();
+	recording.used_pragmas_offset = _used_pragmas.size();
+
+	recording.header = std::make_shared<precompiled_header>();
+	recording.header->macros_hash = _macros_hash;
+	recording.header->macros.assign(_macros.begin(), _macros.end());
+	recording.header->include_paths = _include_paths;
+	recording.header->dependencies.emplace_back(file_path_string, std::move(file_data));
+}
+void reshadefx::preprocessor::end_precompiled_header(bool success)
+{
+	include_recording recording = std::move(_include_recordings.back());
+	_include_recordings.pop_back();
+
+	// Only keep headers that were preprocessed without any errors or warnings, so that replaying them does not need to reproduce those
+	if (!success || _errors.size() != recording.errors_offset)
+		return;
+
+	precompiled_header &header = *recording.header;
+	header.output = _output.substr(recording.output_offset);
+	header.output_location = _output_location;
+
+	std::sort(recording.modified_macros.begin(), recording.modified_macros.end());
+	recording.modified_macros.erase(std::unique(recording.modified_macros.begin(), recording.modified_macros.end()), recording.modified_macros.end());
+	for (const std::string &name : recording.modified_macros)
+	{
+		if (const auto it = _macros.find(name); it != _macros.end())
+			header.defined_macros.emplace_back(name, it->second);
+		else
+			header.undefined_macros.push_back(name);
+	}
+
+	std::sort(header.referenced_predefined_macros.begin(), header.referenced_predefined_macros.end());
+	header.referenced_predefined_macros.erase(std::unique(header.referenced_predefined_macros.begin(), header.referenced_predefined_macros.end()), header.referenced_predefined_macros.end());
+
+	header.used_pragmas.assign(_used_pragmas.begin() + recording.used_pragmas_offset, _used_pragmas.end());
+
+	for (const std::pair<std::string, std::shared_ptr<const std::string>> &dependency : header.dependencies)
+		header.file_cache.emplace_back(dependency.first, _file_cache.at(dependency.first));
+
+	const std::unique_lock<std::shared_mutex> lock(s_precompiled_header_mutex);
+
+	std::vector<std::shared_ptr<const precompiled_header>> &headers = s_precompiled_headers[header.dependencies[0].first];
+	// Another preprocessor instance may have recorded the same header in the meantime
+	if (std::find_if(headers.begin(), headers.end(),
+			[&header](const std::shared_ptr<const precompiled_header> &existing_header) {
+				return existing_header->macros_hash == header.macros_hash && existing_header->dependencies[0].second == header.dependencies[0].second;
+			}) == headers.end())
+		headers.push_back(std::move(recording.header));
+}
+void reshadefx::preprocessor::add_include_dependency(const std::string &file_path_string, const std::shared_ptr<const std::string> &file_data)
+{
+	for (include_recording &recording : _include_recordings)
+	{
+		std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> &dependencies = recording.header->dependencies;
+
+		// Only the state of the first include of each file matters
+		if (std::find_if(dependencies.begin(), dependencies.end(),
+				[&file_path_string](const std::pair<std::string, std::shared_ptr<const std::string>> &dependency) { return dependency.first == file_path_string; }) == dependencies.end())
+			dependencies.emplace_back(file_path_string, file_data);
+	}
+}
+void reshadefx::preprocessor::add_missing_include_dependency(const std::string &file_path_string)
+{
+	_missing_files.insert(file_path_string);
+
+	for (include_recording &recording : _include_recordings)
+		if (std::vector<std::string> &missing_files = recording.header->missing_files;
+			std::find(missing_files.begin(), missing_files.end(), file_path_string) == missing_files.end())
+			missing_files.push_back(file_path_string);
 }
 
 bool reshadefx::preprocessor::evaluate_expression()
@@ -909,7 +1292,7 @@ bool reshadefx::preprocessor::evaluate_expression()
 					return false;
 
 				std::filesystem::path file_name = std::filesystem::u8path(_token.literal_as_string);
-				std::filesystem::path file_path = std::filesystem::u8path(_output_location.source);
+				std::filesystem::path file_path = std::filesystem::u8path(_output_location.source());
 				file_path.replace_filename(file_name);
 
 				if (has_parentheses && !expect(tokenid::parenthesis_close))
@@ -937,6 +1320,8 @@ bool reshadefx::preprocessor::evaluate_expression()
 					return false;
 
 				rpn[rpn_index++] = { is_defined(macro_name) ? 1 : 0, false };
+
+				add_predefined_macro_reference(macro_name);
 				continue;
 			}
 
@@ -1094,30 +1479,30 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 	}
 	if (_token.literal_as_string == "__FILE__")
 	{
-		push(escape_string(_token.location.source));
+		push(escape_string(_token.location.source()));
 		return true;
 	}
 	if (_token.literal_as_string == "__FILE_STEM__")
 	{
-		const std::filesystem::path file_stem = std::filesystem::u8path(_token.location.source).stem();
+		const std::filesystem::path file_stem = std::filesystem::u8path(_token.location.source()).stem();
 		push(escape_string(file_stem.u8string()));
 		return true;
 	}
 	if (_token.literal_as_string == "__FILE_STEM_HASH__")
 	{
-		const std::filesystem::path file_stem = std::filesystem::u8path(_token.location.source).stem();
+		const std::filesystem::path file_stem = std::filesystem::u8path(_token.location.source()).stem();
 		push(std::to_string(std::hash<std::string>()(file_stem.u8string()) & 0xFFFFFFFF));
 		return true;
 	}
 	if (_token.literal_as_string == "__FILE_NAME__")
 	{
-		const std::filesystem::path file_name = std::filesystem::u8path(_token.location.source).filename();
+		const std::filesystem::path file_name = std::filesystem::u8path(_token.location.source()).filename();
 		push(escape_string(file_name.u8string()));
 		return true;
 	}
 	if (_token.literal_as_string == "__FILE_NAME_HASH__")
 	{
-		const std::filesystem::path file_name = std::filesystem::u8path(_token.location.source).filename();
+		const std::filesystem::path file_name = std::filesystem::u8path(_token.location.source()).filename();
 		push(std::to_string(std::hash<std::string>()(file_name.u8string()) & 0xFFFFFFFF));
 		return true;
 	}
@@ -1128,11 +1513,14 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 
 	if (!_input_stack.empty())
 	{
-		const std::unordered_set<std::string> &hidden_macros = _input_stack[_current_input_index].hidden_macros;
-		if (hidden_macros.find(_token.literal_as_string) != hidden_macros.end())
-			return false;
+		for (const hidden_macro *hidden = _input_stack[_current_input_index].hidden_macros.get(); hidden != nullptr; hidden = hidden->parent.get())
+			if (hidden->name == &it->first)
+				return false;
 	}
 
+	if (it->second.is_predefined)
+		add_predefined_macro_reference(it->first);
+
 	const location macro_location = _token.location;
 	if (_recursion_count++ >= 256)
 		return error(macro_location, "macro recursion too high"), false;
@@ -1272,7 +1660,8 @@ void reshadefx::preprocessor::expand_macro(const std::string &name, const macro
 	push(std::move(input));
 
 	// Avoid expanding macros again that are referencing themselves
-	_input_stack[_current_input_index].hidden_macros.insert(name);
+	std::shared_ptr<const hidden_macro> &hidden_macros = _input_stack[_current_input_index].hidden_macros;
+	hidden_macros = std::make_shared<hidden_macro>(hidden_macro { &name, std::move(hidden_macros) });
 }
 
 void reshadefx::preprocessor::create_macro_replacement_list(macro &macro)
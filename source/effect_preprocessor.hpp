@@ -6,7 +6,7 @@
 #pragma once
 
 #include "effect_token.hpp"
-#include <memory> // std::unique_ptr
+#include <memory> // std::shared_ptr, std::unique_ptr
 #include <filesystem>
 #include <unordered_map>
 #include <unordered_set>
@@ -70,6 +70,20 @@ namespace reshadefx
 		/// <returns><see langword="true"/> if parsing was successful, <see langword="false"/> otherwise.</returns>
 		bool append_string(std::string source_code, const std::filesystem::path &path = std::filesystem::path());
 
+		/// <summary>
+		/// Enables precompiled headers, which records the result of preprocessing each included file and replays it when the same file is included again under an identical set of macro definitions.
+		/// Recorded headers are shared between all preprocessor instances in this process.
+		/// </summary>
+		/// <param name="enable">Set to <see langword="true"/> to enable precompiled headers, or <see langword="false"/> to preprocess every included file from scratch.</param>
+		void enable_precompiled_headers(bool enable = true) { _precompiled_headers = enable; }
+
+		/// <summary>
+		/// Removes all files and precompiled headers from the include file cache that is shared between all preprocessor instances in this process.
+		/// Cached files are validated against their last modification time on every access, so this only serves to release memory.
+		/// This also clears the source file names shared by all locations (see <see cref="location::clear_source_names"/>), which only happens once no preprocessor or parser is alive anymore.
+		/// </summary>
+		static void clear_include_cache();
+
 		/// <summary>
 		/// Gets the list of error messages.
 		/// </summary>
@@ -83,11 +97,25 @@ namespace reshadefx
 		/// Gets a list of all included files.
 		/// </summary>
 		std::vector<std::filesystem::path> included_files() const;
+		/// <summary>
+		/// Gets a list of all included files, together with their last modification time at the point they were read.
+		/// </summary>
+		std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> included_files_with_modification_time() const;
+		/// <summary>
+		/// Gets a list of all paths that were tried when resolving #include directives, but did not exist.
+		/// Creating a file at any of these paths may change which file an #include directive resolves to, so they are dependencies too.
+		/// </summary>
+		std::vector<std::filesystem::path> missing_include_files() const;
 
 		/// <summary>
 		/// Gets a list of all defines that were used in #ifdef and #ifndef lines.
 		/// </summary>
 		std::vector<std::pair<std::string, std::string>> used_macro_definitions() const;
+		/// <summary>
+		/// Gets a sorted list of all predefined macros (those added with <see cref="add_macro_definition"/>) that were expanded or checked for being defined.
+		/// The output does not depend on the values of any other predefined macros.
+		/// </summary>
+		std::vector<std::string> referenced_predefined_macros() const;
 
 		/// <summary>
 		/// Gets a list of pragma directives that occured.
@@ -102,12 +130,28 @@ namespace reshadefx
 			token pp_token;
 			size_t input_index;
 		};
+		struct hidden_macro
+		{
+			// Points to the name stored in the macro lookup table, which cannot change while a macro is being expanded
+			const std::string *name;
+			std::shared_ptr<const hidden_macro> parent;
+		};
 		struct input_level
 		{
 			std::string name;
 			std::unique_ptr<class lexer> lexer;
 			token next_token;
-			std::unordered_set<std::string> hidden_macros;
+			// Chain of macros that may not be expanded in this input level, which is shared with parent levels so that pushing a new level does not need to copy it
+			std::shared_ptr<const hidden_macro> hidden_macros;
+		};
+		struct include_recording
+		{
+			size_t input_index;
+			size_t output_offset;
+			size_t errors_offset;
+			size_t used_pragmas_offset;
+			std::vector<std::string> modified_macros;
+			std::shared_ptr<struct precompiled_header> header;
 		};
 
 		void error(const location &location, const std::string &message);
@@ -138,6 +182,14 @@ namespace reshadefx
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
 
+		bool replay_precompiled_header(const std::string &file_path_string);
+		void begin_precompiled_header(const std::string &file_path_string, std::shared_ptr<const std::string> file_data);
+		void end_precompiled_header(bool success);
+		void add_include_dependency(const std::string &file_path_string, const std::shared_ptr<const std::string> &file_data);
+		void add_missing_include_dependency(const std::string &file_path_string);
+		void remove_macro_definition(const std::string &name);
+		void add_predefined_macro_reference(const std::string &name);
+
 		bool is_defined(const std::string &name) const;
 		void expand_macro(const std::string &name, const macro &macro, const std::vector<std::string> &arguments);
 		void create_macro_replacement_list(macro &macro);
@@ -155,11 +207,18 @@ namespace reshadefx
 
 		unsigned short _recursion_count = 0;
 		std::unordered_set<std::string> _used_macros;
+		std::unordered_set<std::string> _referenced_predefined_macros;
 		std::unordered_map<std::string, macro> _macros;
+		size_t _macros_hash = 0;
 
 		std::vector<std::filesystem::path> _include_paths;
-		std::unordered_map<std::string, std::string> _file_cache;
+		std::unordered_map<std::string, std::shared_ptr<const std::string>> _file_cache;
+		std::unordered_map<std::string, std::filesystem::file_time_type> _file_modification_times;
+		std::unordered_set<std::string> _missing_files;
 
 		std::vector<std::pair<std::string, std::string>> _used_pragmas;
+
+		bool _precompiled_headers = false;
+		std::vector<include_recording> _include_recordings;
 	};
 }
@@ -6,8 +6,9 @@
 #include "effect_symbol_table.hpp"
 #include <cassert>
 #include <malloc.h> // alloca
-#include <algorithm> // std::upper_bound, std::sort
+#include <algorithm> // std::remove_if, std::upper_bound, std::sort
 #include <functional> // std::greater
+#include <string_view>
 
 enum class intrinsic_id
 {
@@ -123,6 +124,14 @@ static const intrinsic s_intrinsics[] =
 	#include "effect_symbol_table_intrinsics.inl"
 };
 
+// Lookup table from intrinsic function name to all its overloads (in the order they were defined in)
+static const auto s_intrinsic_lookup = []() {
+	std::unordered_map<std::string_view, std::vector<const intrinsic *>> overloads_by_name;
+	for (const intrinsic &intrinsic : s_intrinsics)
+		overloads_by_name[intrinsic.name].push_back(&intrinsic);
+	return overloads_by_name;
+}();
+
 #undef void
 #undef bool
 #undef bool2
@@ -181,7 +190,8 @@ unsigned int reshadefx::type::rank(const type &src, const type &dst)
 	return rank * src.components(); // More components causes a higher rank
 }
 
-reshadefx::symbol_table::symbol_table()
+reshadefx::symbol_table::symbol_table() :
+	_symbol_stack(&_arena)
 {
 	_current_scope.name = "::";
 	_current_scope.level = 0;
@@ -202,22 +212,17 @@ void reshadefx::symbol_table::leave_scope()
 {
 	assert(_current_scope.level > 0);
 
-	for (auto &symbol : _symbol_stack)
+	// Only look at the symbols that were introduced in this scope, instead of walking the entire symbol stack
+	for (; !_scope_symbols.empty() && _scope_symbols.back().first >= _current_scope.level; _scope_symbols.pop_back())
 	{
-		std::vector<scoped_symbol> &scope_list = symbol.second;
-
-		for (auto scope_it = scope_list.begin(); scope_it != scope_list.end();)
-		{
-			if (scope_it->scope.level > scope_it->scope.namespace_level &&
-				scope_it->scope.level >= _current_scope.level)
-			{
-				scope_it = scope_list.erase(scope_it);
-			}
-			else
-			{
-				++scope_it;
-			}
-		}
+		std::pmr::vector<scoped_symbol> &scope_list = *_scope_symbols.back().second;
+
+		scope_list.erase(
+			std::remove_if(scope_list.begin(), scope_list.end(),
+				[this](const scoped_symbol &symbol) {
+					return symbol.scope.level > symbol.scope.namespace_level && symbol.scope.level >= _current_scope.level;
+				}),
+			scope_list.end());
 	}
 
 	_current_scope.level--;
@@ -271,7 +276,12 @@ bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbo
 	else
 	{
 		// This is a local symbol so it's sufficient to update the symbol stack with just the current scope
-		insert_sorted(_symbol_stack[name], scoped_symbol { symbol, _current_scope });
+		std::pmr::vector<scoped_symbol> &scope_list = _symbol_stack[name];
+		insert_sorted(scope_list, scoped_symbol { symbol, _current_scope });
+
+		// Keep track of symbols that have to be removed again when leaving the current scope (pointers to elements in an unordered map remain valid)
+		if (_current_scope.level > _current_scope.namespace_level)
+			_scope_symbols.emplace_back(_current_scope.level, &scope_list);
 	}
 
 	return true;
@@ -426,26 +436,30 @@ bool reshadefx::symbol_table::resolve_function_call(const std::string &name, con
 	// Try matching against intrinsic functions if no matching user-defined function was found up to this point
 	if (num_overloads == 0)
 	{
-		for (const intrinsic &intrinsic : s_intrinsics)
+		if (const auto intrinsic_it = s_intrinsic_lookup.find(name);
+			intrinsic_it != s_intrinsic_lookup.end())
 		{
-			if (intrinsic.name != name || intrinsic.parameter_list.size() != arguments.size())
-				continue;
+			for (const intrinsic *const intrinsic : intrinsic_it->second)
+			{
+				if (intrinsic->parameter_list.size() != arguments.size())
+					continue;
 
-			// A new possibly-matching intrinsic function was found, compare it against the current result
-			const int comparison = compare_functions(arguments, &intrinsic, result);
+				// A new possibly-matching intrinsic function was found, compare it against the current result
+				const int comparison = compare_functions(arguments, intrinsic, result);
 
-			if (comparison < 0) // The new function is a better match
-			{
-				out_data.op = symbol_type::intrinsic;
-				out_data.id = intrinsic.id;
-				out_data.type = intrinsic.return_type;
-				out_data.function = &intrinsic;
-				result = out_data.function;
-				num_overloads = 1;
-			}
-			else if (comparison == 0 && overload_namespace == 0) // Both functions are equally viable, so the call is ambiguous (intrinsics are always in the global namespace)
-			{
-				++num_overloads;
+				if (comparison < 0) // The new function is a better match
+				{
+					out_data.op = symbol_type::intrinsic;
+					out_data.id = intrinsic->id;
+					out_data.type = intrinsic->return_type;
+					out_data.function = intrinsic;
+					result = out_data.function;
+					num_overloads = 1;
+				}
+				else if (comparison == 0 && overload_namespace == 0) // Both functions are equally viable, so the call is ambiguous (intrinsics are always in the global namespace)
+				{
+					++num_overloads;
+				}
 			}
 		}
 	}
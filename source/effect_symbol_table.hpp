@@ -7,6 +7,7 @@
 
 #include "effect_module.hpp"
 #include <unordered_map> // Used for symbol lookup table
+#include <memory_resource>
 
 namespace reshadefx
 {
@@ -96,8 +97,12 @@ namespace reshadefx
 		bool resolve_function_call(const std::string &name, const std::vector<expression> &args, const scope &scope, symbol &data, bool &ambiguous) const;
 
 	private:
+		// Memory for the lookup table below, which is released all at once when the symbol table is destroyed
+		std::pmr::monotonic_buffer_resource _arena;
 		scope _current_scope;
 		// Lookup table from name to matching symbols
-		std::unordered_map<std::string, std::vector<scoped_symbol>> _symbol_stack;
+		std::pmr::unordered_map<std::string, std::pmr::vector<scoped_symbol>> _symbol_stack;
+		// List of symbol stack entries that local symbols were added to, together with the scope level they were added in
+		std::vector<std::pair<uint32_t, std::pmr::vector<scoped_symbol> *>> _scope_symbols;
 	};
 }
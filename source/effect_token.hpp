@@ -18,10 +18,34 @@ namespace reshadefx
 	{
 		location() : line(1), column(1) {}
 		explicit location(uint32_t line, uint32_t column = 1) : line(line), column(column) {}
-		explicit location(std::string source, uint32_t line, uint32_t column = 1) : source(std::move(source)), line(line), column(column) {}
+		explicit location(const std::string &source, uint32_t line, uint32_t column = 1) : line(line), column(column) { set_source(source); }
+
+		/// <summary>
+		/// Gets the name of the source file this location refers to, or an empty string if there is none.
+		/// </summary>
+		const std::string &source() const { static const std::string empty; return _source != nullptr ? *_source : empty; }
+		/// <summary>
+		/// Changes the name of the source file this location refers to.
+		/// Names are interned into a table shared by all locations, so that copying a location does not need to copy the name.
+		/// </summary>
+		/// <param name="source">Name of the source file.</param>
+		void set_source(const std::string &source);
+
+		/// <summary>
+		/// Removes all names from the table shared by all locations, to release its memory.
+		/// This is deferred until no preprocessor or parser is alive anymore (see <see cref="acquire_source_names"/>). Locations kept around after that (e.g. in an effect module) no longer have a valid source file name.
+		/// </summary>
+		static void clear_source_names();
+		/// <summary>
+		/// Keeps the table of names shared by all locations alive until a matching call to <see cref="release_source_names"/>.
+		/// </summary>
+		static void acquire_source_names();
+		static void release_source_names();
 
-		std::string source;
 		uint32_t line, column;
+
+	private:
+		const std::string *_source = nullptr;
 	};
 
 	/// <summary>
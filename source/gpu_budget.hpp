@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <numeric> // std::iota
+#include <algorithm> // std::max, std::stable_sort
+
+namespace reshade
+{
+	/// <summary>
+	/// How often a technique is rendered while a GPU time budget is in effect.
+	/// </summary>
+	enum class technique_rate : uint8_t
+	{
+		every_frame,
+		every_other_frame,
+		skipped
+	};
+
+	/// <summary>
+	/// Per-technique input and output of the GPU time budget scheduler.
+	/// </summary>
+	struct technique_schedule
+	{
+		bool should_render(uint64_t frame_count) const
+		{
+			return rate == technique_rate::every_frame || (rate == technique_rate::every_other_frame && (frame_count % 2) == frame_parity);
+		}
+
+		// Average GPU time a single execution of the technique takes in nanoseconds, or zero if it was not measured yet
+		uint64_t gpu_duration = 0;
+		// Techniques with a lower priority are throttled before those with a higher one
+		int priority = 0;
+		// Only techniques whose results persist between frames (because all passes render to effect textures) can run every other frame, the others would flicker
+		bool allow_half_rate = true;
+
+		technique_rate rate = technique_rate::every_frame;
+		// Frames (even or odd) on which the technique is rendered when it runs every other frame
+		uint32_t frame_parity = 0;
+	};
+
+	/// <summary>
+	/// Assigns a rate to each technique so that the GPU time spent per frame stays within the specified budget.
+	/// Techniques are throttled in order of ascending priority (and descending cost within the same priority): all techniques of a priority level first run every other frame, then get skipped, before any of the next level are touched.
+	/// Techniques that do not allow half rate are never run every other frame, but skipped along with the others of their priority level instead.
+	/// Techniques running every other frame are spread across even and odd frames so that their cost is split evenly between the two.
+	/// </summary>
+	/// <param name="schedules">List of techniques to schedule, whose <see cref="technique_schedule::rate"/> and <see cref="technique_schedule::frame_parity"/> are updated.</param>
+	/// <param name="budget">GPU time available per frame in nanoseconds.</param>
+	/// <returns>Expected GPU time of the more expensive of two consecutive frames with the assigned rates.</returns>
+	inline uint64_t schedule_techniques(std::vector<technique_schedule> &schedules, uint64_t budget)
+	{
+		uint64_t every_frame_cost = 0;
+		uint64_t every_other_frame_cost[2] = { 0, 0 };
+
+		for (technique_schedule &schedule : schedules)
+		{
+			schedule.rate = technique_rate::every_frame;
+			schedule.frame_parity = 0;
+			every_frame_cost += schedule.gpu_duration;
+		}
+
+		const auto frame_cost = [&]() {
+			return every_frame_cost + std::max(every_other_frame_cost[0], every_other_frame_cost[1]);
+		};
+
+		if (every_frame_cost <= budget)
+			return every_frame_cost;
+
+		std::vector<size_t> order(schedules.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+			[&schedules](size_t lhs, size_t rhs) {
+				return schedules[lhs].priority < schedules[rhs].priority || (schedules[lhs].priority == schedules[rhs].priority && schedules[lhs].gpu_duration > schedules[rhs].gpu_duration);
+			});
+
+		for (size_t level_begin = 0, level_end = 0; level_begin < order.size(); level_begin = level_end)
+		{
+			while (level_end < order.size() && schedules[order[level_end]].priority == schedules[order[level_begin]].priority)
+				++level_end;
+
+			// Halve the rate of all techniques in this priority level before skipping any of them
+			for (size_t i = level_begin; i < level_end; ++i)
+			{
+				technique_schedule &schedule = schedules[order[i]];
+				if (schedule.gpu_duration == 0 || !schedule.allow_half_rate)
+					continue;
+
+				schedule.rate = technique_rate::every_other_frame;
+				schedule.frame_parity = every_other_frame_cost[1] < every_other_frame_cost[0] ? 1 : 0;
+				every_frame_cost -= schedule.gpu_duration;
+				every_other_frame_cost[schedule.frame_parity] += schedule.gpu_duration;
+
+				if (frame_cost() <= budget)
+					return frame_cost();
+			}
+
+			for (size_t i = level_begin; i < level_end; ++i)
+			{
+				technique_schedule &schedule = schedules[order[i]];
+				if (schedule.rate == technique_rate::every_other_frame)
+					every_other_frame_cost[schedule.frame_parity] -= schedule.gpu_duration;
+				else if (schedule.gpu_duration != 0 && !schedule.allow_half_rate)
+					every_frame_cost -= schedule.gpu_duration;
+				else
+					continue;
+
+				schedule.rate = technique_rate::skipped;
+
+				if (frame_cost() <= budget)
+				{
+					// Skipping may have freed up enough time to render some of the techniques that were halved before again every frame
+					for (size_t k = level_end; k-- > level_begin;)
+					{
+						technique_schedule &other = schedules[order[k]];
+						if (other.rate != technique_rate::every_other_frame)
+							continue;
+
+						every_frame_cost += other.gpu_duration;
+						every_other_frame_cost[other.frame_parity] -= other.gpu_duration;
+
+						if (frame_cost() <= budget)
+						{
+							other.rate = technique_rate::every_frame;
+							other.frame_parity = 0;
+						}
+						else
+						{
+							every_frame_cost -= other.gpu_duration;
+							every_other_frame_cost[other.frame_parity] += other.gpu_duration;
+						}
+					}
+
+					return frame_cost();
+				}
+			}
+		}
+
+		return frame_cost();
+	}
+}
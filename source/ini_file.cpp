@@ -7,12 +7,20 @@
 #include <shared_mutex>
 #include <cctype> // std::toupper
 #include <cassert>
-#include <algorithm> // std::min, std::sort, std::transform
+#include <algorithm> // std::count, std::lexicographical_compare, std::min, std::sort
 #include <utf8/core.h>
 
 static std::shared_mutex s_ini_cache_mutex;
 static std::unordered_map<std::wstring, std::unique_ptr<ini_file>> s_ini_cache;
 
+static bool compare_case_insensitive(const std::string_view a, const std::string_view b)
+{
+	return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+		[](char lhs, char rhs) {
+			return std::toupper(static_cast<unsigned char>(lhs)) < std::toupper(static_cast<unsigned char>(rhs));
+		});
+}
+
 ini_file &reshade::global_config()
 {
 	return ini_file::load_cache(g_reshade_base_path / L"ReShade.ini");
@@ -32,31 +40,45 @@ bool ini_file::load()
 
 	// Clear when file does not exist too
 	_sections.clear();
+	_names.clear();
+	_file_data.clear();
 
-	FILE *const file = _wfsopen(_path.c_str(), L"r", SH_DENYWR);
+	// Open in binary mode, so that the file size matches the amount of data read below (carriage returns are trimmed during parsing instead)
+	FILE *const file = _wfsopen(_path.c_str(), L"rb", SH_DENYWR);
 	if (file == nullptr)
 		return false;
 
 	_modified = false;
 	_modified_at = modified_at;
 
-	// Remove BOM (0xefbbbf means 0xfeff)
-	if (fgetc(file) != utf8::bom[0] || fgetc(file) != utf8::bom[1] || fgetc(file) != utf8::bom[2])
-		fseek(file, 0, SEEK_SET);
-
-	std::string line_data, section;
-	line_data.resize(BUFSIZ);
-	while (fgets(line_data.data(), static_cast<int>(line_data.size() + 1), file))
+	// Read the entire file at once and parse it in a single pass, instead of going line by line
+	// The file data is kept around afterwards, since the section and key names reference it
+	if (fseek(file, 0, SEEK_END) == 0)
 	{
-		size_t line_length;
-		while ((line_length = std::strlen(line_data.data())) == line_data.size() && line_data.back() != '\n')
+		if (const long file_size = ftell(file); file_size > 0 && fseek(file, 0, SEEK_SET) == 0)
 		{
-			line_data.resize(line_data.size() + BUFSIZ);
-			if (!fgets(line_data.data() + line_length, static_cast<int>(line_data.size() - line_length + 1), file))
-				break;
+			_file_data.resize(static_cast<size_t>(file_size));
+			_file_data.resize(fread(_file_data.data(), 1, _file_data.size(), file));
 		}
+	}
+
+	fclose(file);
+
+	std::string_view data = _file_data;
+
+	// Remove BOM (0xefbbbf means 0xfeff)
+	if (data.size() >= 3 && static_cast<uint8_t>(data[0]) == utf8::bom[0] && static_cast<uint8_t>(data[1]) == utf8::bom[1] && static_cast<uint8_t>(data[2]) == utf8::bom[2])
+		data.remove_prefix(3);
 
-		const std::string_view line = trim(std::string_view(line_data.data(), line_length), " \t\r\n");
+	// Look up the section only once when it is first used, rather than for every key in it
+	std::string_view section_name;
+	section_type *section = nullptr;
+
+	for (size_t line_offset = 0; line_offset < data.size();)
+	{
+		const size_t line_end = std::min(data.find('\n', line_offset), data.size());
+		const std::string_view line = trim(data.substr(line_offset, line_end - line_offset), " \t\r\n");
+		line_offset = line_end + 1;
 
 		if (line.empty() || line[0] == ';' || line[0] == '/' || line[0] == '#')
 			continue;
@@ -64,10 +86,14 @@ bool ini_file::load()
 		// Read section name
 		if (line[0] == '[')
 		{
-			section = trim(line.substr(0, line.find(']')), " \t[]");
+			section_name = trim(line.substr(0, line.find(']')), " \t[]");
+			section = nullptr;
 			continue;
 		}
 
+		if (section == nullptr)
+			section = &_sections[section_name];
+
 		// Read section content
 		const size_t assign_index = line.find('=');
 		if (assign_index != std::string::npos)
@@ -77,12 +103,14 @@ bool ini_file::load()
 
 			if (value.empty())
 			{
-				_sections[section].insert({ std::string(key), {} });
+				section->try_emplace(key);
 				continue;
 			}
 
 			// Append to key if it already exists
-			ini_file::value_type &elements = _sections[section][std::string(key)];
+			ini_file::value_type &elements = (*section)[key];
+			elements.reserve(elements.size() + std::count(value.begin(), value.end(), ',') + 1);
+
 			for (size_t offset = 0, base = 0, len = value.size(); offset <= len;)
 			{
 				// Treat ",," as an escaped comma and only split on single ","
@@ -94,15 +122,24 @@ bool ini_file::load()
 				else
 				{
 					std::string &element = elements.emplace_back();
-					element.reserve(found - base);
 
-					while (base < found)
+					// Only need to unescape when an escaped comma was skipped over above
+					if (offset == base)
+					{
+						element.assign(value.data() + base, found - base);
+					}
+					else
 					{
-						const char c = value[base++];
-						element += c;
+						element.reserve(found - base);
 
-						if (c == ',' && base < found && value[base] == ',')
-							base++; // Skip second comma in a ",," escape sequence
+						while (base < found)
+						{
+							const char c = value[base++];
+							element += c;
+
+							if (c == ',' && base < found && value[base] == ',')
+								base++; // Skip second comma in a ",," escape sequence
+						}
 					}
 
 					offset = base = found + 1;
@@ -111,12 +148,10 @@ bool ini_file::load()
 		}
 		else
 		{
-			_sections[section].insert({ std::string(line), {} });
+			section->try_emplace(line);
 		}
 	}
 
-	fclose(file);
-
 	return true;
 }
 bool ini_file::save()
@@ -132,75 +167,74 @@ bool ini_file::save()
 	if (!ec && (modified_at - _modified_at) > std::chrono::seconds(2))
 		return false; // File exists and was modified on disk and therefore may have different data, so cannot save
 
-	std::string data;
-	std::vector<std::string> section_names, key_names;
+	// Sort sections and keys by pointing at the entries directly, to avoid copying their names
+	std::vector<const std::pair<const std::string_view, section_type> *> sections;
+	std::vector<const std::pair<const std::string_view, value_type> *> keys;
 
-	section_names.reserve(_sections.size());
-	for (const std::pair<const std::string, section_type> &section : _sections)
-		section_names.push_back(section.first);
+	sections.reserve(_sections.size());
+	for (const std::pair<const std::string_view, section_type> &section : _sections)
+		sections.push_back(&section);
 
 	// Sort sections to generate consistent files
-	std::sort(section_names.begin(), section_names.end(),
-		[](std::string a, std::string b) {
-			std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-			std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-			return a < b;
-		});
+	std::sort(sections.begin(), sections.end(),
+		[](const auto *a, const auto *b) { return compare_case_insensitive(a->first, b->first); });
 
-	for (const std::string &section_name : section_names)
+	std::string data;
+
+	for (const std::pair<const std::string_view, section_type> *const section : sections)
 	{
-		if (const section_type &keys = _sections.at(section_name); !keys.empty())
+		if (section->second.empty())
+			continue;
+
+		keys.clear();
+		keys.reserve(section->second.size());
+		for (const std::pair<const std::string_view, value_type> &key : section->second)
+			keys.push_back(&key);
+
+		std::sort(keys.begin(), keys.end(),
+			[](const auto *a, const auto *b) { return compare_case_insensitive(a->first, b->first); });
+
+		// Empty section should have been sorted to the top, so do not need to append it before keys
+		if (!section->first.empty())
 		{
-			key_names.clear();
-			key_names.reserve(keys.size());
-			for (const std::pair<const std::string, value_type> &key : keys)
-				key_names.push_back(key.first);
-
-			std::sort(key_names.begin(), key_names.end(),
-				[](std::string a, std::string b) {
-					std::transform(a.begin(), a.end(), a.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-					std::transform(b.begin(), b.end(), b.begin(), [](std::string::value_type c) { return static_cast<std::string::value_type>(std::toupper(c)); });
-					return a < b;
-				});
-
-			// Empty section should have been sorted to the top, so do not need to append it before keys
-			if (!section_name.empty())
-				data += '[' + section_name + ']' + '\n';
-
-			for (const std::string &key_name : key_names)
-			{
-				data += key_name + '=';
+			data += '[';
+			data += section->first;
+			data += ']';
+			data += '\n';
+		}
 
-				if (const ini_file::value_type &elements = keys.at(key_name); !elements.empty())
-				{
-					std::string value;
-					for (const std::string &element : elements)
-					{
-						// Empty elements mess with escaped commas, so simply skip them
-						if (element.empty())
-							continue;
-
-						value.reserve(value.size() + element.size() + 1);
-						for (const char c : element)
-							value.append(c == ',' ? 2 : 1, c);
-						value += ','; // Separate multiple values with a comma
-					}
+		for (const std::pair<const std::string_view, value_type> *const key : keys)
+		{
+			data += key->first;
+			data += '=';
 
-					// Remove the last comma
-					if (!value.empty())
-					{
-						assert(value.back() == ',');
-						value.pop_back();
-					}
+			bool first_element = true;
+			for (const std::string &element : key->second)
+			{
+				// Empty elements mess with escaped commas, so simply skip them
+				if (element.empty())
+					continue;
 
-					data += value;
-				}
+				// Separate multiple values with a comma
+				if (!first_element)
+					data += ',';
+				first_element = false;
 
-				data += '\n';
+				if (element.find(',') == std::string::npos)
+				{
+					data += element;
+				}
+				else
+				{
+					for (const char c : element)
+						data.append(c == ',' ? 2 : 1, c);
+				}
 			}
 
 			data += '\n';
 		}
+
+		data += '\n';
 	}
 
 	FILE *const file = _wfsopen(_path.c_str(), L"w", SH_DENYWR);
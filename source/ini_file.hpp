@@ -9,6 +9,8 @@
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm> // std::none_of
 
 extern std::filesystem::path g_reshade_dll_path;
 extern std::filesystem::path g_reshade_base_path;
@@ -28,6 +30,8 @@ public:
 	/// </summary>
 	/// <param name="path">Path to the INI file to access.</param>
 	explicit ini_file(const std::filesystem::path &path);
+	ini_file(const ini_file &) = delete;
+	ini_file &operator=(const ini_file &) = delete;
 
 	/// <summary>
 	/// Gets the path to this INI file.
@@ -141,14 +145,14 @@ public:
 	template <>
 	void set(const std::string &section, const std::string &key, const std::string &value)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.assign(1, value);
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
 	void set(const std::string &section, const std::string &key, std::string &&value)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.resize(1);
 		v[0] = std::forward<std::string>(value);
 		_modified = true;
@@ -162,7 +166,7 @@ public:
 	template <typename T, size_t SIZE>
 	void set(const std::string &section, const std::string &key, const T(&values)[SIZE], const size_t size = SIZE)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.resize(size);
 		for (size_t i = 0; i < size; ++i)
 			v[i] = std::to_string(values[i]);
@@ -172,7 +176,7 @@ public:
 	template <typename T>
 	void set(const std::string &section, const std::string &key, const std::vector<T> &values)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.resize(values.size());
 		for (size_t i = 0; i < values.size(); ++i)
 			v[i] = std::to_string(values[i]);
@@ -182,14 +186,14 @@ public:
 	template <>
 	void set(const std::string &section, const std::string &key, const std::vector<std::string> &values)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v = values;
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
 	void set(const std::string &section, const std::string &key, std::vector<std::string> &&values)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v = std::forward<std::vector<std::string>>(values);
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
@@ -197,7 +201,7 @@ public:
 	template <>
 	void set(const std::string &section, const std::string &key, const std::vector<std::pair<std::string, std::string>> &values)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.resize(values.size());
 		for (size_t i = 0; i < values.size(); ++i)
 		{
@@ -212,7 +216,7 @@ public:
 	template <>
 	void set(const std::string &section, const std::string &key, const std::vector<std::filesystem::path> &values)
 	{
-		auto &v = _sections[section][key];
+		auto &v = find_or_insert(section, key);
 		v.resize(values.size());
 		for (size_t i = 0; i < values.size(); ++i)
 			v[i] = values[i].u8string();
@@ -226,6 +230,7 @@ public:
 	void clear()
 	{
 		_sections.clear();
+		_names.clear();
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
@@ -241,7 +246,13 @@ public:
 		const auto it2 = it1->second.find(key);
 		if (it2 == it1->second.end())
 			return;
+		const std::string_view name = it2->first;
 		it1->second.erase(it2);
+		// Release the name again if it was interned after loading and is no longer referenced, so that repeatedly adding and removing keys does not grow the set
+		if (const auto it3 = _names.find(key);
+			it3 != _names.end() && it3->data() == name.data() && _sections.find(name) == _sections.end() &&
+			std::none_of(_sections.begin(), _sections.end(), [name](const auto &section) { return section.second.find(name) != section.second.end(); }))
+			_names.erase(it3);
 		_modified = true;
 		_modified_at = std::filesystem::file_time_type::clock::now();
 	}
@@ -347,10 +358,25 @@ private:
 	/// <summary>
 	/// Describes a section of multiple key/value pairs in an INI file.
 	/// </summary>
-	using section_type = std::unordered_map<std::string, value_type>;
+	using section_type = std::unordered_map<std::string_view, value_type>;
+
+	value_type &find_or_insert(const std::string &section, const std::string &key)
+	{
+		auto it1 = _sections.find(section);
+		if (it1 == _sections.end())
+			it1 = _sections.emplace(*_names.insert(section).first, section_type()).first;
+		auto it2 = it1->second.find(key);
+		if (it2 == it1->second.end())
+			it2 = it1->second.emplace(*_names.insert(key).first, value_type()).first;
+		return it2->second;
+	}
 
 	const std::filesystem::path _path;
-	std::unordered_map<std::string, section_type> _sections;
+	std::unordered_map<std::string_view, section_type> _sections;
+	// Section and key names are not stored in the maps themselves, but interned here and referenced by them
+	// Names read from disk point into the file data, while names added afterwards are kept in a separate set
+	std::string _file_data;
+	std::unordered_set<std::string> _names;
 	bool _modified = false;
 	std::filesystem::file_time_type _modified_at;
 };
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "job_system.hpp"
+#include <cassert>
+#include <algorithm> // std::find_if, std::max, std::min
+
+// Used to push jobs submitted from within a job onto the queue of the worker thread that runs it
+static thread_local const reshade::job_system *s_current_job_system = nullptr;
+static thread_local size_t s_current_worker_index = std::numeric_limits<size_t>::max();
+
+reshade::job_system::job_system(unsigned int max_threads)
+{
+	const unsigned int num_threads = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, std::max(max_threads, 1u));
+
+	_workers.reserve(num_threads);
+	for (unsigned int i = 0; i < num_threads; ++i)
+		_workers.push_back(std::make_unique<worker>());
+}
+reshade::job_system::~job_system()
+{
+	{ const std::unique_lock<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_wake_condition.notify_all();
+
+	// Any jobs that were still queued are discarded along with the worker queues
+	for (const std::unique_ptr<worker> &worker : _workers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+}
+
+void reshade::job_system::submit(group &group, std::function<void()> func, priority priority)
+{
+	std::call_once(_start_flag, &job_system::start_threads, this);
+
+	group._pending++;
+
+	// Keep jobs submitted from a worker thread local to it, others are distributed across all queues
+	size_t worker_index = s_current_worker_index;
+	if (s_current_job_system != this)
+		worker_index = _next_worker_index++ % _workers.size();
+
+	{ worker &worker = *_workers[worker_index];
+		const std::unique_lock<std::mutex> lock(worker.mutex);
+		worker.queues[static_cast<size_t>(priority)].push_back({ &group, std::move(func) });
+		_num_queued++;
+	}
+
+	{ const std::unique_lock<std::mutex> lock(_mutex);
+		_wake_condition.notify_one();
+	}
+}
+
+void reshade::job_system::wait(group &group)
+{
+	const size_t worker_index = (s_current_job_system == this) ? s_current_worker_index : 0;
+
+	while (group._pending != 0)
+	{
+		if (job job; pop_job(worker_index, &group, job))
+		{
+			execute_job(job);
+			continue;
+		}
+
+		// All remaining jobs of the group are running on other threads, so wait for them to finish
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done_condition.wait(lock, [&group]() { return group._pending == 0; });
+	}
+}
+void reshade::job_system::cancel(group &group)
+{
+	group._cancelled = true;
+	wait(group);
+	group._cancelled = false;
+}
+
+void reshade::job_system::start_threads()
+{
+	for (size_t worker_index = 0; worker_index < _workers.size(); ++worker_index)
+		_workers[worker_index]->thread = std::thread(&job_system::worker_main, this, worker_index);
+}
+
+void reshade::job_system::worker_main(size_t worker_index)
+{
+	s_current_job_system = this;
+	s_current_worker_index = worker_index;
+
+	while (true)
+	{
+		if (job job; pop_job(worker_index, nullptr, job))
+		{
+			execute_job(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_wake_condition.wait(lock, [this]() { return _stop || _num_queued != 0; });
+
+		if (_stop)
+			break;
+	}
+}
+
+bool reshade::job_system::pop_job(size_t worker_index, const group *group, job &job)
+{
+	const size_t num_workers = _workers.size();
+
+	for (int priority_index = static_cast<int>(priority::high); priority_index >= static_cast<int>(priority::low); --priority_index)
+	{
+		// Start with the own queue and only then steal from the others
+		for (size_t offset = 0; offset < num_workers; ++offset)
+		{
+			worker &worker = *_workers[(worker_index + offset) % num_workers];
+
+			const std::unique_lock<std::mutex> lock(worker.mutex);
+
+			std::deque<reshade::job_system::job> &queue = worker.queues[priority_index];
+			if (queue.empty())
+				continue;
+
+			if (group != nullptr)
+			{
+				// Only pick up jobs of the group that is being waited on, to avoid getting stuck in an unrelated long-running job
+				if (const auto it = std::find_if(queue.begin(), queue.end(), [group](const reshade::job_system::job &queued_job) { return queued_job.group == group; });
+					it != queue.end())
+				{
+					job = std::move(*it);
+					queue.erase(it);
+				}
+				else
+				{
+					continue;
+				}
+			}
+			else if (offset == 0)
+			{
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+			else
+			{
+				job = std::move(queue.back());
+				queue.pop_back();
+			}
+
+			_num_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void reshade::job_system::execute_job(job &job)
+{
+	reshade::job_system::group &group = *job.group;
+
+	if (!group.is_cancelled())
+		job.func();
+
+	// Release any resources held by the function before reporting that the job has finished
+	job.func = nullptr;
+
+	if (--group._pending == 0)
+	{
+		const std::unique_lock<std::mutex> lock(_mutex);
+		_done_condition.notify_all();
+	}
+}
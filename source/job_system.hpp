@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace reshade
+{
+	/// <summary>
+	/// A pool of persistent worker threads that execute jobs in order of their priority.
+	/// Every worker thread has its own queue and steals jobs from the queues of the others once it runs out, so that long-running jobs do not hold up the rest.
+	/// </summary>
+	class job_system
+	{
+	public:
+		enum class priority
+		{
+			low,
+			normal,
+			high,
+		};
+
+		/// <summary>
+		/// A set of jobs that can be waited on or cancelled together.
+		/// </summary>
+		class group
+		{
+			friend class job_system;
+
+		public:
+			group() = default;
+			group(const group &) = delete;
+			group &operator=(const group &) = delete;
+
+			/// <summary>
+			/// Checks whether the jobs in this group were cancelled, which long-running jobs can use to abort early.
+			/// </summary>
+			bool is_cancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+		private:
+			std::atomic<size_t> _pending = 0;
+			std::atomic<bool> _cancelled = false;
+		};
+
+		/// <summary>
+		/// Creates a job system with one less worker thread than there are hardware threads, but no more than <paramref name="max_threads"/>.
+		/// The worker threads are only started once the first job is submitted.
+		/// </summary>
+		explicit job_system(unsigned int max_threads = std::numeric_limits<unsigned int>::max());
+		~job_system();
+
+		/// <summary>
+		/// Adds a job to the specified <paramref name="group"/> and queues it for execution on a worker thread.
+		/// </summary>
+		/// <param name="group">Group to add the job to, which has to stay alive until all its jobs have finished.</param>
+		/// <param name="func">Function to execute.</param>
+		/// <param name="priority">Jobs with a higher priority are always picked up before those with a lower priority.</param>
+		void submit(group &group, std::function<void()> func, priority priority = priority::normal);
+
+		/// <summary>
+		/// Waits for all jobs in the specified <paramref name="group"/> to finish.
+		/// The calling thread helps out by executing jobs of the group that have not been picked up by a worker thread yet, so this is safe to call from within a job.
+		/// </summary>
+		void wait(group &group);
+		/// <summary>
+		/// Discards all jobs in the specified <paramref name="group"/> that have not started yet and waits for those that have to finish.
+		/// </summary>
+		void cancel(group &group);
+
+	private:
+		struct job
+		{
+			job_system::group *group = nullptr;
+			std::function<void()> func;
+		};
+		struct worker
+		{
+			std::mutex mutex;
+			std::deque<job> queues[3];
+			std::thread thread;
+		};
+
+		void start_threads();
+		void worker_main(size_t worker_index);
+		bool pop_job(size_t worker_index, const group *group, job &job);
+		void execute_job(job &job);
+
+		std::vector<std::unique_ptr<worker>> _workers;
+		std::once_flag _start_flag;
+		std::atomic<size_t> _num_queued = 0;
+		std::atomic<size_t> _next_worker_index = 0;
+		std::mutex _mutex;
+		std::condition_variable _wake_condition;
+		std::condition_variable _done_condition;
+		bool _stop = false;
+	};
+}
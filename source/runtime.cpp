@@ -19,7 +19,6 @@
 #include "platform_utils.hpp"
 #include "reshade_api_object_impl.hpp"
 #include <set>
-#include <thread>
 #include <cmath> // std::abs, std::fmod
 #include <cctype> // std::toupper
 #include <cwctype> // std::towlower
@@ -27,7 +26,7 @@
 #include <cstdlib> // std::malloc, std::rand, std::strtod, std::strtol
 #include <cstring> // std::memcpy, std::memset, std::strlen
 #include <charconv> // std::to_chars
-#include <algorithm> // std::all_of, std::copy_n, std::equal, std::fill_n, std::find, std::find_if, std::for_each, std::max, std::min, std::replace, std::remove, std::remove_if, std::reverse, std::search, std::set_symmetric_difference, std::sort, std::stable_sort, std::swap, std::transform
+#include <algorithm> // std::all_of, std::any_of, std::copy_n, std::equal, std::fill_n, std::find, std::find_if, std::for_each, std::max, std::min, std::replace, std::remove, std::remove_if, std::reverse, std::search, std::set_symmetric_difference, std::sort, std::stable_sort, std::swap, std::transform
 #include <fpng.h>
 #include <stb_image.h>
 #include <stb_image_dds.h>
@@ -123,6 +122,46 @@ static bool find_file(const std::vector<std::filesystem::path> &search_paths, st
 
 	return false;
 }
+/// <summary>
+/// Checks that none of the files listed in the dependency list at the start of a cached preprocessed source have changed.
+/// Each entry is written as "// #include path?time", with an empty modification time for files that did not exist and must not exist now either.
+/// </summary>
+static bool is_effect_cache_up_to_date(const std::string &source)
+{
+	std::error_code ec;
+
+	for (size_t offset = 0, next; source.compare(offset, 3, "// ") == 0; offset = next + 1)
+	{
+		offset += 3;
+		next = source.find('\n', offset);
+		if (next == std::string::npos)
+			break;
+
+		if (source.compare(offset, 9, "#include ") != 0)
+			continue;
+		offset += 9;
+
+		const size_t separator_index = source.rfind('?', next);
+		if (separator_index == std::string::npos || separator_index < offset)
+			return false;
+
+		const std::filesystem::path path = std::filesystem::u8path(source.begin() + offset, source.begin() + separator_index);
+
+		if (separator_index + 1 == next)
+		{
+			if (std::filesystem::exists(path, ec))
+				return false;
+		}
+		else
+		{
+			const std::filesystem::file_time_type modified_at = std::filesystem::last_write_time(path, ec);
+			if (ec || source.compare(separator_index + 1, next - (separator_index + 1), std::to_string(modified_at.time_since_epoch().count())) != 0)
+				return false;
+		}
+	}
+
+	return true;
+}
 static std::vector<std::filesystem::path> find_files(const std::vector<std::filesystem::path> &search_paths, std::initializer_list<std::filesystem::path> extensions)
 {
 	std::error_code ec;
@@ -240,7 +279,6 @@ reshade::runtime::runtime(api::swapchain *swapchain, api::command_queue *graphic
 }
 reshade::runtime::~runtime()
 {
-	assert(_worker_threads.empty());
 	assert(!_is_initialized && _techniques.empty() && _technique_sorting.empty());
 
 #if RESHADE_GUI
@@ -926,11 +964,14 @@ void reshade::runtime::load_config()
 	config_get("INPUT", "KeyPreviousPreset", _prev_preset_key_data);
 	config_get("INPUT", "KeyReload", _reload_key_data);
 
+	config_get("GENERAL", "AliasTransientTextures", _alias_transient_textures);
 	config_get("GENERAL", "NoDebugInfo", _no_debug_info);
 	config_get("GENERAL", "NoEffectCache", _no_effect_cache);
 	config_get("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+	config_get("GENERAL", "OptimizeSpirv", _optimize_spirv);
 
 	config_get("GENERAL", "EffectSearchPaths", _effect_search_paths);
+	config_get("GENERAL", "GPUTimeBudget", _gpu_time_budget);
 	config_get("GENERAL", "PerformanceMode", _performance_mode);
 	config_get("GENERAL", "PreprocessorDefinitions", _global_preprocessor_definitions);
 	config_get("GENERAL", "SkipLoadingDisabledEffects", _effect_load_skipping);
@@ -1005,11 +1046,14 @@ void reshade::runtime::save_config() const
 	config.set("INPUT", "KeyPreviousPreset", _prev_preset_key_data);
 	config.set("INPUT", "KeyReload", _reload_key_data);
 
+	config.set("GENERAL", "AliasTransientTextures", _alias_transient_textures);
 	config.set("GENERAL", "NoDebugInfo", _no_debug_info);
 	config.set("GENERAL", "NoEffectCache", _no_effect_cache);
 	config.set("GENERAL", "NoReloadOnInit", _no_reload_on_init);
+	config.set("GENERAL", "OptimizeSpirv", _optimize_spirv);
 
 	config.set("GENERAL", "EffectSearchPaths", _effect_search_paths);
+	config.set("GENERAL", "GPUTimeBudget", _gpu_time_budget);
 	config.set("GENERAL", "PerformanceMode", _performance_mode);
 	config.set("GENERAL", "PreprocessorDefinitions", _global_preprocessor_definitions);
 	config.set("GENERAL", "SkipLoadingDisabledEffects", _effect_load_skipping);
@@ -1227,6 +1271,10 @@ void reshade::runtime::load_current_preset()
 		if (!preset.get({}, "Key" + unique_name, tech.toggle_key_data) &&
 			!preset.get({}, "Key" + tech.name, tech.toggle_key_data))
 			std::memset(tech.toggle_key_data, 0, sizeof(tech.toggle_key_data));
+
+		// Preset can override the "priority" annotation used when throttling techniques to stay within the GPU time budget
+		if (!preset.get({}, "Priority" + unique_name, tech.schedule.priority))
+			tech.schedule.priority = tech.annotation_as_int("priority");
 	}
 
 	// Reverse queue so that effects are enabled in the order they are defined in the preset (since the queue is worked from back to front)
@@ -1264,6 +1312,11 @@ void reshade::runtime::save_current_preset(ini_file &preset) const
 			preset.set({}, "Key" + unique_name, tech.toggle_key_data);
 		else
 			preset.remove_key({}, "Key" + unique_name);
+
+		if (tech.schedule.priority != tech.annotation_as_int("priority"))
+			preset.set({}, "Priority" + unique_name, tech.schedule.priority);
+		else
+			preset.remove_key({}, "Priority" + unique_name);
 	}
 
 	if (preset.has({}, "TechniqueSorting") || !std::equal(technique_list.cbegin(), technique_list.cend(), sorted_technique_list.cbegin()))
@@ -1408,6 +1461,102 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 	return true;
 }
 
+static bool is_transient_texture(const reshadefx::effect_module &module, const reshadefx::texture &tex)
+{
+	if (!tex.semantic.empty() || !tex.render_target || tex.storage_access)
+		return false;
+
+	// Contents of the texture only live within a single technique if all uses are in that technique and the first one overwrites everything, so that nothing from a previous frame or another technique can be read
+	const reshadefx::technique *used_by_technique = nullptr;
+
+	for (const reshadefx::technique &tech : module.techniques)
+	{
+		for (const reshadefx::pass &pass : tech.passes)
+		{
+			const bool is_read = std::any_of(pass.texture_bindings.cbegin(), pass.texture_bindings.cend(),
+				[&module, &tex](const reshadefx::texture_binding &binding) { return module.samplers[binding.index].texture_name == tex.unique_name; });
+			const size_t render_target_index = std::find(std::begin(pass.render_target_names), std::end(pass.render_target_names), tex.unique_name) - std::begin(pass.render_target_names);
+
+			if (!is_read && render_target_index >= 8)
+				continue;
+
+			if (used_by_technique == nullptr)
+			{
+				// First use has to be a draw that covers the entire render target (the full screen triangle convention), without blending with the previous contents
+				if (is_read || render_target_index >= 8 || pass.render_target_write_mask[render_target_index] != 0xF || pass.stencil_enable)
+					return false;
+				if (!pass.clear_render_targets && (pass.blend_enable[render_target_index] || pass.topology != reshadefx::primitive_topology::triangle_list || pass.num_vertices != 3))
+					return false;
+				// Viewport also limits the area that is drawn to (and cleared on some APIs), so it has to be unset (which means the size of the render target) or span the entire texture
+				if ((pass.viewport_width != 0 && pass.viewport_width != tex.width) || (pass.viewport_height != 0 && pass.viewport_height != tex.height))
+					return false;
+
+				used_by_technique = &tech;
+			}
+			else if (used_by_technique != &tech)
+			{
+				return false;
+			}
+		}
+	}
+
+	return used_by_technique != nullptr;
+}
+
+static void replace_texture_references(reshadefx::effect_module &module, const std::string &old_name, const std::string &new_name)
+{
+	for (reshadefx::sampler &sampler_info : module.samplers)
+	{
+		if (sampler_info.texture_name == old_name)
+			sampler_info.texture_name = new_name;
+	}
+
+	for (reshadefx::storage &storage_info : module.storages)
+	{
+		if (storage_info.texture_name == old_name)
+			storage_info.texture_name = new_name;
+	}
+
+	for (reshadefx::technique &tech : module.techniques)
+	{
+		for (reshadefx::pass &pass : tech.passes)
+		{
+			std::replace(std::begin(pass.render_target_names), std::end(pass.render_target_names), old_name, new_name);
+		}
+	}
+}
+
+static uint64_t calc_texture_memory_size(const reshadefx::texture &tex)
+{
+	uint32_t bytes_per_pixel = 4;
+	switch (tex.format)
+	{
+	case reshadefx::texture_format::r8:
+		bytes_per_pixel = 1;
+		break;
+	case reshadefx::texture_format::r16:
+	case reshadefx::texture_format::r16f:
+	case reshadefx::texture_format::rg8:
+		bytes_per_pixel = 2;
+		break;
+	case reshadefx::texture_format::rg32f:
+	case reshadefx::texture_format::rgba16:
+	case reshadefx::texture_format::rgba16f:
+		bytes_per_pixel = 8;
+		break;
+	case reshadefx::texture_format::rgba32i:
+	case reshadefx::texture_format::rgba32u:
+	case reshadefx::texture_format::rgba32f:
+		bytes_per_pixel = 16;
+		break;
+	}
+
+	uint64_t size = 0;
+	for (uint32_t level = 0; level < std::max<uint32_t>(tex.levels, 1); ++level)
+		size += static_cast<uint64_t>(std::max<uint32_t>(tex.width >> level, 1)) * std::max<uint32_t>(tex.height >> level, 1) * std::max<uint32_t>(tex.depth >> level, 1) * bytes_per_pixel;
+	return size;
+}
+
 bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, size_t permutation_index, bool force_load, bool preprocess_required)
 {
 	const std::chrono::high_resolution_clock::time_point time_load_started = std::chrono::high_resolution_clock::now();
@@ -1415,10 +1564,6 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	// Generate a unique string identifying this effect
 	std::string attributes;
 	attributes += "app=" + g_target_executable_path.stem().u8string() + ';';
-	attributes += "width=" + std::to_string(_effect_permutations[permutation_index].width) + ';';
-	attributes += "height=" + std::to_string(_effect_permutations[permutation_index].height) + ';';
-	attributes += "color_space=" + std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_space)) + ';';
-	attributes += "color_format=" + std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_format)) + ';';
 	attributes += "version=" + std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION) + ';';
 	attributes += "performance_mode=" + std::string(_performance_mode ? "1" : "0") + ';';
 	attributes += "vendor=" + std::to_string(_vendor_id) + ';';
@@ -1456,47 +1601,26 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		attributes += definition.first + '=' + definition.second + ';';
 
 	std::error_code ec;
-	std::set<std::filesystem::path> include_paths;
+	std::set<std::filesystem::path> include_paths(_effect_include_paths.begin(), _effect_include_paths.end());
 	if (source_file.is_absolute())
 		include_paths.emplace(source_file.parent_path());
-	for (std::filesystem::path include_path : _effect_search_paths)
-	{
-		const bool recursive_search = include_path.filename() == L"**";
-		if (recursive_search)
-			include_path.remove_filename();
-
-		if (resolve_path(include_path, ec))
-		{
-			include_paths.emplace(include_path);
 
-			if (recursive_search)
-			{
-				for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(include_path, std::filesystem::directory_options::skip_permission_denied, ec))
-					if (entry.is_directory(ec))
-						include_paths.emplace(entry);
-			}
-		}
-	}
+	// Changes to the included files are detected with the dependency list stored in the cached source (see 'is_effect_cache_up_to_date'), but the search paths affect which files are included
+	for (const std::filesystem::path &include_path : include_paths)
+		attributes += include_path.u8string() + ';';
 
 	attributes += effect_name;
 	attributes += '?';
 	attributes += std::to_string(std::filesystem::last_write_time(source_file, ec).time_since_epoch().count());
 	attributes += ';';
 
-	// The actual included files are not known at this point, so detect changes to any ".fxh" files in the search paths
-	for (const std::filesystem::path &include_path : include_paths)
-	{
-		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(include_path, std::filesystem::directory_options::skip_permission_denied, ec))
-		{
-			if (entry.path().extension() == L".fxh")
-			{
-				attributes += entry.path().filename().u8string();
-				attributes += '?';
-				attributes += std::to_string(entry.last_write_time(ec).time_since_epoch().count());
-				attributes += ';';
-			}
-		}
-	}
+	// All attributes up to here are the same for every permutation
+	const size_t shared_source_hash = std::hash<std::string>()(attributes);
+
+	attributes += "width=" + std::to_string(_effect_permutations[permutation_index].width) + ';';
+	attributes += "height=" + std::to_string(_effect_permutations[permutation_index].height) + ';';
+	attributes += "color_space=" + std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_space)) + ';';
+	attributes += "color_format=" + std::to_string(static_cast<uint32_t>(_effect_permutations[permutation_index].color_format)) + ';';
 
 	effect &effect = _effects[effect_index];
 
@@ -1542,7 +1666,46 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	std::string source;
 	std::string errors;
 
-	if (!preprocessed && (preprocess_required || (source_cached = load_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source)) == false))
+	// Share the compiled code of the first permutation if none of the macros that differ between it and this permutation were referenced by the source code
+	if (permutation_index != 0 && effect.permutations[0].shared_source_hash == shared_source_hash)
+	{
+		const effect_permutation &base_permutation = _effect_permutations[0];
+		const effect_permutation &this_permutation = _effect_permutations[permutation_index];
+
+		const std::vector<std::string> &referenced_macros = effect.permutations[0].referenced_macros;
+		const auto is_referenced = [&referenced_macros](const char *name) {
+			return std::find(referenced_macros.begin(), referenced_macros.end(), name) != referenced_macros.end();
+		};
+
+		// D3D9 additionally puts the buffer dimensions into the code of every entry point (see 'COLOR_PIXEL_SIZE' below)
+		if ((this_permutation.width == base_permutation.width || (_renderer_id != 0x9000 && !is_referenced("BUFFER_WIDTH"))) &&
+			(this_permutation.height == base_permutation.height || (_renderer_id != 0x9000 && !is_referenced("BUFFER_HEIGHT"))) &&
+			(this_permutation.color_space == base_permutation.color_space || !is_referenced("BUFFER_COLOR_SPACE")) &&
+			(this_permutation.color_format == base_permutation.color_format || !is_referenced("BUFFER_COLOR_FORMAT")) &&
+			(api::format_bit_depth(this_permutation.color_format) == api::format_bit_depth(base_permutation.color_format) || !is_referenced("BUFFER_COLOR_BIT_DEPTH")))
+		{
+			permutation.module = effect.permutations[0].module;
+			permutation.generated_code = effect.permutations[0].generated_code;
+			permutation.assembly = effect.permutations[0].assembly;
+			permutation.assembly_text = effect.permutations[0].assembly_text;
+			permutation.referenced_macros = referenced_macros;
+
+			preprocessed = true;
+			compiled = true;
+		}
+	}
+
+	const std::string source_cache_id = source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash);
+
+	if (!preprocessed && !preprocess_required)
+	{
+		// Only use the cached source if none of the files it was preprocessed from have changed since
+		source_cached = load_effect_cache(source_cache_id, "i", source) && is_effect_cache_up_to_date(source);
+		if (!source_cached)
+			source.clear();
+	}
+
+	if (!preprocessed && (preprocess_required || !source_cached))
 	{
 		reshadefx::preprocessor pp;
 		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
@@ -1572,6 +1735,9 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		for (const std::filesystem::path &include_path : include_paths)
 			pp.add_include_path(include_path);
 
+		// Most effects include the same headers with the same set of macro definitions, so reuse the preprocessed result of those between effects
+		pp.enable_precompiled_headers();
+
 		// Add some conversion macros for compatibility with older versions of ReShade
 		pp.append_string(
 			"#define tex2Doffset(s, coords, offset) tex2D(s, coords, offset)\n"
@@ -1626,9 +1792,30 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 			std::sort(preprocessor_definitions.begin(), preprocessor_definitions.end());
 
+			// Keep track of the permutation-specific macros the source code depends on (and write them to the cached source too)
+			permutation.referenced_macros.clear();
+			for (const std::string &name : pp.referenced_predefined_macros())
+			{
+				if (name != "BUFFER_WIDTH" && name != "BUFFER_HEIGHT" && name != "BUFFER_COLOR_SPACE" && name != "BUFFER_COLOR_FORMAT" && name != "BUFFER_COLOR_BIT_DEPTH")
+					continue;
+
+				permutation.referenced_macros.push_back(name);
+
+				source = "// #reference " + name + '\n' + source;
+			}
+
+			// Write the list of files the result depends on to the cached source, so that it can be invalidated when any of them changes
+			std::string dependencies;
+			// Use the modification time from when each file was read, so that a change made during preprocessing invalidates the cache instead of being recorded as up-to-date
+			for (const auto &[included_file, modified_at] : pp.included_files_with_modification_time())
+				dependencies += "// #include " + included_file.u8string() + '?' + std::to_string(modified_at.time_since_epoch().count()) + '\n';
+			for (const std::filesystem::path &missing_file : pp.missing_include_files())
+				dependencies += "// #include " + missing_file.u8string() + "?\n";
+			source.insert(0, dependencies);
+
 			// Do not cache if any special pragma directives were used, to ensure they are read again next time
 			if (!skip_optimization)
-				source_cached = save_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source);
+				source_cached = save_effect_cache(source_cache_id, "i", source);
 		}
 
 		if (permutation_index == 0)
@@ -1645,6 +1832,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		if (permutation_index == 0 && !source.empty())
 		{
 			effect.definitions.clear();
+			permutation.referenced_macros.clear();
 
 			// Read used preprocessor definitions and pragmas from the cached source
 			for (size_t offset = 0, next; source.compare(offset, 3, "// ") == 0; offset = next + 1)
@@ -1658,6 +1846,14 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				{
 					code_preamble += source.substr(offset, (next + 1) - offset);
 				}
+				else if (source.compare(offset, 8, "#include") == 0)
+				{
+					continue; // Skip dependency list
+				}
+				else if (source.compare(offset, 11, "#reference ") == 0)
+				{
+					permutation.referenced_macros.push_back(source.substr(offset + 11, next - (offset + 11)));
+				}
 				else if (const size_t equals_index = source.find('=', offset);
 					equals_index != std::string::npos)
 				{
@@ -1671,46 +1867,80 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
-	std::unique_ptr<reshadefx::codegen> codegen;
+	std::vector<std::string> entry_point_code;
 	if (!compiled && !source.empty())
 	{
-		unsigned shader_model;
-		if (_renderer_id == 0x9000)
-			shader_model = 30; // D3D9
-		else if (_renderer_id < 0xa100)
-			shader_model = 40; // D3D10 (including feature level 9)
-		else if (_renderer_id < 0xb000)
-			shader_model = 41; // D3D10.1
-		else if (_renderer_id < 0xc000)
-			shader_model = 50; // D3D11
+		// Optimization only has an effect on the SPIR-V code generator used for Vulkan
+		const bool optimize = _optimize_spirv && (_renderer_id & 0x20000) != 0;
+
+		// The source hash does not cover changes to included files, so hash the preprocessed source itself too
+		// The generated code also depends on whether debug information is included and whether it was optimized, which is not part of the source hash either
+		const std::string module_cache_id = source_cache_id + '-' + std::to_string(std::hash<std::string>()(source)) + (_no_debug_info ? "-nodebug" : "") + (optimize ? "-optimized" : "");
+
+		// Skip parsing and code generation if the result of compiling the same source is cached already (which is only the case if the source itself was cached too)
+		if (std::string module_data;
+			source_cached && load_effect_cache(module_cache_id, "fxm", module_data) &&
+			reshadefx::deserialize_module(module_data, permutation.module, permutation.generated_code, entry_point_code))
+		{
+			compiled = true;
+		}
 		else
-			shader_model = 51; // D3D12
+		{
+			unsigned shader_model;
+			if (_renderer_id == 0x9000)
+				shader_model = 30; // D3D9
+			else if (_renderer_id < 0xa100)
+				shader_model = 40; // D3D10 (including feature level 9)
+			else if (_renderer_id < 0xb000)
+				shader_model = 41; // D3D10.1
+			else if (_renderer_id < 0xc000)
+				shader_model = 50; // D3D11
+			else
+				shader_model = 51; // D3D12
+
+			std::unique_ptr<reshadefx::codegen> codegen;
+			if ((_renderer_id & 0xF0000) == 0)
+				codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, _performance_mode));
+			else if (_renderer_id < 0x20000)
+				codegen.reset(reshadefx::create_codegen_glsl(false, !_no_debug_info, _performance_mode, false, true));
+			else // Vulkan uses SPIR-V input
+				codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, false));
 
-		if ((_renderer_id & 0xF0000) == 0)
-			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, _performance_mode));
-		else if (_renderer_id < 0x20000)
-			codegen.reset(reshadefx::create_codegen_glsl(false, !_no_debug_info, _performance_mode, false, true));
-		else // Vulkan uses SPIR-V input
-			codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, false));
+			reshadefx::parser parser;
 
-		reshadefx::parser parser;
+			// Compile the pre-processed source code (try the compile even if the preprocessor step failed to get additional error information)
+			compiled = parser.parse(std::move(source), codegen.get());
 
-		// Compile the pre-processed source code (try the compile even if the preprocessor step failed to get additional error information)
-		compiled = parser.parse(std::move(source), codegen.get());
+			// Append parser errors to the error list
+			errors += parser.errors();
 
-		// Append parser errors to the error list
-		errors += parser.errors();
+			// The optimization pass is still experimental, so only run it when enabled explicitly
+			if (compiled && optimize)
+				codegen->optimize_code();
+
+			// Write result to effect module
+			permutation.module = codegen->module();
+			if (_device->get_api() != api::device_api::vulkan)
+				permutation.generated_code = codegen->finalize_code();
+
+			if (compiled)
+			{
+				// Generate code for all entry points at once, so that the parts shared between them are only built a single time
+				// Effects are already loaded on multiple threads, so keep this on the current one
+				entry_point_code = codegen->finalize_code_for_entry_points();
 
-		// Write result to effect module
-		permutation.module = codegen->module();
-		if (_device->get_api() != api::device_api::vulkan)
-			permutation.generated_code = codegen->finalize_code();
+				// Only cache the result if there were no warnings, so that those are still reported on the next load
+				if (source_cached && parser.errors().empty())
+					save_effect_cache(module_cache_id, "fxm", reshadefx::serialize_module(permutation.module, permutation.generated_code, entry_point_code));
+			}
+		}
 
 		if (compiled)
 		{
 			if (permutation_index == 0)
 			{
 				effect.uniforms.clear();
+				effect.uniform_updates.clear();
 
 				// Create space for all variables (aligned to 16 bytes)
 				effect.uniform_data_storage.resize((permutation.module.total_uniform_size + 15) & ~15);
@@ -1719,45 +1949,16 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				{
 					variable.effect_index = effect_index;
 
-					const std::string_view special = variable.annotation_as_string("source");
-					if (special.empty()) /* Ignore if annotation is missing */
-						variable.special = special_uniform::none;
-					else if (special == "frametime")
-						variable.special = special_uniform::frame_time;
-					else if (special == "framecount")
-						variable.special = special_uniform::frame_count;
-					else if (special == "random")
-						variable.special = special_uniform::random;
-					else if (special == "pingpong")
-						variable.special = special_uniform::ping_pong;
-					else if (special == "date")
-						variable.special = special_uniform::date;
-					else if (special == "timer")
-						variable.special = special_uniform::timer;
-					else if (special == "key")
-						variable.special = special_uniform::key;
-					else if (special == "mousepoint")
-						variable.special = special_uniform::mouse_point;
-					else if (special == "mousedelta")
-						variable.special = special_uniform::mouse_delta;
-					else if (special == "mousebutton")
-						variable.special = special_uniform::mouse_button;
-					else if (special == "mousewheel")
-						variable.special = special_uniform::mouse_wheel;
-					else if (special == "ui_open" || special == "overlay_open")
-						variable.special = special_uniform::overlay_open;
-					else if (special == "ui_active" || special == "overlay_active")
-						variable.special = special_uniform::overlay_active;
-					else if (special == "ui_hovered" || special == "overlay_hovered")
-						variable.special = special_uniform::overlay_hovered;
-					else if (special == "screenshot")
-						variable.special = special_uniform::screenshot;
-					else
-						variable.special = special_uniform::unknown;
+					variable.special = special_uniform_from_source(variable.annotation_as_string("source"));
 
 					// Copy initial data into uniform storage area
 					reset_uniform_value(variable);
 
+					// Resolve the parameters of special variables now, so that they do not have to be looked up again every frame
+					if (const uniform_update update(variable, effect.uniforms.size());
+						update.special != special_uniform::none)
+						effect.uniform_updates.push_back(update);
+
 					effect.uniforms.push_back(std::move(variable));
 				}
 			}
@@ -1930,18 +2131,27 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	{
 		if (permutation.assembly.empty())
 		{
-			// Compile shader modules
-			for (const std::pair<std::string, reshadefx::shader_type> &entry_point : permutation.module.entry_points)
+			struct entry_point_result
 			{
+				std::string cso;
+				std::string cso_text;
+				std::string errors;
+				bool compiled = false;
+			};
+			std::vector<entry_point_result> entry_point_results(permutation.module.entry_points.size());
+
+			const auto compile_entry_point = [&](size_t entry_point_index) {
+				const std::pair<std::string, reshadefx::shader_type> &entry_point = permutation.module.entry_points[entry_point_index];
+				entry_point_result &result = entry_point_results[entry_point_index];
+
 				if (entry_point.second == reshadefx::shader_type::compute && !_device->check_capability(api::device_caps::compute_shader))
 				{
-					errors += "error: " + entry_point.first + ": compute shaders are not supported in D3D9/D3D10\n";
-					compiled = false;
-					break;
+					result.errors += "error: " + entry_point.first + ": compute shaders are not supported in D3D9/D3D10\n";
+					return;
 				}
 
-				std::string &cso = permutation.assembly[entry_point.first];
-				std::string &cso_text = permutation.assembly_text[entry_point.first];
+				std::string &cso = result.cso;
+				std::string &cso_text = result.cso_text;
 
 				if ((_renderer_id & 0xF0000) == 0)
 				{
@@ -1971,7 +2181,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 					}
 
 					hlsl += "#line 1\n"; // Reset line number, so it matches what is shown when viewing the generated code
-					hlsl += codegen->finalize_code_for_entry_point(entry_point.first);
+					hlsl += entry_point_code[entry_point_index];
 
 					std::string profile;
 					switch (entry_point.second)
@@ -2078,16 +2288,15 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 						{
 							// Add a prefix with the offending entry point name for generic error messages like an out of memory notification
 							if (d3d_errors_string.find("error") == std::string::npos)
-								errors += "error: " + entry_point.first + ": ";
+								result.errors += "error: " + entry_point.first + ": ";
 
-							errors += d3d_errors_string;
-							compiled = false;
-							break;
+							result.errors += d3d_errors_string;
+							return;
 						}
 						else
 						{
 							// Append warnings
-							errors += d3d_errors_string;
+							result.errors += d3d_errors_string;
 						}
 
 						cso.resize(d3d_compiled->GetBufferSize());
@@ -2110,7 +2319,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				}
 				else
 				{
-					cso = codegen->finalize_code_for_entry_point(entry_point.first);
+					cso = std::move(entry_point_code[entry_point_index]);
 
 					if (_renderer_id < 0x20000)
 					{
@@ -2119,6 +2328,46 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 						cso_text = cso;
 					}
 				}
+
+				result.compiled = true;
+			};
+
+			// Compile shader modules
+			if ((_renderer_id & 0xF0000) == 0 && entry_point_results.size() > 1)
+			{
+				// Compiling HLSL is slow, so compile every entry point in a separate job, to have other threads help out with effects that have many of them
+				job_system::group entry_point_jobs;
+				for (size_t entry_point_index = 0; entry_point_index < entry_point_results.size(); ++entry_point_index)
+					_jobs.submit(entry_point_jobs, [&compile_entry_point, entry_point_index]() { compile_entry_point(entry_point_index); }, job_system::priority::high);
+				_jobs.wait(entry_point_jobs);
+			}
+			else
+			{
+				for (size_t entry_point_index = 0; entry_point_index < entry_point_results.size(); ++entry_point_index)
+				{
+					compile_entry_point(entry_point_index);
+
+					if (!entry_point_results[entry_point_index].compiled)
+						break;
+				}
+			}
+
+			// Report results in entry point order, stopping at the first failure like a sequential compilation would
+			for (size_t entry_point_index = 0; entry_point_index < entry_point_results.size(); ++entry_point_index)
+			{
+				const std::string &entry_point_name = permutation.module.entry_points[entry_point_index].first;
+				entry_point_result &result = entry_point_results[entry_point_index];
+
+				permutation.assembly[entry_point_name] = std::move(result.cso);
+				permutation.assembly_text[entry_point_name] = std::move(result.cso_text);
+
+				errors += result.errors;
+
+				if (!result.compiled)
+				{
+					compiled = false;
+					break;
+				}
 			}
 		}
 
@@ -2191,44 +2440,77 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				// Update render target and storage access flags of the existing shared texture, in case they are used as such in this effect
 				existing_texture->render_target |= new_texture.render_target;
 				existing_texture->storage_access |= new_texture.storage_access;
+
+				// Stop aliasing other textures with this one if it is not transient in this effect
+				if (existing_texture->transient && !is_transient_texture(permutation.module, new_texture))
+				{
+					existing_texture->transient = false;
+
+					// Those already aliased with it would otherwise keep overwriting its contents, so give them back a texture of their own
+					std::vector<texture> split_textures;
+					for (const texture::alias &alias : existing_texture->aliases)
+					{
+						reshadefx::effect_module &alias_module = _effects[alias.effect_index].permutations[alias.permutation_index].module;
+
+						replace_texture_references(alias_module, existing_texture->unique_name, alias.unique_name);
+						for (technique &tech : _techniques)
+						{
+							if (tech.effect_index != alias.effect_index || alias.permutation_index >= tech.permutations.size())
+								continue;
+
+							for (technique::pass &pass : tech.permutations[alias.permutation_index].passes)
+								std::replace(std::begin(pass.render_target_names), std::end(pass.render_target_names), existing_texture->unique_name, alias.unique_name);
+
+							// Effects that were already created with the shared texture have to be created again
+							if (tech.permutations[alias.permutation_index].created &&
+								std::find(_reload_create_queue.cbegin(), _reload_create_queue.cend(), std::make_pair(alias.effect_index, alias.permutation_index)) == _reload_create_queue.cend())
+							{
+								destroy_effect(alias.effect_index, false);
+								_reload_create_queue.emplace_back(alias.effect_index, alias.permutation_index);
+							}
+						}
+
+						const auto alias_texture = std::find_if(alias_module.textures.cbegin(), alias_module.textures.cend(),
+							[&alias](const reshadefx::texture &item) { return item.unique_name == alias.unique_name; });
+						assert(alias_texture != alias_module.textures.cend());
+
+						texture &split_texture = split_textures.emplace_back(*alias_texture);
+						split_texture.effect_index = alias.effect_index;
+						split_texture.shared.push_back(alias.effect_index);
+
+						// Keep sharing the existing texture if the effect also references it under its own name
+						if (std::none_of(alias_module.textures.cbegin(), alias_module.textures.cend(),
+								[&existing_texture](const reshadefx::texture &item) { return item.unique_name == existing_texture->unique_name; }))
+							existing_texture->shared.erase(std::remove(existing_texture->shared.begin(), existing_texture->shared.end(), alias.effect_index), existing_texture->shared.end());
+					}
+
+					existing_texture->aliases.clear();
+
+					// This invalidates the iterator to the existing texture, so has to happen last
+					_textures.insert(_textures.end(), std::make_move_iterator(split_textures.begin()), std::make_move_iterator(split_textures.end()));
+				}
 				continue;
 			}
 
-			if (new_texture.annotation_as_int("pooled") && new_texture.semantic.empty())
+			new_texture.transient = _alias_transient_textures && is_transient_texture(permutation.module, new_texture);
+
+			if ((new_texture.annotation_as_int("pooled") || new_texture.transient) && new_texture.semantic.empty())
 			{
 				// Try to find another pooled texture to share with (and do not share within the same effect)
 				if (const auto existing_texture = std::find_if(_textures.begin(), _textures.end(),
 						[&new_texture](const texture &item) {
-							return item.annotation_as_int("pooled") && std::find(item.shared.begin(), item.shared.end(), new_texture.effect_index) == item.shared.end() && item.matches_description(new_texture);
+							return (item.annotation_as_int("pooled") || item.transient) && std::find(item.shared.begin(), item.shared.end(), new_texture.effect_index) == item.shared.end() && item.matches_description(new_texture);
 						});
 					existing_texture != _textures.end())
 				{
-					// Overwrite referenced texture in samplers with the pooled one
-					for (reshadefx::sampler &sampler_info : permutation.module.samplers)
-					{
-						if (sampler_info.texture_name == new_texture.unique_name)
-							sampler_info.texture_name = existing_texture->unique_name;
-					}
-
-					// Overwrite referenced texture in storages with the pooled one
-					for (reshadefx::storage &storage_info : permutation.module.storages)
-					{
-						if (storage_info.texture_name == new_texture.unique_name)
-							storage_info.texture_name = existing_texture->unique_name;
-					}
-
-					// Overwrite referenced texture in render targets with the pooled one
-					for (reshadefx::technique &tech : permutation.module.techniques)
-					{
-						for (reshadefx::pass &pass : tech.passes)
-						{
-							std::replace(std::begin(pass.render_target_names), std::end(pass.render_target_names), new_texture.unique_name, existing_texture->unique_name);
-						}
-					}
+					// Overwrite referenced texture in samplers, storages and render targets with the pooled one
+					replace_texture_references(permutation.module, new_texture.unique_name, existing_texture->unique_name);
 
 					if (std::find(existing_texture->shared.cbegin(), existing_texture->shared.cend(), effect_index) == existing_texture->shared.cend())
 						existing_texture->shared.push_back(effect_index);
 
+					existing_texture->aliases.push_back({ effect_index, permutation_index, new_texture.unique_name });
+
 					existing_texture->render_target = true;
 					existing_texture->storage_access = true;
 					continue;
@@ -2263,6 +2545,10 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 			new_technique.hidden = new_technique.annotation_as_int("hidden") != 0;
 			new_technique.enabled_in_screenshot = new_technique.annotation_as_int("enabled_in_screenshot", 0, true) != 0;
+			new_technique.schedule.priority = new_technique.annotation_as_int("priority");
+			// Techniques rendering to the back buffer have to do so every frame, since its contents are not kept from the previous one
+			new_technique.schedule.allow_half_rate = std::all_of(new_technique.permutations[0].passes.cbegin(), new_technique.permutations[0].passes.cend(),
+				[](const technique::pass &pass) { return !pass.cs_entry_point.empty() || !pass.render_target_names[0].empty(); });
 
 			if (new_technique.annotation_as_int("enabled"))
 				enable_technique(new_technique);
@@ -2275,6 +2561,8 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	effect.compiled = compiled;
 	effect.preprocessed = preprocessed;
 
+	permutation.shared_source_hash = compiled ? shared_source_hash : 0;
+
 	if (!errors.empty())
 		effect.errors = std::move(errors);
 
@@ -2304,6 +2592,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		return false;
 	}
 }
+
 bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_index)
 {
 	effect &effect = _effects[effect_index];
@@ -2484,6 +2773,9 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 			}
 
 			_device->set_resource_name(effect.cb, "ReShade constant buffer");
+
+			// New constant buffer has no contents yet, so needs to be filled completely on first use
+			effect.mark_uniform_data_dirty(0, effect.uniform_data_storage.size());
 		}
 		else
 		{
@@ -2881,6 +3173,8 @@ bool reshade::runtime::create_effect(size_t effect_index, size_t permutation_ind
 			}
 		}
 
+		technique::plan_barriers(tech.permutations[permutation_index].passes, (_renderer_id & 0x20000) != 0);
+
 		tech.permutations[permutation_index].created = true;
 	}
 
@@ -2959,6 +3253,8 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 				std::fill_n(pass.render_target_views, 8, api::resource_view {});
 				pass.modified_resources.clear();
 				pass.generate_mipmap_views.clear();
+				pass.barriers_before.clear();
+				pass.barriers_after.clear();
 			}
 
 			permutation.created = false;
@@ -3000,6 +3296,8 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 	_textures.erase(std::remove_if(_textures.begin(), _textures.end(),
 		[this, effect_index](texture &tex) {
 			tex.shared.erase(std::remove(tex.shared.begin(), tex.shared.end(), effect_index), tex.shared.end());
+			tex.aliases.erase(std::remove_if(tex.aliases.begin(), tex.aliases.end(),
+				[effect_index](const texture::alias &alias) { return alias.effect_index == effect_index; }), tex.aliases.end());
 			if (tex.shared.empty())
 			{
 				destroy_texture(tex);
@@ -3036,6 +3334,15 @@ void reshade::runtime::destroy_effect(size_t effect_index, bool unload)
 
 void reshade::runtime::load_textures(size_t effect_index)
 {
+	struct texture_image
+	{
+		texture *tex = nullptr;
+		std::filesystem::path source_path;
+		void *pixels = nullptr;
+		int width = 0, height = 1, depth = 1;
+	};
+	std::vector<texture_image> images;
+
 	for (texture &tex : _textures)
 	{
 		if (tex.resource == 0 || !tex.semantic.empty())
@@ -3048,172 +3355,196 @@ void reshade::runtime::load_textures(size_t effect_index)
 		if (source_path.empty())
 			continue;
 
-		// Search for image file using the provided search paths unless the path provided is already absolute
-		if (!find_file(_texture_search_paths, source_path))
-		{
-			log::message(log::level::error, "Source '%s' for texture '%s' was not found in any of the texture search paths!", source_path.u8string().c_str(), tex.unique_name.c_str());
-			_last_reload_successful = false;
-			continue;
-		}
+		images.push_back({ &tex, std::move(source_path) });
+	}
 
-		void *pixels = nullptr;
-		int width = 0, height = 1, depth = 1, channels = 0;
-		const bool is_floating_point_format = (tex.format == reshadefx::texture_format::r32f || tex.format == reshadefx::texture_format::rg32f || tex.format == reshadefx::texture_format::rgba32f);
+	// Reading and decoding the image files is slow, so do that for all textures in parallel and only upload the results here
+	job_system::group image_jobs;
+	for (texture_image &image : images)
+	{
+		_jobs.submit(image_jobs, [this, &image]() {
+			const texture &tex = *image.tex;
+			std::filesystem::path &source_path = image.source_path;
 
-		if (FILE *const file = _wfsopen(source_path.c_str(), L"rb", SH_DENYNO))
-		{
-			fseek(file, 0, SEEK_END);
-			const size_t file_size = ftell(file);
-			fseek(file, 0, SEEK_SET);
+			// Search for image file using the provided search paths unless the path provided is already absolute
+			if (!find_file(_texture_search_paths, source_path))
+			{
+				log::message(log::level::error, "Source '%s' for texture '%s' was not found in any of the texture search paths!", source_path.u8string().c_str(), tex.unique_name.c_str());
+				_last_reload_successful = false;
+				return;
+			}
 
-			if (source_path.extension() == L".cube")
+			void *pixels = nullptr;
+			int width = 0, height = 1, depth = 1, channels = 0;
+			const bool is_floating_point_format = (tex.format == reshadefx::texture_format::r32f || tex.format == reshadefx::texture_format::rg32f || tex.format == reshadefx::texture_format::rgba32f);
+
+			if (FILE *const file = _wfsopen(source_path.c_str(), L"rb", SH_DENYNO))
 			{
-				if (!is_floating_point_format)
+				fseek(file, 0, SEEK_END);
+				const size_t file_size = ftell(file);
+				fseek(file, 0, SEEK_SET);
+
+				if (source_path.extension() == L".cube")
 				{
-					log::message(log::level::error, "Source '%s' for texture '%s' is a Cube LUT file, which can only be loaded into textures with a floating-point format!", source_path.u8string().c_str(), tex.unique_name.c_str());
-					_last_reload_successful = false;
-					continue;
-				}
+					if (!is_floating_point_format)
+					{
+						log::message(log::level::error, "Source '%s' for texture '%s' is a Cube LUT file, which can only be loaded into textures with a floating-point format!", source_path.u8string().c_str(), tex.unique_name.c_str());
+						_last_reload_successful = false;
+						return;
+					}
 
-				float domain_min[3] = { 0.0f, 0.0f, 0.0f };
-				float domain_max[3] = { 1.0f, 1.0f, 1.0f };
+					float domain_min[3] = { 0.0f, 0.0f, 0.0f };
+					float domain_max[3] = { 1.0f, 1.0f, 1.0f };
 
-				// Read header information
-				char line_data[1024];
-				while (fgets(line_data, sizeof(line_data), file))
-				{
-					const std::string_view line = trim(line_data, "\r\n");
+					// Read header information
+					char line_data[1024];
+					while (fgets(line_data, sizeof(line_data), file))
+					{
+						const std::string_view line = trim(line_data, "\r\n");
 
-					if (line.empty() || line[0] == '#')
-						continue; // Skip lines with comments
+						if (line.empty() || line[0] == '#')
+							continue; // Skip lines with comments
 
-					char *p = line_data;
+						char *p = line_data;
 
-					if (line.rfind("TITLE", 0) == 0)
-						continue; // Skip optional line with title
+						if (line.rfind("TITLE", 0) == 0)
+							continue; // Skip optional line with title
 
-					if (line.rfind("DOMAIN_MIN", 0) == 0)
-					{
-						p += 10;
-						domain_min[0] = static_cast<float>(std::strtod(p, &p));
-						domain_min[1] = static_cast<float>(std::strtod(p, &p));
-						domain_min[2] = static_cast<float>(std::strtod(p, &p));
-						continue;
-					}
-					if (line.rfind("DOMAIN_MAX", 0) == 0)
-					{
-						p += 10;
-						domain_max[0] = static_cast<float>(std::strtod(p, &p));
-						domain_max[1] = static_cast<float>(std::strtod(p, &p));
-						domain_max[2] = static_cast<float>(std::strtod(p, &p));
-						continue;
-					}
+						if (line.rfind("DOMAIN_MIN", 0) == 0)
+						{
+							p += 10;
+							domain_min[0] = static_cast<float>(std::strtod(p, &p));
+							domain_min[1] = static_cast<float>(std::strtod(p, &p));
+							domain_min[2] = static_cast<float>(std::strtod(p, &p));
+							continue;
+						}
+						if (line.rfind("DOMAIN_MAX", 0) == 0)
+						{
+							p += 10;
+							domain_max[0] = static_cast<float>(std::strtod(p, &p));
+							domain_max[1] = static_cast<float>(std::strtod(p, &p));
+							domain_max[2] = static_cast<float>(std::strtod(p, &p));
+							continue;
+						}
 
-					if (line.rfind("LUT_1D_SIZE", 0) == 0)
-					{
-						if (pixels != nullptr)
-							break;
-						width = std::strtol(p + 11, nullptr, 10);
-						pixels = std::malloc(static_cast<size_t>(width) * 4 * sizeof(float));
-						continue;
-					}
-					if (line.rfind("LUT_3D_SIZE", 0) == 0)
-					{
-						if (pixels != nullptr)
-							break;
-						width = height = depth = std::strtol(p + 11, nullptr, 10);
-						pixels = std::malloc(static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4 * sizeof(float));
-						continue;
+						if (line.rfind("LUT_1D_SIZE", 0) == 0)
+						{
+							if (pixels != nullptr)
+								break;
+							width = std::strtol(p + 11, nullptr, 10);
+							pixels = std::malloc(static_cast<size_t>(width) * 4 * sizeof(float));
+							continue;
+						}
+						if (line.rfind("LUT_3D_SIZE", 0) == 0)
+						{
+							if (pixels != nullptr)
+								break;
+							width = height = depth = std::strtol(p + 11, nullptr, 10);
+							pixels = std::malloc(static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4 * sizeof(float));
+							continue;
+						}
+
+						// Line has no known keyword, so assume this is where the table data starts and roll back a line to continue reading that below
+						fseek(file, -static_cast<long>(std::strlen(line_data)), SEEK_CUR);
+						break;
 					}
 
-					// Line has no known keyword, so assume this is where the table data starts and roll back a line to continue reading that below
-					fseek(file, -static_cast<long>(std::strlen(line_data)), SEEK_CUR);
-					break;
-				}
+					// Read table data
+					if (pixels != nullptr)
+					{
+						size_t index = 0;
 
-				// Read table data
-				if (pixels != nullptr)
-				{
-					size_t index = 0;
+						while (fgets(line_data, sizeof(line_data), file) && (index + 4) <= (static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4))
+						{
+							const std::string_view line = trim(line_data, "\r\n");
 
-					while (fgets(line_data, sizeof(line_data), file) && (index + 4) <= (static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4))
-					{
-						const std::string_view line = trim(line_data, "\r\n");
+							if (line.empty() || line[0] == '#')
+								continue; // Skip lines with comments
 
-						if (line.empty() || line[0] == '#')
-							continue; // Skip lines with comments
+							char *p = line_data;
 
-						char *p = line_data;
+							static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[0] - domain_min[0]) + domain_min[0];
+							static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[1] - domain_min[1]) + domain_min[1];
+							static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[2] - domain_min[2]) + domain_min[2];
+							static_cast<float *>(pixels)[index++] = 1.0f;
+						}
+					}
+				}
+				else
+				{
+					// Read texture data into memory in one go since that is faster than reading chunk by chunk
+					std::vector<stbi_uc> file_data(file_size);
+					const size_t file_size_read = fread(file_data.data(), 1, file_size, file);
+					fclose(file);
 
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[0] - domain_min[0]) + domain_min[0];
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[1] - domain_min[1]) + domain_min[1];
-						static_cast<float *>(pixels)[index++] = static_cast<float>(std::strtod(p, &p)) * (domain_max[2] - domain_min[2]) + domain_min[2];
-						static_cast<float *>(pixels)[index++] = 1.0f;
+					if (file_size_read == file_size)
+					{
+						if (is_floating_point_format)
+							pixels = stbi_loadf_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+						else if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
+							pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &depth, &channels, STBI_rgb_alpha);
+						else
+							pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
 					}
 				}
 			}
-			else
+
+			if (pixels == nullptr)
 			{
-				// Read texture data into memory in one go since that is faster than reading chunk by chunk
-				std::vector<stbi_uc> file_data(file_size);
-				const size_t file_size_read = fread(file_data.data(), 1, file_size, file);
-				fclose(file);
+				log::message(log::level::error, "Failed to load '%s' for texture '%s'!", source_path.u8string().c_str(), tex.unique_name.c_str());
+				_last_reload_successful = false;
+				return;
+			}
 
-				if (file_size_read == file_size)
-				{
-					if (is_floating_point_format)
-						pixels = stbi_loadf_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-					else if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
-						pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &depth, &channels, STBI_rgb_alpha);
-					else
-						pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-				}
+			// Collapse data to the correct number of components per pixel based on the texture format
+			switch (tex.format)
+			{
+			case reshadefx::texture_format::r8:
+				for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
+					static_cast<stbi_uc *>(pixels)[k] = static_cast<stbi_uc *>(pixels)[i];
+				break;
+			case reshadefx::texture_format::r32f:
+				for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
+					static_cast<float *>(pixels)[k] = static_cast<float *>(pixels)[i];
+				break;
+			case reshadefx::texture_format::rg8:
+				for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
+					static_cast<stbi_uc *>(pixels)[k + 0] = static_cast<stbi_uc *>(pixels)[i + 0],
+					static_cast<stbi_uc *>(pixels)[k + 1] = static_cast<stbi_uc *>(pixels)[i + 1];
+				break;
+			case reshadefx::texture_format::rg32f:
+				for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
+					static_cast<float *>(pixels)[k + 0] = static_cast<float *>(pixels)[i + 0],
+					static_cast<float *>(pixels)[k + 1] = static_cast<float *>(pixels)[i + 1];
+				break;
+			case reshadefx::texture_format::rgba8:
+			case reshadefx::texture_format::rgba32f:
+				break;
+			default:
+				log::message(log::level::error, "Texture upload is not supported for format %d of texture '%s'!", static_cast<int>(tex.format), tex.unique_name.c_str());
+				_last_reload_successful = false;
+				stbi_image_free(pixels);
+				return;
 			}
-		}
 
-		if (pixels == nullptr)
-		{
-			log::message(log::level::error, "Failed to load '%s' for texture '%s'!", source_path.u8string().c_str(), tex.unique_name.c_str());
-			_last_reload_successful = false;
-			continue;
-		}
+			image.pixels = pixels;
+			image.width = width;
+			image.height = height;
+			image.depth = depth;
+		}, job_system::priority::high);
+	}
+	_jobs.wait(image_jobs);
 
-		// Collapse data to the correct number of components per pixel based on the texture format
-		switch (tex.format)
-		{
-		case reshadefx::texture_format::r8:
-			for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
-				static_cast<stbi_uc *>(pixels)[k] = static_cast<stbi_uc *>(pixels)[i];
-			break;
-		case reshadefx::texture_format::r32f:
-			for (size_t i = 4, k = 1; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 1)
-				static_cast<float *>(pixels)[k] = static_cast<float *>(pixels)[i];
-			break;
-		case reshadefx::texture_format::rg8:
-			for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
-				static_cast<stbi_uc *>(pixels)[k + 0] = static_cast<stbi_uc *>(pixels)[i + 0],
-				static_cast<stbi_uc *>(pixels)[k + 1] = static_cast<stbi_uc *>(pixels)[i + 1];
-			break;
-		case reshadefx::texture_format::rg32f:
-			for (size_t i = 4, k = 2; i < static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * 4; i += 4, k += 2)
-				static_cast<float *>(pixels)[k + 0] = static_cast<float *>(pixels)[i + 0],
-				static_cast<float *>(pixels)[k + 1] = static_cast<float *>(pixels)[i + 1];
-			break;
-		case reshadefx::texture_format::rgba8:
-		case reshadefx::texture_format::rgba32f:
-			break;
-		default:
-			log::message(log::level::error, "Texture upload is not supported for format %d of texture '%s'!", static_cast<int>(tex.format), tex.unique_name.c_str());
-			_last_reload_successful = false;
-			stbi_image_free(pixels);
+	for (const texture_image &image : images)
+	{
+		if (image.pixels == nullptr)
 			continue;
-		}
 
-		update_texture(tex, width, height, depth, pixels);
+		update_texture(*image.tex, image.width, image.height, image.depth, image.pixels);
 
-		stbi_image_free(pixels);
+		stbi_image_free(image.pixels);
 
-		tex.loaded = true;
+		image.tex->loaded = true;
 	}
 }
 bool reshade::runtime::create_texture(texture &tex)
@@ -3481,6 +3812,7 @@ void reshade::runtime::disable_technique(technique &tech)
 	tech.time_left = 0;
 	tech.average_cpu_duration.clear();
 	tech.average_gpu_duration.clear();
+	tech.schedule.rate = technique_rate::every_frame;
 
 	if (status_changed) // Decrease rendering reference count
 		_effects[tech.effect_index].rendering--;
@@ -3529,12 +3861,35 @@ void reshade::runtime::load_effects(bool force_load_all)
 	const std::vector<std::filesystem::path> effect_files =
 		find_files(_effect_search_paths, { L".fx", L".addonfx" });
 
+	// Resolve the include paths once for all effects, rather than walking the search paths again for every single one
+	std::error_code ec;
+	std::set<std::filesystem::path> include_paths;
+	for (std::filesystem::path include_path : _effect_search_paths)
+	{
+		const bool recursive_search = include_path.filename() == L"**";
+		if (recursive_search)
+			include_path.remove_filename();
+
+		if (resolve_path(include_path, ec))
+		{
+			include_paths.emplace(include_path);
+
+			if (recursive_search)
+			{
+				for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(include_path, std::filesystem::directory_options::skip_permission_denied, ec))
+					if (entry.is_directory(ec))
+						include_paths.emplace(entry);
+			}
+		}
+	}
+	_effect_include_paths.assign(include_paths.begin(), include_paths.end());
+
 	if (effect_files.empty())
 		return; // No effect files found, so nothing more to do
 
 	ini_file &preset = ini_file::load_cache(_current_preset_path);
 
-	// Have to be initialized at this point or else the threads spawned below will immediately exit without reducing the remaining effects count
+	// Have to be initialized at this point or else the jobs submitted below will immediately exit without reducing the remaining effects count
 	assert(_is_initialized);
 
 	// Ensure HLSL compiler is loaded before trying to compile effects in Direct3D
@@ -3560,20 +3915,12 @@ void reshade::runtime::load_effects(bool force_load_all)
 	_reload_remaining_effects = effect_files.size();
 
 	// Now that we have a list of files, load them in parallel
-	// Split workload into batches instead of launching a thread for every file to avoid launch overhead and stutters due to too many threads being in flight
-	size_t num_splits = std::min(effect_files.size(), static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 2u) - 1));
-#ifndef _WIN64
-	// Limit number of threads in 32-bit due to the limited about of address space being available there and compilation being memory hungry
-	num_splits = std::min(num_splits, static_cast<size_t>(4));
-#endif
-
-	// Keep track of the spawned threads, so the runtime cannot be destroyed while they are still running
-	for (size_t n = 0; n < num_splits; ++n)
-		_worker_threads.emplace_back([this, effect_files, offset, num_splits, n, &preset, force_load_all]() {
+	// Every file is a separate job, so that worker threads which finished early can pick up the remaining files while a long-running one is still compiling
+	for (size_t i = 0; i < effect_files.size(); ++i)
+		_jobs.submit(_effect_load_jobs, [this, effect_file = effect_files[i], effect_index = offset + i, &preset, force_load_all]() {
 			// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
-			for (size_t i = 0; i < effect_files.size() && _is_initialized; ++i)
-				if (i * num_splits / effect_files.size() == n)
-					load_effect(effect_files[i], preset, offset + i, 0, force_load_all || effect_files[i].extension() == L".addonfx");
+			if (_is_initialized)
+				load_effect(effect_file, preset, effect_index, 0, force_load_all || effect_file.extension() == L".addonfx");
 		});
 }
 bool reshade::runtime::reload_effect(size_t effect_index)
@@ -3622,10 +3969,8 @@ void reshade::runtime::reload_effects(bool force_load_all)
 void reshade::runtime::destroy_effects()
 {
 	// Make sure no threads are still accessing effect data
-	for (std::thread &thread : _worker_threads)
-		if (thread.joinable())
-			thread.join();
-	_worker_threads.clear();
+	_jobs.cancel(_effect_load_jobs);
+	_jobs.wait(_file_save_jobs);
 
 #if RESHADE_GUI
 	_effect_filter[0] = '\0';
@@ -3645,6 +3990,9 @@ void reshade::runtime::destroy_effects()
 	// Reset the effect list after all resources have been destroyed
 	_effects.clear();
 
+	// Release include files shared between all effects during loading, they are read again on the next reload
+	reshadefx::preprocessor::clear_include_cache();
+
 	// Clean up sampler objects
 	for (const auto &[hash, sampler] : _effect_sampler_states)
 		_device->destroy_sampler(sampler);
@@ -3711,7 +4059,7 @@ void reshade::runtime::clear_effect_cache()
 
 		const std::filesystem::path filename = entry.path().filename();
 		const std::filesystem::path extension = entry.path().extension();
-		if (filename.native().compare(0, 8, L"reshade-") != 0 || (extension != L".i" && extension != L".cso" && extension != L".asm"))
+		if (filename.native().compare(0, 8, L"reshade-") != 0 || (extension != L".i" && extension != L".fxm" && extension != L".cso" && extension != L".asm"))
 			continue;
 
 		std::filesystem::remove(entry, ec);
@@ -3825,9 +4173,10 @@ void reshade::runtime::update_effects()
 			{
 				_reload_remaining_effects += 1;
 
-				_worker_threads.emplace_back([this, effect_index, permutation_index]() {
+				// Prioritize this over other jobs, since the permutation is needed to render the next frames
+				_jobs.submit(_effect_load_jobs, [this, effect_index, permutation_index]() {
 						load_effect(_effects[effect_index].source_file, ini_file::load_cache(_current_preset_path), effect_index, permutation_index, true);
-					});
+					}, job_system::priority::high);
 			}
 
 			// Force immediate effect initialization of this permutation after reloading
@@ -3841,15 +4190,25 @@ void reshade::runtime::update_effects()
 
 	if (_reload_remaining_effects == 0)
 	{
-		// Clear the thread list now that they all have finished
-		for (std::thread &thread : _worker_threads)
-			if (thread.joinable())
-				thread.join(); // Threads have exited, but still need to join them prior to destruction
-		_worker_threads.clear();
+		// Loading jobs decrement the counter before they are done logging, so wait for them to return before effects are modified below
+		_jobs.wait(_effect_load_jobs);
 
 		// Finished loading effects, so apply preset to figure out which ones need compiling
 		load_current_preset();
 
+		if (_alias_transient_textures)
+		{
+			// Report how much memory was saved by textures that were aliased with others (those are no longer in the texture list under their own name)
+			uint64_t aliased_memory_size = 0;
+			for (const effect &effect : _effects)
+				if (effect.compiled && !effect.permutations.empty())
+					for (const reshadefx::texture &tex : effect.permutations[0].module.textures)
+						if (tex.semantic.empty() && std::find_if(_textures.cbegin(), _textures.cend(), [&tex](const texture &item) { return item.unique_name == tex.unique_name; }) == _textures.cend())
+							aliased_memory_size += calc_texture_memory_size(tex);
+
+			log::message(log::level::info, "Aliasing transient and pooled textures saved %.1f MiB of memory.", aliased_memory_size / (1024.0 * 1024.0));
+		}
+
 #if RESHADE_ADDON
 		invoke_addon_event<addon_event::reshade_set_current_preset_path>(this, _current_preset_path.u8string().c_str());
 #endif
@@ -3955,9 +4314,11 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 		if (!effect.rendering || (!_effects_enabled && !effect.addon))
 			continue;
 
-		for (uniform &variable : effect.uniforms)
+		for (const uniform_update &update : effect.uniform_updates)
 		{
-			switch (variable.special)
+			uniform &variable = effect.uniforms[update.uniform_index];
+
+			switch (update.special)
 			{
 				case special_uniform::frame_time:
 				{
@@ -3974,19 +4335,19 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 				}
 				case special_uniform::random:
 				{
-					const int min = variable.annotation_as_int("min", 0, 0);
-					const int max = variable.annotation_as_int("max", 0, RAND_MAX);
+					const int min = update.int_range[0];
+					const int max = update.int_range[1];
 					set_uniform_value(variable, min + (std::rand() % (std::abs(max - min) + 1)));
 					break;
 				}
 				case special_uniform::ping_pong:
 				{
-					const float min = variable.annotation_as_float("min", 0, 0.0f);
-					const float max = variable.annotation_as_float("max", 0, 1.0f);
-					const float step_min = variable.annotation_as_float("step", 0);
-					const float step_max = variable.annotation_as_float("step", 1);
+					const float min = update.float_range[0];
+					const float max = update.float_range[1];
+					const float step_min = update.step[0];
+					const float step_max = update.step[1];
 					float increment = step_max == 0 ? step_min : (step_min + std::fmod(static_cast<float>(std::rand()), step_max - step_min + 1));
-					const float smoothing = variable.annotation_as_float("smoothing");
+					const float smoothing = update.smoothing;
 
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
@@ -4034,22 +4395,17 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					if (const int keycode = variable.annotation_as_int("keycode");
-						keycode > 7 && keycode < 256)
+					if (update.mode == uniform_update::key_mode::toggle)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
-						{
-							bool current_value = false;
-							get_uniform_value(variable, &current_value);
-							if (_input->is_key_pressed(keycode))
-								set_uniform_value(variable, !current_value);
-						}
-						else if (mode == "press")
-							set_uniform_value(variable, _input->is_key_pressed(keycode));
-						else
-							set_uniform_value(variable, _input->is_key_down(keycode));
+						bool current_value = false;
+						get_uniform_value(variable, &current_value);
+						if (_input->is_key_pressed(update.keycode))
+							set_uniform_value(variable, !current_value);
 					}
+					else if (update.mode == uniform_update::key_mode::press)
+						set_uniform_value(variable, _input->is_key_pressed(update.keycode));
+					else
+						set_uniform_value(variable, _input->is_key_down(update.keycode));
 					break;
 				}
 				case special_uniform::mouse_point:
@@ -4073,22 +4429,17 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					if (const int keycode = variable.annotation_as_int("keycode");
-						keycode >= 0 && keycode < 5)
+					if (update.mode == uniform_update::key_mode::toggle)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
-						{
-							bool current_value = false;
-							get_uniform_value(variable, &current_value);
-							if (_input->is_mouse_button_pressed(keycode))
-								set_uniform_value(variable, !current_value);
-						}
-						else if (mode == "press")
-							set_uniform_value(variable, _input->is_mouse_button_pressed(keycode));
-						else
-							set_uniform_value(variable, _input->is_mouse_button_down(keycode));
+						bool current_value = false;
+						get_uniform_value(variable, &current_value);
+						if (_input->is_mouse_button_pressed(update.keycode))
+							set_uniform_value(variable, !current_value);
 					}
+					else if (update.mode == uniform_update::key_mode::press)
+						set_uniform_value(variable, _input->is_mouse_button_pressed(update.keycode));
+					else
+						set_uniform_value(variable, _input->is_mouse_button_down(update.keycode));
 					break;
 				}
 				case special_uniform::mouse_wheel:
@@ -4096,11 +4447,9 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					const float min = variable.annotation_as_float("min");
-					const float max = variable.annotation_as_float("max");
-					float step = variable.annotation_as_float("step");
-					if (step == 0.0f)
-						step  = 1.0f;
+					const float min = update.float_range[0];
+					const float max = update.float_range[1];
+					const float step = update.step[0];
 
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
@@ -4176,6 +4525,33 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 	cmd_list->begin_debug_event("ReShade effects");
 #endif
 
+#if RESHADE_GUI
+	// Periodically decide which techniques to throttle to stay within the GPU time budget, based on their measured durations
+	// Doing this only every so often avoids techniques flipping between rates each frame due to small variations in the measurements
+	if (_gpu_time_budget > 0.0f && _timestamp_frequency != 0 && (_frame_count % 60) == 0)
+	{
+		std::vector<size_t> scheduled_techniques;
+		std::vector<technique_schedule> schedules;
+
+		for (size_t technique_index : _technique_sorting)
+		{
+			technique &tech = _techniques[technique_index];
+			if (!tech.enabled)
+				continue;
+
+			tech.schedule.gpu_duration = tech.average_gpu_duration;
+
+			scheduled_techniques.push_back(technique_index);
+			schedules.push_back(tech.schedule);
+		}
+
+		schedule_techniques(schedules, static_cast<uint64_t>(_gpu_time_budget * 1000000.0f));
+
+		for (size_t i = 0; i < scheduled_techniques.size(); ++i)
+			_techniques[scheduled_techniques[i]].schedule = schedules[i];
+	}
+#endif
+
 	// Render all enabled techniques
 	for (size_t technique_index : _technique_sorting)
 	{
@@ -4194,7 +4570,8 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 			continue;
 		}
 
-		render_technique(tech, cmd_list, back_buffer_resource, rtv, rtv_srgb, permutation_index);
+		if (_gpu_time_budget <= 0.0f || tech.schedule.should_render(_frame_count))
+			render_technique(tech, cmd_list, back_buffer_resource, rtv, rtv_srgb, permutation_index);
 
 		if (tech.time_left > 0)
 		{
@@ -4217,11 +4594,11 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 }
 void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_list, api::resource back_buffer_resource, api::resource_view back_buffer_rtv, api::resource_view back_buffer_rtv_srgb, size_t permutation_index)
 {
-	const effect &effect = _effects[tech.effect_index];
+	effect &effect = _effects[tech.effect_index];
 	const effect::permutation &permutation = effect.permutations[permutation_index];
 
 #if RESHADE_GUI
-	if (_gather_gpu_statistics && _timestamp_frequency != 0 && effect.query_heap != 0 && permutation_index == 0)
+	if ((_gather_gpu_statistics || _gpu_time_budget > 0.0f) && _timestamp_frequency != 0 && effect.query_heap != 0 && permutation_index == 0)
 	{
 		// Evaluate queries from oldest frame in queue
 		if (uint64_t timestamps[2];
@@ -4238,17 +4615,8 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 	cmd_list->begin_debug_event(tech.name.c_str());
 #endif
 
-	// Update shader constants
-	if (void *mapped_uniform_data;
-		effect.cb != 0 && _device->map_buffer_region(effect.cb, 0, std::numeric_limits<uint64_t>::max(), api::map_access::write_discard, &mapped_uniform_data))
-	{
-		std::memcpy(mapped_uniform_data, effect.uniform_data_storage.data(), effect.uniform_data_storage.size());
-		_device->unmap_buffer_region(effect.cb);
-	}
-	else if (_renderer_id == 0x9000)
-	{
-		cmd_list->push_constants(api::shader_stage::all, permutation.layout, 0, 0, static_cast<uint32_t>(effect.uniform_data_storage.size() / 4), effect.uniform_data_storage.data());
-	}
+	// Update shader constants (only if they changed since the last technique of this effect was rendered)
+	effect.update_uniform_data(_device, cmd_list, permutation.layout, _renderer_id);
 
 	const bool sampler_with_resource_view = _device->check_capability(api::device_caps::sampler_with_resource_view);
 
@@ -4275,8 +4643,6 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 		cmd_list->begin_debug_event((pass.name.empty() ? "Pass " + std::to_string(pass_index) : pass.name).c_str());
 #endif
 
-		const uint32_t num_barriers = static_cast<uint32_t>(pass.modified_resources.size());
-
 		if (!pass.cs_entry_point.empty())
 		{
 			// Compute shaders do not write to the back buffer, so no update necessary
@@ -4284,10 +4650,8 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			cmd_list->bind_pipeline(api::pipeline_stage::all_compute, pass.pipeline);
 
-			temp_mem<api::resource_usage> state_old, state_new;
-			std::fill_n(state_old.p, num_barriers, api::resource_usage::shader_resource);
-			std::fill_n(state_new.p, num_barriers, api::resource_usage::unordered_access);
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_old.p, state_new.p);
+			// Transition resource state for storage access
+			cmd_list->barrier(static_cast<uint32_t>(pass.barriers_before.resources.size()), pass.barriers_before.resources.data(), pass.barriers_before.old_states.data(), pass.barriers_before.new_states.data());
 
 			// Reset bindings on every pass (since they get invalidated by the call to 'generate_mipmaps' below)
 			if (effect.cb != 0)
@@ -4302,17 +4666,15 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			cmd_list->dispatch(pass.viewport_width, pass.viewport_height, pass.viewport_dispatch_z);
 
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_new.p, state_old.p);
+			// Transition resource state back to shader access (unless the next pass writes to it too)
+			cmd_list->barrier(static_cast<uint32_t>(pass.barriers_after.resources.size()), pass.barriers_after.resources.data(), pass.barriers_after.old_states.data(), pass.barriers_after.new_states.data());
 		}
 		else
 		{
 			cmd_list->bind_pipeline(api::pipeline_stage::all_graphics, pass.pipeline);
 
 			// Transition resource state for render targets
-			temp_mem<api::resource_usage> state_old, state_new;
-			std::fill_n(state_old.p, num_barriers, api::resource_usage::shader_resource);
-			std::fill_n(state_new.p, num_barriers, api::resource_usage::render_target);
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_old.p, state_new.p);
+			cmd_list->barrier(static_cast<uint32_t>(pass.barriers_before.resources.size()), pass.barriers_before.resources.data(), pass.barriers_before.old_states.data(), pass.barriers_before.new_states.data());
 
 			// Setup render targets
 			uint32_t render_target_count = 0;
@@ -4416,8 +4778,8 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 			cmd_list->end_render_pass();
 
-			// Transition resource state back to shader access
-			cmd_list->barrier(num_barriers, pass.modified_resources.data(), state_new.p, state_old.p);
+			// Transition resource state back to shader access (unless the next pass writes to it too)
+			cmd_list->barrier(static_cast<uint32_t>(pass.barriers_after.resources.size()), pass.barriers_after.resources.data(), pass.barriers_after.old_states.data(), pass.barriers_after.new_states.data());
 		}
 
 		// Generate mipmaps for modified resources
@@ -4438,7 +4800,7 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 
 	tech.average_cpu_duration.append(std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
 
-	if (_gather_gpu_statistics && _timestamp_frequency != 0 && effect.query_heap != 0 && permutation_index == 0)
+	if ((_gather_gpu_statistics || _gpu_time_budget > 0.0f) && _timestamp_frequency != 0 && effect.query_heap != 0 && permutation_index == 0)
 		cmd_list->end_query(effect.query_heap, api::query_type::timestamp, tech.query_base_index + (_frame_count % 4) * 2 + 1);
 #endif
 
@@ -4470,7 +4832,7 @@ void reshade::runtime::save_texture(const texture &tex)
 	if (std::vector<uint8_t> pixels(static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height) * 4);
 		get_texture_data(tex.resource, api::resource_usage::shader_resource, pixels.data()))
 	{
-		_worker_threads.emplace_back([this, screenshot_path, pixels = std::move(pixels), width = tex.width, height = tex.height]() mutable {
+		_jobs.submit(_file_save_jobs, [this, screenshot_path, pixels = std::move(pixels), width = tex.width, height = tex.height]() mutable {
 			// Default to a save failure unless it is reported to succeed below
 			bool save_success = false;
 
@@ -4511,7 +4873,7 @@ void reshade::runtime::save_texture(const texture &tex)
 				_last_screenshot_file = screenshot_path;
 				_last_screenshot_save_successful = save_success;
 			}
-		});
+		}, job_system::priority::high);
 	}
 }
 void reshade::runtime::update_texture(texture &tex, uint32_t width, uint32_t height, uint32_t depth, const void *pixels)
@@ -4609,6 +4971,7 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 	if (variable.special != reshade::special_uniform::none)
 	{
 		std::memset(_effects[variable.effect_index].uniform_data_storage.data() + variable.offset, 0, variable.size);
+		_effects[variable.effect_index].mark_uniform_data_dirty(variable.offset, variable.size);
 		return;
 	}
 
@@ -4750,7 +5113,8 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 	size = std::min(size, static_cast<size_t>(variable.size));
 	assert(data != nullptr && (size % 4) == 0);
 
-	std::vector<uint8_t> &data_storage = _effects[variable.effect_index].uniform_data_storage;
+	effect &effect = _effects[variable.effect_index];
+	std::vector<uint8_t> &data_storage = effect.uniform_data_storage;
 	assert(variable.offset + size <= data_storage.size());
 
 	const size_t array_length = (variable.type.is_array() ? variable.type.array_length : 1u);
@@ -4778,8 +5142,14 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 	}
 	else
 	{
+		// Many special variables are set to the same value every frame, which should not cause the constant buffer to be updated again
+		if (std::memcmp(data_storage.data() + variable.offset, data, size) == 0)
+			return;
+
 		std::memcpy(data_storage.data() + variable.offset, data, size);
 	}
+
+	effect.mark_uniform_data_dirty(variable.offset, variable.size);
 }
 
 template <> void reshade::runtime::set_uniform_value<bool>(uniform &variable, const bool *values, size_t count, size_t array_index)
@@ -4995,7 +5365,8 @@ void reshade::runtime::save_screenshot(const std::string_view postfix)
 		if (!_screenshot_sound_path.empty())
 			utils::play_sound_async(g_reshade_base_path / _screenshot_sound_path);
 
-		_worker_threads.emplace_back([this, screenshot_count, screenshot_format, screenshot_path, postfix, pixels = std::move(pixels), include_preset]() mutable {
+		// Encode and write the image in the background, ahead of any effects that may still be loading
+		_jobs.submit(_file_save_jobs, [this, screenshot_count, screenshot_format, screenshot_path, postfix, pixels = std::move(pixels), include_preset]() mutable {
 			// Remove alpha channel
 			int comp = 4;
 			if (_screenshot_clear_alpha && screenshot_format != 3)
@@ -5079,7 +5450,7 @@ void reshade::runtime::save_screenshot(const std::string_view postfix)
 				_last_screenshot_file = screenshot_path;
 				_last_screenshot_save_successful = save_success;
 			}
-		});
+		}, job_system::priority::high);
 	}
 }
 bool reshade::runtime::execute_screenshot_post_save_command(const std::filesystem::path &screenshot_path, unsigned int screenshot_count, std::string_view postfix)
@@ -8,6 +8,7 @@
 #include "reshade_api.hpp"
 #include "state_block.hpp"
 #include "imgui_code_editor.hpp"
+#include "job_system.hpp"
 #include <chrono>
 #include <memory>
 #include <filesystem>
@@ -284,6 +285,8 @@ namespace reshade
 		bool _no_reload_on_init = false;
 		bool _performance_mode = false;
 		bool _effect_load_skipping = false;
+		bool _alias_transient_textures = false;
+		bool _optimize_spirv = false;
 		unsigned int _reload_key_data[4] = {};
 		unsigned int _performance_mode_key_data[4] = {};
 
@@ -293,6 +296,7 @@ namespace reshade
 
 		std::filesystem::path _effect_cache_path;
 		std::vector<std::filesystem::path> _effect_search_paths;
+		std::vector<std::filesystem::path> _effect_include_paths;
 		std::vector<std::filesystem::path> _texture_search_paths;
 
 		std::atomic<bool> _last_reload_successful = true;
@@ -306,7 +310,14 @@ namespace reshade
 		std::vector<technique> _techniques;
 		std::vector<size_t> _technique_sorting;
 
-		std::vector<std::thread> _worker_threads;
+		job_system::group _effect_load_jobs;
+		job_system::group _file_save_jobs;
+#ifndef _WIN64
+		// Limit number of threads in 32-bit due to the limited amount of address space being available there and compilation being memory hungry
+		job_system _jobs { 4 };
+#else
+		job_system _jobs;
+#endif
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
 		#pragma endregion
 
@@ -345,6 +356,8 @@ namespace reshade
 
 		api::fence _queue_sync_fence = {};
 		uint64_t _queue_sync_value = 0;
+
+		float _gpu_time_budget = 0.0f; // In milliseconds, zero to render all techniques every frame
 		#pragma endregion
 
 		#pragma region Screenshot
@@ -7,6 +7,8 @@
 
 #include "effect_module.hpp"
 #include "moving_average.hpp"
+#include "gpu_budget.hpp"
+#include <cstring> // std::memcpy
 
 namespace reshade
 {
@@ -31,6 +33,47 @@ namespace reshade
 		unknown
 	};
 
+	/// <summary>
+	/// Converts the value of the "source" annotation of a uniform variable to the special uniform type it refers to.
+	/// </summary>
+	inline special_uniform special_uniform_from_source(const std::string_view source)
+	{
+		if (source.empty()) /* Ignore if annotation is missing */
+			return special_uniform::none;
+		else if (source == "frametime")
+			return special_uniform::frame_time;
+		else if (source == "framecount")
+			return special_uniform::frame_count;
+		else if (source == "random")
+			return special_uniform::random;
+		else if (source == "pingpong")
+			return special_uniform::ping_pong;
+		else if (source == "date")
+			return special_uniform::date;
+		else if (source == "timer")
+			return special_uniform::timer;
+		else if (source == "key")
+			return special_uniform::key;
+		else if (source == "mousepoint")
+			return special_uniform::mouse_point;
+		else if (source == "mousedelta")
+			return special_uniform::mouse_delta;
+		else if (source == "mousebutton")
+			return special_uniform::mouse_button;
+		else if (source == "mousewheel")
+			return special_uniform::mouse_wheel;
+		else if (source == "ui_open" || source == "overlay_open")
+			return special_uniform::overlay_open;
+		else if (source == "ui_active" || source == "overlay_active")
+			return special_uniform::overlay_active;
+		else if (source == "ui_hovered" || source == "overlay_hovered")
+			return special_uniform::overlay_hovered;
+		else if (source == "screenshot")
+			return special_uniform::screenshot;
+		else
+			return special_uniform::unknown;
+	}
+
 	struct texture : reshadefx::texture
 	{
 		texture(const reshadefx::texture &init) : reshadefx::texture(init) {}
@@ -72,6 +115,18 @@ namespace reshade
 
 		std::vector<size_t> shared;
 		bool loaded = false;
+		// Contents only live within a single technique, so the texture can be shared with other transient or pooled textures of the same description
+		bool transient = false;
+
+		struct alias
+		{
+			size_t effect_index;
+			size_t permutation_index;
+			std::string unique_name;
+		};
+
+		// Transient or pooled textures of other effects that share this texture, under the name they were declared with in those effects
+		std::vector<alias> aliases;
 
 		api::resource resource = {};
 		api::resource_view srv[2] = {};
@@ -128,6 +183,76 @@ namespace reshade
 		special_uniform special = special_uniform::none;
 	};
 
+	/// <summary>
+	/// A per-frame update of a special uniform variable, with all its parameters resolved from the annotations once at load time.
+	/// </summary>
+	struct uniform_update
+	{
+		enum class key_mode
+		{
+			down,
+			press,
+			toggle
+		};
+
+		uniform_update(const uniform &variable, size_t uniform_index) :
+			special(variable.special),
+			uniform_index(uniform_index)
+		{
+			switch (special)
+			{
+			case special_uniform::random:
+				int_range[0] = variable.annotation_as_int("min", 0, 0);
+				int_range[1] = variable.annotation_as_int("max", 0, RAND_MAX);
+				break;
+			case special_uniform::ping_pong:
+				float_range[0] = variable.annotation_as_float("min", 0, 0.0f);
+				float_range[1] = variable.annotation_as_float("max", 0, 1.0f);
+				step[0] = variable.annotation_as_float("step", 0);
+				step[1] = variable.annotation_as_float("step", 1);
+				smoothing = variable.annotation_as_float("smoothing");
+				break;
+			case special_uniform::key:
+			case special_uniform::mouse_button:
+				keycode = variable.annotation_as_int("keycode");
+				// Ignore key codes that are out of range, so that those do not need to be checked every frame
+				if (special == special_uniform::key ? keycode <= 7 || keycode >= 256 : keycode < 0 || keycode >= 5)
+				{
+					special = special_uniform::none;
+					break;
+				}
+				if (const std::string_view mode_name = variable.annotation_as_string("mode");
+					mode_name == "toggle" || variable.annotation_as_int("toggle"))
+					mode = key_mode::toggle;
+				else if (mode_name == "press")
+					mode = key_mode::press;
+				break;
+			case special_uniform::mouse_wheel:
+				float_range[0] = variable.annotation_as_float("min");
+				float_range[1] = variable.annotation_as_float("max");
+				step[0] = variable.annotation_as_float("step");
+				if (step[0] == 0.0f)
+					step[0] = 1.0f;
+				break;
+			case special_uniform::unknown:
+				special = special_uniform::none;
+				break;
+			default:
+				break;
+			}
+		}
+
+		special_uniform special;
+		size_t uniform_index;
+
+		int keycode = 0;
+		key_mode mode = key_mode::down;
+		int int_range[2] = {};
+		float float_range[2] = {};
+		float step[2] = {};
+		float smoothing = 0.0f;
+	};
+
 	struct technique
 	{
 		technique(const reshadefx::technique &init) :
@@ -179,6 +304,29 @@ namespace reshade
 		bool enabled_in_screenshot = true;
 		int64_t time_left = 0;
 
+		// Priority and rate at which this technique is rendered when a GPU time budget is set
+		technique_schedule schedule;
+
+		struct barrier_list
+		{
+			void push_back(api::resource resource, api::resource_usage old_state, api::resource_usage new_state)
+			{
+				resources.push_back(resource);
+				old_states.push_back(old_state);
+				new_states.push_back(new_state);
+			}
+			void clear()
+			{
+				resources.clear();
+				old_states.clear();
+				new_states.clear();
+			}
+
+			std::vector<api::resource> resources;
+			std::vector<api::resource_usage> old_states;
+			std::vector<api::resource_usage> new_states;
+		};
+
 		struct pass : reshadefx::pass
 		{
 			pass(const reshadefx::pass &init) : reshadefx::pass(init) {}
@@ -189,6 +337,10 @@ namespace reshade
 			api::descriptor_table storage_table = {};
 			std::vector<api::resource> modified_resources;
 			std::vector<api::resource_view> generate_mipmap_views;
+
+			// Resource transitions to perform before and after this pass, which leave out those between consecutive passes writing to the same resource
+			barrier_list barriers_before;
+			barrier_list barriers_after;
 		};
 
 		struct permutation
@@ -197,6 +349,56 @@ namespace reshade
 			bool created = false;
 		};
 
+		/// <summary>
+		/// Checks whether a resource can stay in its write state between the specified pass and the one following it.
+		/// </summary>
+		static bool keeps_write_state(const technique::pass &pass, const technique::pass &next_pass, api::resource resource)
+		{
+			// Resource has to be in shader resource state for mipmap generation after the pass
+			if (!pass.generate_mipmap_views.empty())
+				return false;
+			// Both passes have to write to the resource in the same way (either as render target or as storage)
+			if (pass.cs_entry_point.empty() != next_pass.cs_entry_point.empty())
+				return false;
+
+			return std::find(pass.modified_resources.cbegin(), pass.modified_resources.cend(), resource) != pass.modified_resources.cend() &&
+				std::find(next_pass.modified_resources.cbegin(), next_pass.modified_resources.cend(), resource) != next_pass.modified_resources.cend();
+		}
+
+		/// <summary>
+		/// Fills the lists of resource transitions to perform before and after each of the specified passes, based on the resources they modify.
+		/// </summary>
+		static void plan_barriers(std::vector<pass> &passes, bool render_target_write_dependencies)
+		{
+			for (size_t pass_index = 0; pass_index < passes.size(); ++pass_index)
+			{
+				technique::pass &pass = passes[pass_index];
+
+				const api::resource_usage write_state = pass.cs_entry_point.empty() ? api::resource_usage::render_target : api::resource_usage::unordered_access;
+
+				pass.barriers_before.clear();
+				pass.barriers_after.clear();
+
+				for (const api::resource resource : pass.modified_resources)
+				{
+					if (pass_index != 0 && keeps_write_state(passes[pass_index - 1], pass, resource))
+					{
+						// Writes of consecutive passes still need to be ordered (UAV barrier in D3D12, execution dependency in Vulkan), which is implicit for render targets in all but Vulkan
+						if (write_state == api::resource_usage::unordered_access || render_target_write_dependencies)
+							pass.barriers_before.push_back(resource, write_state, write_state);
+					}
+					else
+					{
+						pass.barriers_before.push_back(resource, api::resource_usage::shader_resource, write_state);
+					}
+
+					// Only transition back to shader resource state if the next pass does not write to the resource again anyway
+					if (pass_index + 1 == passes.size() || !keeps_write_state(pass, passes[pass_index + 1], resource))
+						pass.barriers_after.push_back(resource, write_state, api::resource_usage::shader_resource);
+				}
+			}
+		}
+
 		std::vector<permutation> permutations;
 
 		uint32_t query_base_index = 0;
@@ -206,6 +408,48 @@ namespace reshade
 
 	struct effect
 	{
+		void mark_uniform_data_dirty(size_t offset, size_t size)
+		{
+			uniform_data_dirty_begin = std::min(uniform_data_dirty_begin, offset);
+			uniform_data_dirty_end = std::max(uniform_data_dirty_end, offset + size);
+		}
+
+		/// <summary>
+		/// Uploads the uniform data storage to the constant buffer, if it changed since the last time this was called (or sets it as push constants on D3D9).
+		/// </summary>
+		void update_uniform_data(api::device *device, api::command_list *cmd_list, api::pipeline_layout layout, uint32_t renderer_id)
+		{
+			if (cb != 0 && uniform_data_dirty_begin < uniform_data_dirty_end)
+			{
+				size_t update_begin = uniform_data_dirty_begin;
+				size_t update_end = std::min(uniform_data_dirty_end, uniform_data_storage.size());
+
+				// Mapping with discard invalidates the entire buffer in D3D10, D3D11 and OpenGL, so have to write everything there
+				// D3D12 and Vulkan map the same memory every time, so it is sufficient to only write the modified range
+				const bool update_partial = renderer_id >= 0xc000 && (renderer_id & 0x10000) == 0;
+				if (!update_partial)
+				{
+					update_begin = 0;
+					update_end = uniform_data_storage.size();
+				}
+
+				if (void *mapped_uniform_data;
+					device->map_buffer_region(cb, update_begin, update_end - update_begin, update_partial ? api::map_access::write_only : api::map_access::write_discard, &mapped_uniform_data))
+				{
+					std::memcpy(mapped_uniform_data, uniform_data_storage.data() + update_begin, update_end - update_begin);
+					device->unmap_buffer_region(cb);
+
+					uniform_data_dirty_begin = std::numeric_limits<size_t>::max();
+					uniform_data_dirty_end = 0;
+				}
+			}
+			else if (renderer_id == 0x9000)
+			{
+				// Constant registers are shared between all effects and the application, so always have to be set again
+				cmd_list->push_constants(api::shader_stage::all, layout, 0, 0, static_cast<uint32_t>(uniform_data_storage.size() / 4), uniform_data_storage.data());
+			}
+		}
+
 		std::filesystem::path source_file;
 		size_t source_hash = 0;
 		bool addon = false;
@@ -220,7 +464,11 @@ namespace reshade
 		std::vector<std::pair<std::string, std::string>> definitions;
 
 		std::vector<uniform> uniforms;
+		std::vector<uniform_update> uniform_updates;
 		std::vector<uint8_t> uniform_data_storage;
+		// Byte range of the uniform data storage that was modified since it was last uploaded to the constant buffer
+		size_t uniform_data_dirty_begin = std::numeric_limits<size_t>::max();
+		size_t uniform_data_dirty_end = 0;
 		api::resource cb = {};
 
 		struct binding
@@ -239,6 +487,11 @@ namespace reshade
 			std::unordered_map<std::string, std::string> assembly;
 			std::unordered_map<std::string, std::string> assembly_text;
 
+			// Hash of the attributes that are the same for all permutations, which is only set once this permutation compiled successfully
+			size_t shared_source_hash = 0;
+			// Permutation-specific macros (like 'BUFFER_WIDTH') that the source code referenced, so that permutations only differing in other macros can share the compiled code
+			std::vector<std::string> referenced_macros;
+
 			api::pipeline_layout layout = {};
 			api::descriptor_table cb_table = {};
 			api::descriptor_table sampler_table = {};
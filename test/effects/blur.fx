@@ -0,0 +1,126 @@
+#include "common.fxh"
+
+#ifndef BLUR_SAMPLES
+	#define BLUR_SAMPLES 7
+#endif
+
+#define CAT(a, b) a##b
+#define STR(x) #x
+#define APPLY2(f, x) f(f(x))
+#define SQ(x) ((x) * (x))
+#define UNROLL4(body) body(0) body(1) body(2) body(3)
+#define ACC(i) sum += tex2D(Common::BackBuffer, uv + offsets[i] * PixelDir).rgb * weights[i];
+
+uniform float BlurRadius < ui_type = "slider";
+	ui_min = 0.0; ui_max = 10.0; ui_step = 0.1;
+	ui_label = "Radius";
+> = 1.0;
+uniform float3 Tint < ui_type = "color"; > = float3(1.0, 0.9, 0.8);
+uniform int Mode < ui_type = "combo"; ui_items = "A\0B\0C\0"; > = 1;
+uniform float Timer < source = "timer"; >;
+uniform int FrameCount < source = "framecount"; >;
+uniform bool KeyDown < source = "key"; keycode = 0x20; mode = "toggle"; >;
+
+static const float weights[7] = { 0.1964825501511404, 0.2969069646728344, 0.2969069646728344, 0.09447039785044732, 0.09447039785044732, 0.010381362401148057, 0.010381362401148057 };
+static const float offsets[7] = { 0.0, 1.411764705882353, -1.411764705882353, 3.2941176470588234, -3.2941176470588234, 5.176470588235294, -5.176470588235294 };
+
+texture BlurTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; MipLevels = 3; };
+texture BlurTex2 { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; };
+sampler BlurSampler { Texture = BlurTex; AddressU = MIRROR; MinFilter = POINT; };
+sampler BlurSampler2 { Texture = BlurTex2; };
+
+struct VSOut
+{
+	float4 pos : SV_Position;
+	float2 uv : TEXCOORD0;
+	nointerpolation float3 tint : TEXCOORD1;
+};
+
+float luma(float3 c) { return dot(c, float3(0.2126, 0.7152, 0.0722)); }
+float luma(float4 c) { return luma(c.rgb) * c.a; }
+
+float3 blur(sampler s, float2 uv, float2 dir)
+{
+	float3 sum = 0;
+	const float2 PixelDir = dir * BUFFER_PIXEL_SIZE * BlurRadius;
+	[unroll]
+	for (int i = 0; i < BLUR_SAMPLES; ++i)
+		sum += tex2D(s, uv + offsets[i] * PixelDir).rgb * weights[i];
+	return sum;
+}
+
+float3 blur_unrolled(float2 uv, float2 dir)
+{
+	float3 sum = 0;
+	const float2 PixelDir = dir * BUFFER_PIXEL_SIZE;
+	UNROLL4(ACC)
+	return sum;
+}
+
+VSOut MainVS(uint id : SV_VertexID)
+{
+	VSOut o;
+	PostProcessVS(id, o.pos, o.uv);
+	o.tint = Tint;
+	return o;
+}
+
+float4 HorizontalPS(VSOut i) : SV_Target
+{
+	float3 c = blur(Common::BackBuffer, i.uv, float2(1, 0));
+	float l = luma(float4(c, 1.0));
+	int k = 0;
+	while (k < 4 && l > 0.5) { l *= 0.5; k++; }
+	switch (Mode)
+	{
+	case 0: c *= 0.5; break;
+	case 1: c = lerp(c, i.tint, 0.25); break;
+	default: c = saturate(c * SQ(l)); break;
+	}
+	if (KeyDown) c = 1 - c;
+	else if (FrameCount % 2 == 0) c = c.bgr;
+	return float4(c + blur_unrolled(i.uv, float2(0, 1)) * 0.01, APPLY2(sqrt, 16.0) / 2.0);
+}
+float4 VerticalPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float3 c = blur(BlurSampler, uv, float2(0, 1));
+	float d = Common::GetLinearizedDepth(uv);
+	float4 r = float4(c * (1 + sin(Timer * 0.001) * 0.1), d);
+	float3x3 m = float3x3(1, 0, 0, 0, 1, 0, 0, 0, 1);
+	r.rgb = mul(m, r.rgb);
+	r.xy = abs(ddx(r.xy)) + fwidth(r.zw) + max(r.x, r.y) + clamp(r.zw, 0, 1) + pow(abs(r.xy), 2.2);
+	return r * tex2Dfetch(BlurSampler2, int2(pos.xy)).r;
+}
+float4 CombinePS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	return float4(tex2D(BlurSampler, uv).rgb * exp2(log2(0.5)) + smoothstep(0.2, 0.8, uv.x), 1.0);
+}
+
+technique CAT(Blur, Effect) < ui_label = STR(Blur effect); ui_tooltip = "Test"; >
+{
+	pass Horizontal
+	{
+		VertexShader = MainVS;
+		PixelShader = HorizontalPS;
+		RenderTarget = BlurTex;
+	}
+	pass Vertical
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = VerticalPS;
+		RenderTarget0 = BlurTex2;
+		BlendEnable = true;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+	}
+	pass Combine
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+		SRGBWriteEnable = true;
+	}
+}
+technique BlurOnly
+{
+	pass { VertexShader = PostProcessVS; PixelShader = CombinePS; }
+}
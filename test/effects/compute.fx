@@ -0,0 +1,64 @@
+#include "common.fxh"
+#pragma warning(disable : 3571)
+
+texture HistTex { Width = 256; Height = 1; Format = R32F; };
+texture OutTex { Width = BUFFER_WIDTH; Height = BUFFER_HEIGHT; Format = RGBA8; };
+storage HistStorage { Texture = HistTex; };
+storage2D OutStorage { Texture = OutTex; };
+sampler OutSampler { Texture = OutTex; };
+
+groupshared uint bins[256];
+
+namespace Compute
+{
+	struct Params { float scale; int2 offset; };
+
+	Params make_params(float s)
+	{
+		Params p;
+		p.scale = s;
+		p.offset = int2(1, 2);
+		return p;
+	}
+
+	void HistCS(uint3 tid : SV_DispatchThreadID, uint3 gtid : SV_GroupThreadID, uint gi : SV_GroupIndex)
+	{
+		bins[gi] = 0;
+		barrier();
+		float3 c = tex2Dfetch(Common::BackBuffer, int2(tid.xy)).rgb;
+		uint b = uint(saturate(dot(c, 1.0 / 3.0)) * 255.0);
+		atomicAdd(bins[b], 1u);
+		barrier();
+		Params p = make_params(1.0 / 65536.0);
+		tex2Dstore(HistStorage, int2(gi, 0), float4(bins[gi] * p.scale, 0, 0, 0));
+	}
+
+	void WriteCS(uint3 tid : SV_DispatchThreadID)
+	{
+		float4 v = float4(tid.xy / float2(BUFFER_WIDTH, BUFFER_HEIGHT), 0, 1);
+		for (int i = 0; i < 4; i++)
+		{
+			if (i == 2) continue;
+			v.z += 0.1 * i;
+			if (v.z > 1.0) break;
+		}
+		do { v.w *= 0.5; } while (v.w > 0.6);
+		v.x = v.x > 0.5 ? v.x : 1 - v.x;
+		tex2Dstore(OutStorage, tid.xy, v);
+	}
+}
+
+float4 ShowPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float4 c = tex2D(OutSampler, uv);
+	uint u = asuint(c.x) ^ 0xFFu;
+	int s = (int)u >> 2;
+	return float4(c.rgb, frac(float(s) * 0.001) + any(c.rgb > 0.5) + all(c.rgb < 0.1));
+}
+
+technique Histogram
+{
+	pass { ComputeShader = Compute::HistCS<256, 1>; DispatchSizeX = BUFFER_WIDTH / 16; DispatchSizeY = BUFFER_HEIGHT / 16; }
+	pass { ComputeShader = Compute::WriteCS<8, 8>; DispatchSizeX = BUFFER_WIDTH / 8; DispatchSizeY = BUFFER_HEIGHT / 8; }
+	pass { VertexShader = PostProcessVS; PixelShader = ShowPS; }
+}
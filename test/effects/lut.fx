@@ -0,0 +1,25 @@
+#include "common.fxh"
+#define LUT_SIZE 32
+#define K(i) (0.001 * (i) * (i))
+static const float kernel[25] = { K(0), K(1), K(2), K(3), K(4), K(5), K(6), K(7), K(8), K(9), K(10), K(11), K(12), K(13), K(14), K(15), K(16), K(17), K(18), K(19), K(20), K(21), K(22), K(23), K(24) };
+static const float3 pal[8] = { float3(0,0,0), float3(1,0,0), float3(0,1,0), float3(0,0,1), float3(1,1,0), float3(1,0,1), float3(0,1,1), float3(1,1,1) };
+static const int ints[6] = { 1, 2, 3, 4, 5, 6 };
+uniform float Strength < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.5;
+uniform float2 Offset = float2(0.5, -0.5);
+texture LutTex < source = "lut.png"; > { Width = LUT_SIZE * LUT_SIZE; Height = LUT_SIZE; };
+sampler LutSampler { Texture = LutTex; };
+
+float3 apply(float3 c)
+{
+	float3 s = 0;
+	[loop] for (int i = 0; i < 25; ++i) s += kernel[i] * pal[i % 8] * ints[i % 6];
+	return lerp(c, s + tex2D(LutSampler, c.xy).rgb, Strength);
+}
+float4 LutPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float4 c = tex2D(Common::BackBuffer, uv + Offset * 0.0);
+	c.rgb = apply(c.rgb);
+	c.rgb = c.rgb * 1.0 + 0.0;
+	return c;
+}
+technique LUT { pass { VertexShader = PostProcessVS; PixelShader = LutPS; } }
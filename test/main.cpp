@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include <cstdio>
+#include <cstdlib> // std::system
+#include <fstream>
+#include <iterator> // std::istreambuf_iterator
+
+static std::filesystem::path s_fxc_path;
+static unsigned int s_failure_count = 0;
+
+std::vector<reshade::test::test_case> &reshade::test::test_cases()
+{
+	// Function local static, so that it is initialized before the first test case is registered from another translation unit
+	static std::vector<test_case> test_cases;
+	return test_cases;
+}
+
+void reshade::test::report_failure(const char *file, int line, const char *expression)
+{
+	s_failure_count++;
+
+	printf("%s(%d): check failed: %s\n", file, line, expression);
+}
+
+const std::filesystem::path &reshade::test::fxc_path()
+{
+	return s_fxc_path;
+}
+int reshade::test::run_fxc(const std::string &args)
+{
+	return run_command('\"' + s_fxc_path.u8string() + "\" " + args);
+}
+int reshade::test::run_command(std::string command)
+{
+#ifdef _WIN32
+	// Wrap the entire command in another pair of quotes, since 'cmd.exe' strips the outer ones
+	command = '\"' + command + '\"';
+#endif
+	return std::system(command.c_str());
+}
+
+std::filesystem::path reshade::test::create_temp_directory(const char *name)
+{
+	std::error_code ec;
+	const std::filesystem::path path = std::filesystem::temp_directory_path(ec) / "reshade_test" / name;
+	std::filesystem::remove_all(path, ec);
+	std::filesystem::create_directories(path, ec);
+	return path;
+}
+
+bool reshade::test::read_file(const std::filesystem::path &path, std::string &data)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+bool reshade::test::write_file(const std::filesystem::path &path, const std::string &data)
+{
+	std::ofstream file(path, std::ios::binary);
+	return file && file.write(data.data(), data.size());
+}
+
+static void print_usage(const char *path)
+{
+	printf(R"(usage: %s [options] [<filter>]
+
+Options:
+  -h, --help                Print this help.
+
+  --bench                   Run benchmarks instead of tests.
+  --fxc <path>              Path to the FXC executable used by tests of the command-line compiler. Defaults to the one next to this executable.
+
+Only tests (or benchmarks) whose name contains <filter> are run, if specified.
+	)", path);
+}
+
+int main(int argc, char *argv[])
+{
+	bool benchmark = false;
+	std::string filter;
+
+#ifdef _WIN32
+	s_fxc_path = std::filesystem::u8path(argv[0]).parent_path() / L"fxc.exe";
+#else
+	s_fxc_path = std::filesystem::u8path(argv[0]).parent_path() / "fxc";
+#endif
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "-h" || arg == "--help")
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+
+		if (arg == "--bench")
+			benchmark = true;
+		else if (arg == "--fxc" && i + 1 < argc)
+			s_fxc_path = std::filesystem::u8path(argv[++i]);
+		else
+			filter = arg;
+	}
+
+	unsigned int num_failed = 0, num_run = 0;
+
+	for (const reshade::test::test_case &test_case : reshade::test::test_cases())
+	{
+		if (test_case.benchmark != benchmark || std::string(test_case.name).find(filter) == std::string::npos)
+			continue;
+
+		printf("%s\n", test_case.name);
+		fflush(stdout);
+
+		const unsigned int failure_count_before = s_failure_count;
+		test_case.func();
+
+		num_run++;
+		if (s_failure_count != failure_count_before)
+			num_failed++;
+	}
+
+	printf("%u of %u %s failed\n", num_failed, num_run, benchmark ? "benchmarks" : "tests");
+
+	return num_failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <reshade_api_device.hpp>
+#include <cstring> // std::memcpy
+#include <vector>
+#include <unordered_map>
+
+namespace reshade::test
+{
+	/// <summary>
+	/// A write to a buffer through <see cref="api::device::map_buffer_region"/> or <see cref="api::device::update_buffer_region"/>.
+	/// </summary>
+	struct buffer_write
+	{
+		api::resource resource;
+		uint64_t offset;
+		uint64_t size;
+		api::map_access access;
+	};
+
+	/// <summary>
+	/// A single resource transition recorded through <see cref="api::command_list::barrier"/>.
+	/// </summary>
+	struct resource_barrier
+	{
+		api::resource resource;
+		api::resource_usage old_state;
+		api::resource_usage new_state;
+	};
+
+	/// <summary>
+	/// A device that does not talk to any graphics API, but records all writes to buffers instead.
+	/// Mapping a buffer returns a pointer into a copy of its contents in host memory.
+	/// </summary>
+	class recording_device : public api::device
+	{
+	public:
+		std::vector<buffer_write> buffer_writes;
+		std::unordered_map<uint64_t, std::vector<uint8_t>> buffer_contents;
+
+		uint64_t get_native() const override { return {}; }
+		void get_private_data(const uint8_t guid[16], uint64_t *data) const override {}
+		void set_private_data(const uint8_t guid[16], const uint64_t data) override {}
+		api::device_api get_api() const override { return {}; }
+		bool check_capability(api::device_caps capability) const override { return false; }
+		bool check_format_support(api::format format, api::resource_usage usage) const override { return false; }
+		bool create_sampler(const api::sampler_desc &desc, api::sampler *out_sampler) override { return false; }
+		void destroy_sampler(api::sampler sampler) override {}
+		bool create_resource(const api::resource_desc &desc, const api::subresource_data *initial_data, api::resource_usage initial_state, api::resource *out_resource, void **shared_handle) override { return false; }
+		void destroy_resource(api::resource resource) override {}
+		api::resource_desc get_resource_desc(api::resource resource) const override { return {}; }
+		bool create_resource_view(api::resource resource, api::resource_usage usage_type, const api::resource_view_desc &desc, api::resource_view *out_view) override { return false; }
+		void destroy_resource_view(api::resource_view view) override {}
+		api::resource get_resource_from_view(api::resource_view view) const override { return {}; }
+		api::resource_view_desc get_resource_view_desc(api::resource_view view) const override { return {}; }
+		bool map_buffer_region(api::resource resource, uint64_t offset, uint64_t size, api::map_access access, void **out_data) override
+		{
+			buffer_writes.push_back({ resource, offset, size, access });
+			std::vector<uint8_t> &contents = buffer_contents[resource.handle];
+			if (contents.size() < offset + size)
+				contents.resize(static_cast<size_t>(offset + size));
+			*out_data = contents.data() + offset;
+			return true;
+		}
+		void unmap_buffer_region(api::resource resource) override {}
+		bool map_texture_region(api::resource resource, uint32_t subresource, const api::subresource_box *box, api::map_access access, api::subresource_data *out_data) override { return false; }
+		void unmap_texture_region(api::resource resource, uint32_t subresource) override {}
+		void update_buffer_region(const void *data, api::resource resource, uint64_t offset, uint64_t size) override
+		{
+			buffer_writes.push_back({ resource, offset, size, api::map_access::write_only });
+			std::vector<uint8_t> &contents = buffer_contents[resource.handle];
+			if (contents.size() < offset + size)
+				contents.resize(static_cast<size_t>(offset + size));
+			std::memcpy(contents.data() + offset, data, static_cast<size_t>(size));
+		}
+		void update_texture_region(const api::subresource_data &data, api::resource resource, uint32_t subresource, const api::subresource_box *box) override {}
+		bool create_pipeline(api::pipeline_layout layout, uint32_t subobject_count, const api::pipeline_subobject *subobjects, api::pipeline *out_pipeline) override { return false; }
+		void destroy_pipeline(api::pipeline pipeline) override {}
+		bool create_pipeline_layout(uint32_t param_count, const api::pipeline_layout_param *params, api::pipeline_layout *out_layout) override { return false; }
+		void destroy_pipeline_layout(api::pipeline_layout layout) override {}
+		bool allocate_descriptor_tables(uint32_t count, api::pipeline_layout layout, uint32_t param, api::descriptor_table *out_tables) override { return false; }
+		void free_descriptor_tables(uint32_t count, const api::descriptor_table *tables) override {}
+		void get_descriptor_heap_offset(api::descriptor_table table, uint32_t binding, uint32_t array_offset, api::descriptor_heap *out_heap, uint32_t *out_offset) const override {}
+		void copy_descriptor_tables(uint32_t count, const api::descriptor_table_copy *copies) override {}
+		void update_descriptor_tables(uint32_t count, const api::descriptor_table_update *updates) override {}
+		bool create_query_heap(api::query_type type, uint32_t count, api::query_heap *out_heap) override { return false; }
+		void destroy_query_heap(api::query_heap heap) override {}
+		bool get_query_heap_results(api::query_heap heap, uint32_t first, uint32_t count, void *results, uint32_t stride) override { return false; }
+		void set_resource_name(api::resource resource, const char *name) override {}
+		void set_resource_view_name(api::resource_view view, const char *name) override {}
+		bool create_fence(uint64_t initial_value, api::fence_flags flags, api::fence *out_fence, void **shared_handle) override { return false; }
+		void destroy_fence(api::fence fence) override {}
+		uint64_t get_completed_fence_value(api::fence fence) const override { return {}; }
+		bool wait(api::fence fence, uint64_t value, uint64_t timeout) override { return false; }
+		bool signal(api::fence fence, uint64_t value) override { return false; }
+		bool get_property(api::device_properties property, void *data) const override { return false; }
+		uint64_t get_resource_view_gpu_address(api::resource_view view) const override { return {}; }
+		void get_acceleration_structure_size(api::acceleration_structure_type type, api::acceleration_structure_build_flags flags, uint32_t input_count, const api::acceleration_structure_build_input *inputs, uint64_t *out_size, uint64_t *out_build_scratch_size, uint64_t *out_update_scratch_size) const override {}
+		bool get_pipeline_shader_group_handles(api::pipeline pipeline, uint32_t first, uint32_t count, void *out_handles) override { return false; }
+	};
+
+	/// <summary>
+	/// A command list that does not record any commands, except for resource barriers and the bytes of push constants that were set.
+	/// </summary>
+	class recording_command_list : public api::command_list
+	{
+	public:
+		explicit recording_command_list(recording_device *device) : _device(device) {}
+
+		std::vector<resource_barrier> barriers;
+		uint64_t push_constant_bytes = 0;
+
+		uint64_t get_native() const override { return {}; }
+		void get_private_data(const uint8_t guid[16], uint64_t *data) const override {}
+		void set_private_data(const uint8_t guid[16], const uint64_t data) override {}
+		api::device *get_device() override { return _device; }
+		void barrier(uint32_t count, const api::resource *resources, const api::resource_usage *old_states, const api::resource_usage *new_states) override
+		{
+			for (uint32_t i = 0; i < count; ++i)
+				barriers.push_back({ resources[i], old_states[i], new_states[i] });
+		}
+		void begin_render_pass(uint32_t count, const api::render_pass_render_target_desc *rts, const api::render_pass_depth_stencil_desc *ds) override {}
+		void end_render_pass() override {}
+		void bind_render_targets_and_depth_stencil(uint32_t count, const api::resource_view *rtvs, api::resource_view dsv) override {}
+		void bind_pipeline(api::pipeline_stage stages, api::pipeline pipeline) override {}
+		void bind_pipeline_states(uint32_t count, const api::dynamic_state *states, const uint32_t *values) override {}
+		void bind_viewports(uint32_t first, uint32_t count, const api::viewport *viewports) override {}
+		void bind_scissor_rects(uint32_t first, uint32_t count, const api::rect *rects) override {}
+		void push_constants(api::shader_stage stages, api::pipeline_layout layout, uint32_t param, uint32_t first, uint32_t count, const void *values) override
+		{
+			push_constant_bytes += count * 4;
+		}
+		void push_descriptors(api::shader_stage stages, api::pipeline_layout layout, uint32_t param, const api::descriptor_table_update &update) override {}
+		void bind_descriptor_tables(api::shader_stage stages, api::pipeline_layout layout, uint32_t first, uint32_t count, const api::descriptor_table *tables) override {}
+		void bind_index_buffer(api::resource buffer, uint64_t offset, uint32_t index_size) override {}
+		void bind_vertex_buffers(uint32_t first, uint32_t count, const api::resource *buffers, const uint64_t *offsets, const uint32_t *strides) override {}
+		void bind_stream_output_buffers(uint32_t first, uint32_t count, const api::resource *buffers, const uint64_t *offsets, const uint64_t *max_sizes, const api::resource *counter_buffers, const uint64_t *counter_offsets) override {}
+		void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override {}
+		void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance) override {}
+		void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override {}
+		void draw_or_dispatch_indirect(api::indirect_command type, api::resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) override {}
+		void copy_resource(api::resource source, api::resource dest) override {}
+		void copy_buffer_region(api::resource source, uint64_t source_offset, api::resource dest, uint64_t dest_offset, uint64_t size) override {}
+		void copy_buffer_to_texture(api::resource source, uint64_t source_offset, uint32_t row_length, uint32_t slice_height, api::resource dest, uint32_t dest_subresource, const api::subresource_box *dest_box) override {}
+		void copy_texture_region(api::resource source, uint32_t source_subresource, const api::subresource_box *source_box, api::resource dest, uint32_t dest_subresource, const api::subresource_box *dest_box, api::filter_mode filter) override {}
+		void copy_texture_to_buffer(api::resource source, uint32_t source_subresource, const api::subresource_box *source_box, api::resource dest, uint64_t dest_offset, uint32_t row_length, uint32_t slice_height) override {}
+		void resolve_texture_region(api::resource source, uint32_t source_subresource, const api::subresource_box *source_box, api::resource dest, uint32_t dest_subresource, uint32_t dest_x, uint32_t dest_y, uint32_t dest_z, api::format format) override {}
+		void clear_depth_stencil_view(api::resource_view dsv, const float *depth, const uint8_t *stencil, uint32_t rect_count, const api::rect *rects) override {}
+		void clear_render_target_view(api::resource_view rtv, const float color[4], uint32_t rect_count, const api::rect *rects) override {}
+		void clear_unordered_access_view_uint(api::resource_view uav, const uint32_t values[4], uint32_t rect_count, const api::rect *rects) override {}
+		void clear_unordered_access_view_float(api::resource_view uav, const float values[4], uint32_t rect_count, const api::rect *rects) override {}
+		void generate_mipmaps(api::resource_view srv) override {}
+		void begin_query(api::query_heap heap, api::query_type type, uint32_t index) override {}
+		void end_query(api::query_heap heap, api::query_type type, uint32_t index) override {}
+		void copy_query_heap_results(api::query_heap heap, api::query_type type, uint32_t first, uint32_t count, api::resource dest, uint64_t dest_offset, uint32_t stride) override {}
+		void begin_debug_event(const char *label, const float color[4]) override {}
+		void end_debug_event() override {}
+		void insert_debug_marker(const char *label, const float color[4]) override {}
+		void dispatch_mesh(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override {}
+		void dispatch_rays(api::resource raygen, uint64_t raygen_offset, uint64_t raygen_size, api::resource miss, uint64_t miss_offset, uint64_t miss_size, uint64_t miss_stride, api::resource hit_group, uint64_t hit_group_offset, uint64_t hit_group_size, uint64_t hit_group_stride, api::resource callable, uint64_t callable_offset, uint64_t callable_size, uint64_t callable_stride, uint32_t width, uint32_t height, uint32_t depth) override {}
+		void copy_acceleration_structure(api::resource_view source, api::resource_view dest, api::acceleration_structure_copy_mode mode) override {}
+		void build_acceleration_structure(api::acceleration_structure_type type, api::acceleration_structure_build_flags flags, uint32_t input_count, const api::acceleration_structure_build_input *inputs, api::resource scratch, uint64_t scratch_offset, api::resource_view source, api::resource_view dest, api::acceleration_structure_build_mode mode) override {}
+		void query_acceleration_structures(uint32_t count, const api::resource_view *acceleration_structures, api::query_heap heap, api::query_type type, uint32_t first) override {}
+
+	private:
+		recording_device *const _device;
+	};
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+
+namespace reshade::test
+{
+	/// <summary>
+	/// A single test or benchmark, registered through the <see cref="TEST_CASE"/> and <see cref="BENCHMARK"/> macros.
+	/// </summary>
+	struct test_case
+	{
+		const char *name;
+		void(*func)();
+		bool benchmark;
+	};
+
+	/// <summary>
+	/// Gets the list of all registered tests and benchmarks.
+	/// </summary>
+	std::vector<test_case> &test_cases();
+
+	struct test_case_registrar
+	{
+		test_case_registrar(const char *name, void(*func)(), bool benchmark) { test_cases().push_back({ name, func, benchmark }); }
+	};
+
+	/// <summary>
+	/// Records a failed check of the test that is currently running.
+	/// </summary>
+	void report_failure(const char *file, int line, const char *expression);
+
+	/// <summary>
+	/// Gets the path to the FXC executable, which is expected next to the test executable unless specified with '--fxc' on the command-line.
+	/// </summary>
+	const std::filesystem::path &fxc_path();
+	/// <summary>
+	/// Runs FXC with the specified arguments and returns its exit code.
+	/// </summary>
+	int run_fxc(const std::string &args);
+	/// <summary>
+	/// Runs the specified shell command and returns its exit code.
+	/// </summary>
+	int run_command(std::string command);
+
+	/// <summary>
+	/// Creates an empty directory in the temporary directory for the specified test to write its files to.
+	/// </summary>
+	std::filesystem::path create_temp_directory(const char *name);
+
+	bool read_file(const std::filesystem::path &path, std::string &data);
+	bool write_file(const std::filesystem::path &path, const std::string &data);
+
+	/// <summary>
+	/// Calls the specified function repeatedly and returns the average duration of a single call in milliseconds.
+	/// </summary>
+	template <typename F>
+	double measure(size_t iterations, F &&func)
+	{
+		const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			func();
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+	}
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const reshade::test::test_case_registrar name##_registrar(#name, &name, false); \
+	static void name()
+#define BENCHMARK(name) \
+	static void name(); \
+	static const reshade::test::test_case_registrar name##_registrar(#name, &name, true); \
+	static void name()
+
+#define CHECK(expression) \
+	((expression) ? (void)0 : reshade::test::report_failure(__FILE__, __LINE__, #expression))
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "recording_device.hpp"
+#include <reshade_api_device.hpp>
+#include <unordered_map>
+#include "runtime_internal.hpp"
+
+using reshade::api::resource_usage;
+
+static const resource_usage rt = resource_usage::render_target;
+static const resource_usage uav = resource_usage::unordered_access;
+static const resource_usage srv = resource_usage::shader_resource;
+
+/// <summary>
+/// Creates a pixel shader pass (or compute shader pass) that writes to the specified resources.
+/// </summary>
+static reshade::technique::pass create_pass(bool compute, std::initializer_list<uint64_t> modified_resources, bool generate_mipmaps = false)
+{
+	reshade::technique::pass pass = reshadefx::pass {};
+	if (compute)
+	{
+		pass.cs_entry_point = "CS";
+	}
+	else
+	{
+		pass.vs_entry_point = "VS";
+		pass.ps_entry_point = "PS";
+	}
+
+	for (const uint64_t resource : modified_resources)
+	{
+		pass.modified_resources.push_back({ resource });
+		if (generate_mipmaps)
+			pass.generate_mipmap_views.push_back({ resource });
+	}
+
+	return pass;
+}
+
+/// <summary>
+/// Plans the barriers of a technique with the specified passes and records them the same way the runtime issues them when rendering the technique.
+/// </summary>
+static std::vector<std::vector<reshade::test::resource_barrier>> record_technique(std::vector<reshade::technique::pass> &passes, bool render_target_write_dependencies)
+{
+	reshade::technique::plan_barriers(passes, render_target_write_dependencies);
+
+	reshade::test::recording_device device;
+	reshade::test::recording_command_list cmd_list(&device);
+
+	// Every resource written by a technique starts out and has to end up in shader resource state, with every barrier starting from the state the previous one left it in
+	std::unordered_map<uint64_t, resource_usage> states;
+
+	std::vector<std::vector<reshade::test::resource_barrier>> recorded;
+	for (const reshade::technique::pass &pass : passes)
+	{
+		for (const reshade::technique::barrier_list *const barriers : { &pass.barriers_before, &pass.barriers_after })
+		{
+			cmd_list.barriers.clear();
+			cmd_list.barrier(static_cast<uint32_t>(barriers->resources.size()), barriers->resources.data(), barriers->old_states.data(), barriers->new_states.data());
+
+			for (const reshade::test::resource_barrier &barrier : cmd_list.barriers)
+			{
+				const auto it = states.emplace(barrier.resource.handle, srv).first;
+				CHECK(it->second == barrier.old_state);
+				it->second = barrier.new_state;
+			}
+
+			recorded.push_back(cmd_list.barriers);
+		}
+	}
+
+	for (const std::pair<const uint64_t, resource_usage> &state : states)
+		CHECK(state.second == srv);
+
+	return recorded;
+}
+
+namespace reshade::test
+{
+	static bool operator==(const resource_barrier &lhs, const resource_barrier &rhs)
+	{
+		return lhs.resource == rhs.resource && lhs.old_state == rhs.old_state && lhs.new_state == rhs.new_state;
+	}
+}
+
+using barrier_sequence = std::vector<reshade::test::resource_barrier>;
+
+TEST_CASE(barriers_consecutive_render_target_writes)
+{
+	std::vector<reshade::technique::pass> passes = { create_pass(false, { 1 }), create_pass(false, { 1 }), create_pass(false, { 1 }) };
+
+	// Render target writes are ordered implicitly, so the resource stays in render target state without any barriers in between
+	auto recorded = record_technique(passes, false);
+	CHECK(recorded.size() == 6);
+	CHECK(recorded[0] == barrier_sequence({ { { 1 }, srv, rt } }));
+	CHECK(recorded[1].empty());
+	CHECK(recorded[2].empty());
+	CHECK(recorded[3].empty());
+	CHECK(recorded[4].empty());
+	CHECK(recorded[5] == barrier_sequence({ { { 1 }, rt, srv } }));
+
+	// Vulkan needs an execution dependency between the writes, but still no layout transition
+	recorded = record_technique(passes, true);
+	CHECK(recorded.size() == 6);
+	CHECK(recorded[0] == barrier_sequence({ { { 1 }, srv, rt } }));
+	CHECK(recorded[1].empty());
+	CHECK(recorded[2] == barrier_sequence({ { { 1 }, rt, rt } }));
+	CHECK(recorded[3].empty());
+	CHECK(recorded[4] == barrier_sequence({ { { 1 }, rt, rt } }));
+	CHECK(recorded[5] == barrier_sequence({ { { 1 }, rt, srv } }));
+}
+
+TEST_CASE(barriers_consecutive_storage_writes)
+{
+	std::vector<reshade::technique::pass> passes = { create_pass(true, { 1 }), create_pass(true, { 1 }) };
+
+	// Storage writes always need to be ordered (with a UAV barrier), independent of the graphics API
+	for (const bool render_target_write_dependencies : { false, true })
+	{
+		const auto recorded = record_technique(passes, render_target_write_dependencies);
+		CHECK(recorded.size() == 4);
+		CHECK(recorded[0] == barrier_sequence({ { { 1 }, srv, uav } }));
+		CHECK(recorded[1].empty());
+		CHECK(recorded[2] == barrier_sequence({ { { 1 }, uav, uav } }));
+		CHECK(recorded[3] == barrier_sequence({ { { 1 }, uav, srv } }));
+	}
+}
+
+TEST_CASE(barriers_mipmap_generation)
+{
+	// Mipmaps are generated from shader resource state after the first pass, so the second pass has to transition the resource again
+	std::vector<reshade::technique::pass> passes = { create_pass(false, { 1 }, true), create_pass(false, { 1 }) };
+
+	const auto recorded = record_technique(passes, false);
+	CHECK(recorded.size() == 4);
+	CHECK(recorded[0] == barrier_sequence({ { { 1 }, srv, rt } }));
+	CHECK(recorded[1] == barrier_sequence({ { { 1 }, rt, srv } }));
+	CHECK(recorded[2] == barrier_sequence({ { { 1 }, srv, rt } }));
+	CHECK(recorded[3] == barrier_sequence({ { { 1 }, rt, srv } }));
+}
+
+TEST_CASE(barriers_mixed_graphics_and_compute)
+{
+	std::vector<reshade::technique::pass> passes = { create_pass(false, { 1, 2 }), create_pass(true, { 1 }), create_pass(true, { 1, 2 }), create_pass(false, { 2 }) };
+
+	for (const bool render_target_write_dependencies : { false, true })
+	{
+		const auto recorded = record_technique(passes, render_target_write_dependencies);
+		CHECK(recorded.size() == 8);
+		CHECK(recorded[0] == barrier_sequence({ { { 1 }, srv, rt }, { { 2 }, srv, rt } }));
+		// Switching between render target and storage writes goes through shader resource state
+		CHECK(recorded[1] == barrier_sequence({ { { 1 }, rt, srv }, { { 2 }, rt, srv } }));
+		CHECK(recorded[2] == barrier_sequence({ { { 1 }, srv, uav } }));
+		CHECK(recorded[3].empty());
+		CHECK(recorded[4] == barrier_sequence({ { { 1 }, uav, uav }, { { 2 }, srv, uav } }));
+		CHECK(recorded[5] == barrier_sequence({ { { 1 }, uav, srv }, { { 2 }, uav, srv } }));
+		CHECK(recorded[6] == barrier_sequence({ { { 2 }, srv, rt } }));
+		CHECK(recorded[7] == barrier_sequence({ { { 2 }, rt, srv } }));
+	}
+}
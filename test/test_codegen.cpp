@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <cstdio>
+#include <cmath> // std::exp
+#include <cstring> // std::memcpy, std::strncmp
+#include <algorithm> // std::any_of, std::find, std::none_of
+#include <spirv.hpp>
+
+/// <summary>
+/// Generates an effect with a color lookup table and the specified number of Gaussian blur kernels of different widths, each with its own array of weights and offsets, which are all used in a pixel shader.
+/// </summary>
+static std::string generate_constant_heavy_effect(size_t num_kernels, size_t kernel_size)
+{
+	std::string source = "static const float3 LUT[256] = {\n";
+	for (size_t i = 0; i < 256; ++i)
+		source += "\tfloat3(" + std::to_string(i / 255.0f) + ", " + std::to_string((255 - i) / 255.0f) + ", " + std::to_string((i % 16) / 15.0f) + "),\n";
+	source += "};\n";
+
+	for (size_t k = 0; k < num_kernels; ++k)
+	{
+		const std::string index = std::to_string(k);
+		const float sigma = 2.0f + k * 0.25f;
+
+		source += "static const float Weights" + index + "[" + std::to_string(kernel_size) + "] = { ";
+		for (size_t i = 0; i < kernel_size; ++i)
+			source += std::to_string(std::exp(-0.5f * (i / sigma) * (i / sigma)) / sigma) + ", ";
+		source += "};\n";
+
+		source += "static const float2 Offsets" + index + "[" + std::to_string(kernel_size) + "] = { ";
+		for (size_t i = 0; i < kernel_size; ++i)
+			source += "float2(" + std::to_string(i * sigma) + ", " + std::to_string((i % 4) * sigma) + "), ";
+		source += "};\n";
+	}
+
+	source += "texture2D tex; sampler2D samp { Texture = tex; };\n";
+	source += "float4 PS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\n\tfloat3 color = 0.0;\n";
+	for (size_t k = 0; k < num_kernels; ++k)
+	{
+		const std::string index = std::to_string(k);
+
+		source += "\tfor (int i" + index + " = 0; i" + index + " < " + std::to_string(kernel_size) + "; ++i" + index + ")\n";
+		source += "\t\tcolor += tex2D(samp, uv + Offsets" + index + "[i" + index + "] * 0.001).rgb * Weights" + index + "[i" + index + "] * " + std::to_string(k % 8 + 1) + ".0;\n";
+	}
+	source += "\treturn float4(LUT[int(saturate(color.r) * 255.0)], 1.0);\n}\n";
+
+	source += "void VS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD) { texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0); position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0); }\n";
+	source += "technique T { pass { VertexShader = VS; PixelShader = PS; } }\n";
+
+	return source;
+}
+
+/// <summary>
+/// Parses the specified effect with the specified back-end and generates the final code for its module.
+/// </summary>
+static bool compile_effect(const std::string &source, reshadefx::codegen *codegen)
+{
+	reshadefx::parser parser;
+	if (!parser.parse(source, codegen))
+		return false;
+
+	return !codegen->finalize_code().empty();
+}
+
+static const char s_dead_code_effect[] = R"(
+texture2D tex; sampler2D samp { Texture = tex; };
+groupshared uint counter;
+
+float Unused(float x) { return x * 2.0; }
+float Helper(float x, out float y) { y = x + 1.0; return x; }
+
+void VS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD) { texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0); position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0); }
+float4 PS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float4 unused_sample = tex2D(samp, uv * 3.0);
+	float3 unused_color = unused_sample.rgb * 2.0 + uv.x;
+	float unused_output;
+	Helper(uv.y, unused_output);
+	float4 color = tex2D(samp, uv);
+	for (int i = 0; i < 4; ++i) { float unused_in_loop = color.x * i; color.y += 1.0; }
+	return color;
+}
+void CS(uint3 id : SV_DispatchThreadID)
+{
+	uint unused_previous = atomicAdd(counter, 1u);
+}
+
+technique T { pass { VertexShader = VS; PixelShader = PS; } pass { ComputeShader = CS<8, 8>; DispatchSizeX = 1; DispatchSizeY = 1; } }
+)";
+
+TEST_CASE(codegen_text_optimization_removes_unused_code)
+{
+	for (const bool glsl : { true, false })
+	{
+		const std::unique_ptr<reshadefx::codegen> codegen(glsl ? reshadefx::create_codegen_glsl(false, false, false) : reshadefx::create_codegen_hlsl(50, false, false));
+
+		reshadefx::parser parser;
+		CHECK(parser.parse(s_dead_code_effect, codegen.get()));
+
+		const std::string unoptimized_code = codegen->finalize_code();
+		CHECK(unoptimized_code.find("Unused") != std::string::npos);
+		CHECK(unoptimized_code.find("unused_sample") != std::string::npos);
+
+		codegen->optimize_code();
+		const std::string code = codegen->finalize_code();
+
+		// Functions not called by any entry point and local variables that are never read are removed, including those that only fed into other removed variables
+		CHECK(code.find("Unused(") == std::string::npos);
+		CHECK(code.find("unused_sample") == std::string::npos);
+		CHECK(code.find("unused_color") == std::string::npos);
+		CHECK(code.find("unused_in_loop") == std::string::npos);
+		CHECK(code.find(glsl ? "texture(" : ".Sample(") == code.rfind(glsl ? "texture(" : ".Sample("));
+
+		// Calls to functions and atomic operations are kept, even if their result is unused, since they may have side effects
+		CHECK(code.find("Helper(") != std::string::npos && code.find("Helper(") != code.rfind("Helper("));
+		CHECK(code.find(glsl ? "atomicAdd(" : "InterlockedAdd(") != std::string::npos);
+		// Loop that still modifies a variable that is read afterwards is kept
+		CHECK(code.find("while (") != std::string::npos);
+
+		CHECK(code.size() < unoptimized_code.size());
+
+		// Code for individual entry points is based on the optimized functions as well
+		for (const std::string &entry_point_code : codegen->finalize_code_for_entry_points())
+			CHECK(!entry_point_code.empty() && entry_point_code.find("unused_sample") == std::string::npos);
+	}
+}
+
+/// <summary>
+/// Splits SPIR-V code into its instructions, each being the list of words of the instruction with the word count removed from the opcode.
+/// </summary>
+static std::vector<std::vector<uint32_t>> split_spirv_instructions(const std::string &code)
+{
+	std::vector<std::vector<uint32_t>> instructions;
+	if (code.size() < 20 || code.size() % 4 != 0)
+		return instructions;
+
+	std::vector<uint32_t> words(code.size() / 4);
+	std::memcpy(words.data(), code.data(), code.size());
+
+	// Skip the header (magic number, version, generator, bound and schema)
+	for (size_t i = 5, word_count; i < words.size(); i += word_count)
+	{
+		word_count = words[i] >> spv::WordCountShift;
+		if (word_count == 0 || i + word_count > words.size())
+			return {};
+
+		std::vector<uint32_t> &inst = instructions.emplace_back(words.begin() + i, words.begin() + i + word_count);
+		inst[0] &= spv::OpCodeMask;
+	}
+
+	return instructions;
+}
+
+/// <summary>
+/// Gets the instructions from 'OpFunction' to 'OpFunctionEnd' of the function with the specified debug name.
+/// The generated entry point function that wraps a shader function has the same name, so it is excluded.
+/// </summary>
+static std::vector<std::vector<uint32_t>> find_spirv_function(const std::vector<std::vector<uint32_t>> &instructions, const std::string &name)
+{
+	std::vector<uint32_t> entry_point_ids;
+	for (const std::vector<uint32_t> &inst : instructions)
+		if (inst[0] == spv::OpEntryPoint)
+			entry_point_ids.push_back(inst[2]);
+
+	uint32_t function_id = 0;
+	for (const std::vector<uint32_t> &inst : instructions)
+		if (inst[0] == spv::OpName && inst.size() > 2 && std::strncmp(reinterpret_cast<const char *>(inst.data() + 2), name.c_str(), (inst.size() - 2) * 4) == 0 &&
+			std::find(entry_point_ids.begin(), entry_point_ids.end(), inst[1]) == entry_point_ids.end())
+			function_id = inst[1];
+
+	std::vector<std::vector<uint32_t>> function_instructions;
+	for (const std::vector<uint32_t> &inst : instructions)
+	{
+		if (inst[0] == spv::OpFunction && inst[2] == function_id)
+			function_instructions.push_back(inst);
+		else if (!function_instructions.empty() && function_instructions.back()[0] != spv::OpFunctionEnd)
+			function_instructions.push_back(inst);
+	}
+
+	return function_instructions;
+}
+
+static const char s_spirv_optimization_effect[] = R"(
+void Add(inout float value) { value += 5.0; }
+
+void VS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD) { texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0); position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0); }
+float4 PS_EntryBlock(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float x = uv.x * 2.0;
+	float y = x + 1.0;
+	return float4(x, y, x, y);
+}
+float4 PS_Loop(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float sum = 0.0;
+	for (int i = 0; i < 4; ++i)
+		sum += uv.x;
+	return sum;
+}
+float4 PS_OutParameter(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float x = 1.0;
+	Add(x);
+	return x;
+}
+float4 PS_DivideByZero(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	int zero = 0;
+	int seven = 7;
+	uint zero_unsigned = 0u;
+	uint seven_unsigned = 7u;
+	return float4(seven / zero, seven % zero, seven_unsigned / zero_unsigned, seven_unsigned % zero_unsigned);
+}
+
+technique T
+{
+	pass { VertexShader = VS; PixelShader = PS_EntryBlock; }
+	pass { VertexShader = VS; PixelShader = PS_Loop; }
+	pass { VertexShader = VS; PixelShader = PS_OutParameter; }
+	pass { VertexShader = VS; PixelShader = PS_DivideByZero; }
+}
+)";
+
+TEST_CASE(codegen_spirv_optimization_preserves_semantics)
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_spirv(true, true, false));
+
+	reshadefx::parser parser;
+	CHECK(parser.parse(s_spirv_optimization_effect, codegen.get()));
+
+	codegen->optimize_code();
+
+	// Check the code generated for each entry point, since that is what the runtime uses, and it only contains the functions referenced by that entry point
+	const std::vector<std::string> entry_point_code = codegen->finalize_code_for_entry_points();
+	CHECK(entry_point_code.size() == codegen->module().entry_points.size());
+
+	for (size_t i = 0; i < entry_point_code.size() && i < codegen->module().entry_points.size(); ++i)
+	{
+		const std::string &entry_point_name = codegen->module().entry_points[i].first;
+		const std::vector<std::vector<uint32_t>> instructions = split_spirv_instructions(entry_point_code[i]);
+		CHECK(!instructions.empty() && *reinterpret_cast<const uint32_t *>(entry_point_code[i].data()) == spv::MagicNumber);
+
+		if (entry_point_name.find("VS") != std::string::npos)
+			continue;
+
+		const std::string function_name = entry_point_name.substr(entry_point_name.find("PS_"));
+		const std::vector<std::vector<uint32_t>> function = find_spirv_function(instructions, function_name);
+		CHECK(!function.empty());
+
+		// Unrelated functions are stripped from the code of an entry point
+		CHECK(find_spirv_function(instructions, "Add").empty() == (function_name != "PS_OutParameter"));
+
+		std::vector<uint32_t> loaded_pointers;
+		for (const std::vector<uint32_t> &inst : function)
+			if (inst[0] == spv::OpLoad)
+				loaded_pointers.push_back(inst[3]);
+
+		if (function_name == "PS_EntryBlock")
+		{
+			// Variables assigned once in the entry block are forwarded to their loads and removed, together with the stores to them
+			CHECK(std::none_of(function.begin(), function.end(), [](const std::vector<uint32_t> &inst) { return inst[0] == spv::OpVariable || inst[0] == spv::OpStore; }));
+		}
+		else if (function_name == "PS_Loop")
+		{
+			// Variables stored to outside the entry block (like in the loop body) have to keep being loaded, since the value depends on the path taken
+			size_t num_labels = 0, num_stores_outside_entry_block = 0;
+			for (const std::vector<uint32_t> &inst : function)
+			{
+				if (inst[0] == spv::OpLabel)
+					num_labels++;
+				else if (inst[0] == spv::OpStore && num_labels > 1)
+				{
+					num_stores_outside_entry_block++;
+					CHECK(std::find(loaded_pointers.begin(), loaded_pointers.end(), inst[1]) != loaded_pointers.end());
+				}
+			}
+			CHECK(num_stores_outside_entry_block != 0);
+		}
+		else if (function_name == "PS_OutParameter")
+		{
+			// Pointers passed to a function escape, so the value written through them has to be loaded after the call, instead of forwarding the value stored before the call
+			size_t num_pointer_arguments = 0;
+			for (auto it = function.begin(); it != function.end(); ++it)
+			{
+				if ((*it)[0] != spv::OpFunctionCall)
+					continue;
+
+				for (size_t k = 4; k < it->size(); ++k, ++num_pointer_arguments)
+					CHECK(std::any_of(it + 1, function.end(), [pointer = (*it)[k]](const std::vector<uint32_t> &inst) { return inst[0] == spv::OpLoad && inst[3] == pointer; }));
+			}
+			CHECK(num_pointer_arguments == 1);
+		}
+		else if (function_name == "PS_DivideByZero")
+		{
+			// Integer division and modulo by zero is undefined, so even with constant operands these are not folded
+			for (const spv::Op op : { spv::OpSDiv, spv::OpSRem, spv::OpUDiv, spv::OpUMod })
+				CHECK(std::any_of(function.begin(), function.end(), [op](const std::vector<uint32_t> &inst) { return inst[0] == op; }));
+		}
+	}
+}
+
+BENCHMARK(codegen_constant_heavy_effect)
+{
+	const std::string source = generate_constant_heavy_effect(200, 64);
+
+	bool success = true;
+	const double spirv_duration = reshade::test::measure(5, [&]() {
+		const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_spirv(true, false, false));
+		success &= compile_effect(source, codegen.get());
+	});
+	const double hlsl_duration = reshade::test::measure(5, [&]() {
+		const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_hlsl(50, false, false));
+		success &= compile_effect(source, codegen.get());
+	});
+	const double glsl_duration = reshade::test::measure(5, [&]() {
+		const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_glsl(false, false, false));
+		success &= compile_effect(source, codegen.get());
+	});
+	CHECK(success);
+
+	printf("  %zu KiB: SPIR-V %.3f ms, HLSL %.3f ms, GLSL %.3f ms\n", source.size() / 1024, spirv_duration, hlsl_duration, glsl_duration);
+}
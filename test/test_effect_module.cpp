@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <cstring> // std::memcpy
+
+static const char s_test_effect[] = R"(
+texture2D ColorTex : COLOR;
+texture2D TargetTex < pooled = true; ui_label = "Target"; > { Width = 64; Height = 32; Format = RGBA16F; MipLevels = 2; };
+texture2D StorageTex { Width = 16; Height = 16; Format = R32F; };
+
+sampler2D ColorSampler { Texture = ColorTex; SRGBTexture = true; AddressU = MIRROR; AddressV = BORDER; MinFilter = POINT; MipLODBias = 2; };
+sampler2D TargetSampler { Texture = TargetTex; };
+storage2D StorageOut { Texture = StorageTex; };
+
+uniform float Strength < ui_type = "slider"; ui_min = 0.0; ui_max = 2.0; ui_items = "A\0B\0"; > = 1.25;
+uniform float3 Weights[3] = { float3(1, 2, 3), float3(4, 5, 6), float3(7, 8, 9) };
+uniform int Mode < source = "frametime"; >;
+
+void VS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0);
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+float4 PS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	return tex2D(ColorSampler, uv) * Strength + float4(Weights[Mode % 3], 0.0) + tex2D(TargetSampler, uv);
+}
+void CS(uint3 id : SV_DispatchThreadID)
+{
+	tex2Dstore(StorageOut, id.xy, Strength);
+}
+
+technique Test < ui_tooltip = "Tooltip"; enabled = true; >
+{
+	pass First
+	{
+		VertexShader = VS;
+		PixelShader = PS;
+		RenderTarget0 = TargetTex;
+		ClearRenderTargets = true;
+		GenerateMipMaps = false;
+		BlendEnable = true;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+		BlendOp = REVSUBTRACT;
+		SrcBlendAlpha = ONE;
+		DestBlendAlpha = ZERO;
+		BlendOpAlpha = MAX;
+		RenderTargetWriteMask = 7;
+		StencilEnable = true;
+		StencilReadMask = 0x0F;
+		StencilWriteMask = 0xF0;
+		StencilRef = 3;
+		StencilFunc = EQUAL;
+		StencilPass = INCR;
+		StencilFail = ZERO;
+		StencilZFail = INVERT;
+		PrimitiveTopology = TRIANGLESTRIP;
+		VertexCount = 4;
+	}
+	pass Second
+	{
+		ComputeShader = CS<8, 8>;
+		DispatchSizeX = 2;
+		DispatchSizeY = 2;
+	}
+	pass Third
+	{
+		VertexShader = VS;
+		PixelShader = PS;
+		SRGBWriteEnable = true;
+	}
+}
+)";
+
+/// <summary>
+/// Compiles the test effect and serializes the resulting module together with the code generated for it.
+/// </summary>
+static std::string serialize_test_effect(reshadefx::effect_module &module, std::string &generated_code, std::vector<std::string> &entry_point_code)
+{
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	CHECK(parser.parse(s_test_effect, codegen.get()));
+
+	module = codegen->module();
+	generated_code = codegen->finalize_code();
+	entry_point_code = codegen->finalize_code_for_entry_points();
+
+	return reshadefx::serialize_module(module, generated_code, entry_point_code);
+}
+
+/// <summary>
+/// Attempts to deserialize the specified data, which is expected to be invalid, and checks that the output arguments were not modified.
+/// </summary>
+static bool deserialize_leaves_outputs_untouched(const std::string_view data)
+{
+	reshadefx::effect_module module;
+	module.total_uniform_size = 1234;
+	module.entry_points.push_back({ "Sentinel", reshadefx::shader_type::pixel });
+	std::string generated_code = "sentinel";
+	std::vector<std::string> entry_point_code = { "sentinel" };
+
+	if (reshadefx::deserialize_module(data, module, generated_code, entry_point_code))
+		return false;
+
+	return
+		module.total_uniform_size == 1234 && module.textures.empty() && module.uniforms.empty() && module.techniques.empty() &&
+		module.entry_points.size() == 1 && module.entry_points[0].first == "Sentinel" &&
+		generated_code == "sentinel" &&
+		entry_point_code == std::vector<std::string>({ "sentinel" });
+}
+
+/// <summary>
+/// Overwrites the 32-bit value at the specified byte offset in serialized data.
+/// </summary>
+static std::string patch_uint(std::string data, size_t offset, uint32_t value)
+{
+	std::memcpy(data.data() + offset, &value, sizeof(value));
+	return data;
+}
+
+TEST_CASE(effect_module_round_trip)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	const std::string data = serialize_test_effect(module, generated_code, entry_point_code);
+
+	CHECK(reshadefx::is_serialized_module(data));
+	CHECK(!reshadefx::is_serialized_module(generated_code));
+
+	reshadefx::effect_module result;
+	std::string result_generated_code;
+	std::vector<std::string> result_entry_point_code;
+	CHECK(reshadefx::deserialize_module(data, result, result_generated_code, result_entry_point_code));
+
+	// Serializing the result again has to produce the exact same data, which covers every field that is written
+	CHECK(reshadefx::serialize_module(result, result_generated_code, result_entry_point_code) == data);
+	CHECK(result_generated_code == generated_code);
+	CHECK(result_entry_point_code == entry_point_code);
+
+	// Spot check that the test effect actually exercises the interesting parts of the format
+	CHECK(result.textures.size() == 3 && result.samplers.size() == 2 && result.storages.size() == 1);
+	CHECK(result.textures[0].semantic == "COLOR");
+	CHECK(result.textures[1].width == 64 && result.textures[1].height == 32 && result.textures[1].levels == 2 && result.textures[1].format == reshadefx::texture_format::rgba16f);
+	CHECK(result.textures[1].annotations.size() == 2 && result.textures[1].annotations[1].value.string_data == "Target");
+	CHECK(result.samplers[0].srgb && result.samplers[0].address_u == reshadefx::texture_address_mode::mirror && result.samplers[0].lod_bias == 2.0f);
+
+	CHECK(result.uniforms.size() == 3 && result.total_uniform_size == module.total_uniform_size);
+	CHECK(result.uniforms[0].has_initializer_value && result.uniforms[0].initializer_value.as_float[0] == 1.25f);
+	CHECK(result.uniforms[0].annotations.size() == 4 && result.uniforms[0].annotations[3].value.string_data == std::string("A\0B\0", 4));
+	CHECK(result.uniforms[1].type.array_length == 3 && result.uniforms[1].initializer_value.array_data.size() == 3 && result.uniforms[1].initializer_value.array_data[2].as_float[2] == 9.0f);
+
+	CHECK(result.techniques.size() == 1 && result.techniques[0].annotations.size() == 2 && result.techniques[0].passes.size() == 3);
+	const reshadefx::pass &first = result.techniques[0].passes[0];
+	CHECK(first.name == "First" && !first.vs_entry_point.empty() && !first.ps_entry_point.empty() && first.render_target_names[0] == result.textures[1].unique_name);
+	CHECK(first.clear_render_targets && !first.generate_mipmaps);
+	CHECK(first.blend_enable[0] && first.source_color_blend_factor[0] == reshadefx::blend_factor::source_alpha && first.dest_color_blend_factor[0] == reshadefx::blend_factor::one_minus_source_alpha && first.color_blend_op[0] == reshadefx::blend_op::reverse_subtract);
+	CHECK(first.alpha_blend_op[0] == reshadefx::blend_op::max && first.render_target_write_mask[0] == 7);
+	CHECK(first.stencil_enable && first.stencil_read_mask == 0x0F && first.stencil_write_mask == 0xF0 && first.stencil_reference_value == 3);
+	CHECK(first.stencil_comparison_func == reshadefx::stencil_func::equal && first.stencil_pass_op == reshadefx::stencil_op::increment && first.stencil_fail_op == reshadefx::stencil_op::zero && first.stencil_depth_fail_op == reshadefx::stencil_op::invert);
+	CHECK(first.topology == reshadefx::primitive_topology::triangle_strip && first.num_vertices == 4);
+	CHECK(first.texture_bindings.size() == 2 && first.sampler_bindings.size() == 2);
+	const reshadefx::pass &second = result.techniques[0].passes[1];
+	CHECK(!second.cs_entry_point.empty() && second.viewport_width == 2 && second.viewport_height == 2 && second.storage_bindings.size() == 1);
+	CHECK(result.techniques[0].passes[2].srgb_write_enable);
+
+	CHECK(result.entry_points.size() == 3 && result_entry_point_code.size() == 3);
+}
+
+TEST_CASE(effect_module_rejects_wrong_magic_or_version)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	const std::string data = serialize_test_effect(module, generated_code, entry_point_code);
+
+	CHECK(!reshadefx::is_serialized_module(patch_uint(data, 0, 0x12345678)));
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, 0, 0x12345678)));
+
+	// Version directly follows the magic
+	uint32_t version = 0;
+	std::memcpy(&version, data.data() + 4, sizeof(version));
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, 4, version + 1)));
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, 4, version - 1)));
+}
+
+TEST_CASE(effect_module_rejects_truncated_data)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	const std::string data = serialize_test_effect(module, generated_code, entry_point_code);
+
+	// Cut the data off within the header, within the reflection data, within the generated code and right before the end
+	for (const size_t size : { size_t(0), size_t(3), size_t(7), size_t(8), size_t(9), data.size() / 4, data.size() / 2, data.size() - generated_code.size(), data.size() - 1 })
+		CHECK(deserialize_leaves_outputs_untouched(std::string_view(data).substr(0, size)));
+
+	// Every other possible length has to be rejected as well, without reading past the end
+	bool all_rejected = true;
+	for (size_t size = 0; size < data.size(); size += 7)
+		all_rejected &= deserialize_leaves_outputs_untouched(std::string_view(data).substr(0, size));
+	CHECK(all_rejected);
+}
+
+TEST_CASE(effect_module_rejects_oversized_counts)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	const std::string data = serialize_test_effect(module, generated_code, entry_point_code);
+
+	// Texture count directly follows the header
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, 8, 0xFFFFFFFF)));
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, 8, static_cast<uint32_t>(data.size()))));
+
+	// Code of the last entry point is the last string in the data, so its length is right in front of it
+	const size_t last_code_size_offset = data.size() - entry_point_code.back().size() - sizeof(uint32_t);
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, last_code_size_offset, 0xFFFFFFFF)));
+	CHECK(deserialize_leaves_outputs_untouched(patch_uint(data, last_code_size_offset, static_cast<uint32_t>(entry_point_code.back().size() + 1))));
+}
+
+TEST_CASE(effect_module_rejects_trailing_bytes)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	const std::string data = serialize_test_effect(module, generated_code, entry_point_code);
+
+	CHECK(deserialize_leaves_outputs_untouched(data + '\0'));
+	CHECK(deserialize_leaves_outputs_untouched(data + data));
+}
+
+TEST_CASE(effect_module_rejects_entry_point_code_count_mismatch)
+{
+	reshadefx::effect_module module;
+	std::string generated_code;
+	std::vector<std::string> entry_point_code;
+	serialize_test_effect(module, generated_code, entry_point_code);
+
+	std::vector<std::string> fewer_entry_point_code = entry_point_code;
+	fewer_entry_point_code.pop_back();
+	CHECK(deserialize_leaves_outputs_untouched(reshadefx::serialize_module(module, generated_code, fewer_entry_point_code)));
+
+	std::vector<std::string> more_entry_point_code = entry_point_code;
+	more_entry_point_code.push_back("extra");
+	CHECK(deserialize_leaves_outputs_untouched(reshadefx::serialize_module(module, generated_code, more_entry_point_code)));
+
+	// Module without any entry points but with code for them is rejected too
+	module.entry_points.clear();
+	CHECK(deserialize_leaves_outputs_untouched(reshadefx::serialize_module(module, generated_code, entry_point_code)));
+}
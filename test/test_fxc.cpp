@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_module.hpp"
+#include <cstdio>
+#include <cstdint>
+
+TEST_CASE(fxc_batch_job_overrides_command_line_macro)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("fxc_batch_job_overrides_command_line_macro");
+
+	CHECK(reshade::test::write_file(directory / "test.fx", "static const int value_a = VALUE_A;\nstatic const int value_b = VALUE_B;\n"));
+	// The first job overrides one macro from the command-line, the second one inherits both unchanged
+	CHECK(reshade::test::write_file(directory / "batch.txt",
+		"test.fx -D VALUE_A=2 -P override.i\n"
+		"test.fx -P inherit.i\n"));
+
+	// Paths in the manifest are relative to the working directory
+	std::error_code ec;
+	const std::filesystem::path current_path = std::filesystem::current_path(ec);
+	std::filesystem::current_path(directory, ec);
+	CHECK(reshade::test::run_fxc("-D VALUE_A=1 -D VALUE_B=3 --batch batch.txt") == 0);
+	std::filesystem::current_path(current_path, ec);
+
+	std::string output;
+	CHECK(reshade::test::read_file(directory / "override.i", output));
+	CHECK(output.find("value_a = 2;") != std::string::npos);
+	CHECK(output.find("value_b = 3;") != std::string::npos);
+
+	CHECK(reshade::test::read_file(directory / "inherit.i", output));
+	CHECK(output.find("value_a = 1;") != std::string::npos);
+	CHECK(output.find("value_b = 3;") != std::string::npos);
+}
+
+TEST_CASE(fxc_later_macro_definition_replaces_earlier_one)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("fxc_later_macro_definition_replaces_earlier_one");
+
+	CHECK(reshade::test::write_file(directory / "test.fx", "static const int value = VALUE;\n"));
+
+	CHECK(reshade::test::run_fxc("-D VALUE=1 -D VALUE=2 -P \"" + (directory / "test.i").u8string() + "\" \"" + (directory / "test.fx").u8string() + '\"') == 0);
+
+	std::string output;
+	CHECK(reshade::test::read_file(directory / "test.i", output));
+	CHECK(output.find("value = 2;") != std::string::npos);
+}
+
+TEST_CASE(fxc_spirv_optimization_compiles_sample_effects)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("fxc_spirv_optimization_compiles_sample_effects");
+	// Sample effects are stored next to this source file
+	const std::filesystem::path effects_directory = std::filesystem::u8path(__FILE__).parent_path() / "effects";
+
+#ifdef _WIN32
+	const bool has_validator = reshade::test::run_command("spirv-val --version >nul 2>&1") == 0;
+#else
+	const bool has_validator = reshade::test::run_command("spirv-val --version >/dev/null 2>&1") == 0;
+#endif
+	if (!has_validator)
+		printf("  spirv-val was not found, so only checking that compilation succeeds and produces well-formed SPIR-V headers\n");
+
+	const auto is_spirv = [](const std::string &code) {
+		return code.size() >= 20 && code.size() % 4 == 0 && *reinterpret_cast<const uint32_t *>(code.data()) == 0x07230203;
+	};
+
+	for (const char *const effect_name : { "blur", "compute", "lut" })
+	{
+		size_t code_size[2] = {};
+
+		for (const bool optimize : { false, true })
+		{
+			const std::string output_name = std::string(effect_name) + (optimize ? "_optimized" : "");
+			const std::filesystem::path output_path = directory / (output_name + ".spv");
+			const std::filesystem::path module_path = directory / (output_name + ".fxm");
+
+			CHECK(reshade::test::run_fxc(std::string("--vulkan-semantics ") + (optimize ? "-O " : "") + "-Fo \"" + output_path.u8string() + "\" -Fm \"" + module_path.u8string() + "\" \"" + (effects_directory / (std::string(effect_name) + ".fx")).u8string() + '\"') == 0);
+
+			std::string code;
+			CHECK(reshade::test::read_file(output_path, code));
+			CHECK(is_spirv(code));
+			code_size[optimize] = code.size();
+
+			if (has_validator)
+				CHECK(reshade::test::run_command("spirv-val \"" + output_path.u8string() + '\"') == 0);
+
+			// The runtime uses the code generated for each entry point, which only contains the functions that entry point references
+			std::string module_data;
+			CHECK(reshade::test::read_file(module_path, module_data));
+
+			reshadefx::effect_module module;
+			std::string module_code;
+			std::vector<std::string> entry_point_code;
+			CHECK(reshadefx::deserialize_module(module_data, module, module_code, entry_point_code));
+			CHECK(!entry_point_code.empty() && entry_point_code.size() == module.entry_points.size());
+
+			for (size_t i = 0; i < entry_point_code.size(); ++i)
+			{
+				CHECK(is_spirv(entry_point_code[i]));
+				CHECK(entry_point_code[i].size() <= code.size());
+
+				if (has_validator)
+				{
+					const std::filesystem::path entry_point_path = directory / (output_name + '_' + std::to_string(i) + ".spv");
+					CHECK(reshade::test::write_file(entry_point_path, entry_point_code[i]));
+					CHECK(reshade::test::run_command("spirv-val \"" + entry_point_path.u8string() + '\"') == 0);
+				}
+			}
+		}
+
+		// Optimization only ever removes instructions
+		CHECK(code_size[1] <= code_size[0]);
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "gpu_budget.hpp"
+
+using reshade::technique_rate;
+
+static reshade::technique_schedule make_schedule(uint64_t gpu_duration_ms, int priority, bool allow_half_rate = true)
+{
+	reshade::technique_schedule schedule;
+	schedule.gpu_duration = gpu_duration_ms * 1000000;
+	schedule.priority = priority;
+	schedule.allow_half_rate = allow_half_rate;
+	return schedule;
+}
+
+/// <summary>
+/// Sums up the GPU time of all techniques rendered in the specified frame, based on their assigned rates.
+/// </summary>
+static uint64_t rendered_cost(const std::vector<reshade::technique_schedule> &schedules, uint64_t frame_count)
+{
+	uint64_t cost = 0;
+	for (const reshade::technique_schedule &schedule : schedules)
+		if (schedule.should_render(frame_count))
+			cost += schedule.gpu_duration;
+	return cost;
+}
+
+TEST_CASE(gpu_budget_keeps_everything_within_budget)
+{
+	std::vector<reshade::technique_schedule> schedules = { make_schedule(2, 0), make_schedule(3, 1, false) };
+	// Rates from a previous run are reset
+	schedules[0].rate = technique_rate::skipped;
+
+	CHECK(reshade::schedule_techniques(schedules, 5000000) == 5000000);
+	CHECK(schedules[0].rate == technique_rate::every_frame);
+	CHECK(schedules[1].rate == technique_rate::every_frame);
+}
+
+TEST_CASE(gpu_budget_throttles_lower_priority_first)
+{
+	std::vector<reshade::technique_schedule> schedules = { make_schedule(4, 1), make_schedule(4, 0) };
+
+	const uint64_t cost = reshade::schedule_techniques(schedules, 7000000);
+	CHECK(cost == 4000000);
+	CHECK(schedules[0].rate == technique_rate::every_frame);
+	CHECK(schedules[1].rate == technique_rate::skipped);
+
+	for (uint64_t frame_count = 0; frame_count < 4; ++frame_count)
+		CHECK(rendered_cost(schedules, frame_count) <= cost);
+}
+
+TEST_CASE(gpu_budget_spreads_half_rate_across_frames)
+{
+	std::vector<reshade::technique_schedule> schedules = { make_schedule(2, 0), make_schedule(2, 0), make_schedule(2, 0), make_schedule(2, 0) };
+
+	const uint64_t cost = reshade::schedule_techniques(schedules, 5000000);
+	CHECK(cost == 4000000);
+
+	uint32_t num_even = 0;
+	for (const reshade::technique_schedule &schedule : schedules)
+	{
+		CHECK(schedule.rate == technique_rate::every_other_frame);
+		num_even += schedule.frame_parity == 0;
+	}
+	CHECK(num_even == 2);
+
+	// Every technique is still rendered every second frame, with the cost split evenly between even and odd frames
+	CHECK(rendered_cost(schedules, 0) == 4000000);
+	CHECK(rendered_cost(schedules, 1) == 4000000);
+}
+
+TEST_CASE(gpu_budget_never_halves_techniques_without_half_rate)
+{
+	// Halving the two other techniques of the same priority is enough, so the one rendering to the back buffer keeps running every frame
+	std::vector<reshade::technique_schedule> schedules = { make_schedule(2, 0, false), make_schedule(2, 0), make_schedule(2, 0) };
+
+	CHECK(reshade::schedule_techniques(schedules, 4000000) == 4000000);
+	CHECK(schedules[0].rate == technique_rate::every_frame);
+	CHECK(schedules[1].rate == technique_rate::every_other_frame);
+	CHECK(schedules[2].rate == technique_rate::every_other_frame);
+	CHECK(schedules[1].frame_parity != schedules[2].frame_parity);
+
+	// Otherwise it goes straight to skipped, which frees up enough time to render the other one every frame again
+	schedules = { make_schedule(4, 0, false), make_schedule(2, 0) };
+
+	CHECK(reshade::schedule_techniques(schedules, 4000000) == 2000000);
+	CHECK(schedules[0].rate == technique_rate::skipped);
+	CHECK(schedules[1].rate == technique_rate::every_frame);
+
+	// Over budget even with everything throttled, so nothing that does not allow half rate is ever scheduled at half rate
+	schedules = { make_schedule(4, 0, false), make_schedule(4, 1, false), make_schedule(4, 1) };
+
+	CHECK(reshade::schedule_techniques(schedules, 1000000) == 0);
+	for (const reshade::technique_schedule &schedule : schedules)
+		CHECK(schedule.rate == technique_rate::skipped);
+}
+
+TEST_CASE(gpu_budget_ignores_unmeasured_techniques)
+{
+	std::vector<reshade::technique_schedule> schedules = { make_schedule(0, 0), make_schedule(0, 0, false), make_schedule(4, 1) };
+
+	CHECK(reshade::schedule_techniques(schedules, 1000000) == 0);
+	CHECK(schedules[0].rate == technique_rate::every_frame);
+	CHECK(schedules[1].rate == technique_rate::every_frame);
+	CHECK(schedules[2].rate == technique_rate::skipped);
+}
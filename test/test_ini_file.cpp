@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "ini_file.hpp"
+#include <cstdio>
+#include <random>
+
+// Referenced by 'ini_file.cpp' to locate the global configuration, which is not used by these tests
+std::filesystem::path g_reshade_dll_path;
+std::filesystem::path g_reshade_base_path;
+std::filesystem::path g_target_executable_path;
+
+static const char s_test_ini[] =
+	"\xEF\xBB\xBFGlobal=1\r\n"
+	"; Comment\r\n"
+	"Lonely key\r\n"
+	"\r\n"
+	"[Section]\r\n"
+	"Text=some,,text with,, commas,x\r\n"
+	"Empty=\r\n"
+	"Dup=a,b\r\n"
+	"Dup=c\r\n"
+	"  Number = 42  \r\n"
+	"\r\n"
+	"[Other]\r\n"
+	"Dup=other\r\n";
+
+/// <summary>
+/// Checks the values that are expected in the test INI file, both right after loading it and after saving it to disk again.
+/// </summary>
+static void check_test_ini(const ini_file &ini)
+{
+	int number = 0;
+	std::string value;
+	std::vector<std::string> values;
+
+	// Byte order mark is not part of the first key
+	CHECK(ini.get("", "Global", number) && number == 1);
+
+	// Lines without an equals sign are keys without a value
+	CHECK(ini.get("", "Lonely key", value) && value.empty());
+
+	CHECK(ini.get("Section", "Text", values) && values == std::vector<std::string>({ "some,text with, commas", "x" }));
+	CHECK(ini.get("Section", "Empty", values) && values.empty());
+	// Carriage returns and surrounding whitespace are trimmed
+	CHECK(ini.get("Section", "Number", value) && value == "42");
+
+	// Same key in a different section is a separate entry
+	CHECK(ini.get("Other", "Dup", values) && values == std::vector<std::string>({ "other" }));
+}
+
+TEST_CASE(ini_file_round_trip)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("ini_file_round_trip");
+	CHECK(reshade::test::write_file(directory / "test.ini", s_test_ini));
+
+	{
+		ini_file ini(directory / "test.ini");
+		check_test_ini(ini);
+
+		// Values of a key that appears multiple times are appended
+		std::vector<std::string> values;
+		CHECK(ini.get("Section", "Dup", values) && values == std::vector<std::string>({ "a", "b", "c" }));
+
+		// Modify after loading, so that keys read from disk and keys added afterwards are mixed
+		ini.set("Section", "Added", std::string("value"));
+		ini.set("New", "List", std::vector<std::string>({ "x,y", "z" }));
+		ini.remove_key("Section", "Dup");
+		ini.remove_key("Section", "Missing");
+		ini.remove_key("Missing", "Dup");
+		CHECK(!ini.has("Section", "Dup"));
+		CHECK(ini.has("Other", "Dup"));
+
+		CHECK(ini.save());
+	}
+
+	{
+		ini_file ini(directory / "test.ini");
+		check_test_ini(ini);
+
+		std::string value;
+		std::vector<std::string> values;
+		CHECK(!ini.has("Section", "Dup"));
+		CHECK(!ini.has("Section", "Missing"));
+		CHECK(ini.get("Section", "Added", value) && value == "value");
+		CHECK(ini.get("New", "List", values) && values == std::vector<std::string>({ "x,y", "z" }));
+	}
+}
+
+TEST_CASE(ini_file_remove_key_keeps_names_still_in_use)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("ini_file_remove_key_keeps_names_still_in_use");
+	CHECK(reshade::test::write_file(directory / "test.ini", s_test_ini));
+
+	ini_file ini(directory / "test.ini");
+
+	// Key with the same name as its section shares the name with it, so removing the key must not release it
+	ini.set("Name", "Name", std::string("1"));
+	ini.remove_key("Name", "Name");
+	ini.set("Name", "Other", std::string("2"));
+	CHECK(!ini.has("Name", "Name"));
+	CHECK(ini.has("Name", "Other"));
+
+	// Same goes for a key that is still used in another section
+	ini.set("A", "Shared", std::string("1"));
+	ini.set("B", "Shared", std::string("2"));
+	ini.remove_key("A", "Shared");
+	std::string value;
+	CHECK(!ini.has("A", "Shared"));
+	CHECK(ini.get("B", "Shared", value) && value == "2");
+
+	// Adding a key again after it was removed everywhere interns its name again
+	ini.remove_key("B", "Shared");
+	ini.set("A", "Shared", std::string("3"));
+	CHECK(ini.get("A", "Shared", value) && value == "3");
+
+	check_test_ini(ini);
+}
+
+/// <summary>
+/// Generates an INI file similar to a large preset, with many effect sections each containing many uniform values.
+/// </summary>
+static std::string generate_ini(size_t num_sections, size_t num_keys)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+
+	std::string data = "\xEF\xBB\xBFPreprocessorDefinitions=A=1,B=2,,3,C\r\nTechniques=Foo@a.fx,Bar@b.fx\r\n\r\n";
+
+	char buffer[32];
+	for (size_t i = 0; i < num_sections; ++i)
+	{
+		data += "[Effect" + std::to_string(i) + ".fx]\r\n";
+
+		for (size_t k = 0; k < num_keys; ++k)
+		{
+			data += "Uniform" + std::to_string(k) + '=';
+
+			for (size_t c = 0, num_components = 1 + random() % 4; c < num_components; ++c)
+			{
+				if (c != 0)
+					data += ',';
+				data.append(buffer, std::snprintf(buffer, sizeof(buffer), "%f", distribution(random)));
+			}
+
+			data += "\r\n";
+		}
+
+		data += "\r\n";
+	}
+
+	return data;
+}
+
+BENCHMARK(ini_file_load_and_save)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("ini_file_load_and_save");
+	const std::string data = generate_ini(400, 40);
+	CHECK(reshade::test::write_file(directory / "test.ini", data));
+
+	size_t num_sections = 0;
+	const double load_duration = reshade::test::measure(100, [&]() {
+		ini_file ini(directory / "test.ini");
+		num_sections += ini.has("Effect0.fx", "Uniform0");
+	});
+	CHECK(num_sections == 100);
+
+	ini_file ini(directory / "save.ini");
+	for (size_t i = 0; i < 400; ++i)
+		for (size_t k = 0; k < 40; ++k)
+			ini.set("Effect" + std::to_string(i) + ".fx", "Uniform" + std::to_string(k), std::vector<float>({ 0.5f, 1.0f, 2.0f }));
+
+	const double save_duration = reshade::test::measure(100, [&]() {
+		ini.set("Effect0.fx", "Uniform0", std::string("1"));
+		ini.save();
+	});
+
+	printf("  %zu KiB: load %.3f ms, save %.3f ms\n", data.size() / 1024, load_duration, save_duration);
+}
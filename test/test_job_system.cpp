@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "job_system.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+
+/// <summary>
+/// Generates an effect with the specified number of techniques, each with its own entry point.
+/// </summary>
+static std::string generate_effect(size_t num_techniques)
+{
+	std::string source = "texture2D tex; sampler2D samp { Texture = tex; };\n";
+
+	for (size_t i = 0; i < num_techniques; ++i)
+	{
+		const std::string index = std::to_string(i);
+
+		source += "float4 PS" + index + "(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target { float4 color = tex2D(samp, uv); for (int k = 0; k < " + std::to_string(i + 1) + "; ++k) color = color * 0.5 + " + index + ".0; return color; }\n";
+		source += "float4 VS" + index + "(uint id : SV_VertexID) : SV_Position { return float4(id * " + index + ".0, 0, 0, 1); }\n";
+		source += "technique T" + index + " { pass { VertexShader = VS" + index + "; PixelShader = PS" + index + "; } }\n";
+	}
+
+	return source;
+}
+
+/// <summary>
+/// Compiles the specified effect source and returns the code generated for every entry point.
+/// </summary>
+static bool compile_effect(const std::string &source, std::vector<std::string> &entry_point_code, const reshadefx::codegen::parallel_executor &executor)
+{
+	reshadefx::preprocessor pp;
+	if (!pp.append_string(source, "synthetic.fx"))
+		return false;
+
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	if (!parser.parse(pp.output(), codegen.get()))
+		return false;
+
+	entry_point_code = codegen->finalize_code_for_entry_points(executor);
+	return entry_point_code.size() == codegen->module().entry_points.size();
+}
+
+TEST_CASE(job_system_compiles_synthetic_effects)
+{
+	constexpr size_t num_effects = 16;
+
+	std::vector<std::string> sources(num_effects);
+	std::vector<std::vector<std::string>> expected_code(num_effects);
+	for (size_t i = 0; i < num_effects; ++i)
+	{
+		sources[i] = generate_effect(1 + i % 5);
+		CHECK(compile_effect(sources[i], expected_code[i], nullptr));
+		CHECK(expected_code[i].size() == 2 * (1 + i % 5));
+	}
+
+	reshade::job_system jobs(4);
+	const reshadefx::codegen::parallel_executor executor = [&jobs](size_t count, const std::function<void(size_t)> &func) {
+		reshade::job_system::group entry_point_jobs;
+		for (size_t i = 0; i < count; ++i)
+			jobs.submit(entry_point_jobs, [&func, i]() { func(i); });
+		jobs.wait(entry_point_jobs);
+	};
+
+	// Compile all effects in parallel, with each compilation in turn spreading its entry points across the same job system and waiting on them from within a job
+	std::vector<std::vector<std::string>> actual_code(num_effects);
+	std::vector<char> succeeded(num_effects, 0);
+	reshade::job_system::group effect_jobs;
+	for (size_t i = 0; i < num_effects; ++i)
+		jobs.submit(effect_jobs, [&, i]() { succeeded[i] = compile_effect(sources[i], actual_code[i], executor); });
+	jobs.wait(effect_jobs);
+
+	for (size_t i = 0; i < num_effects; ++i)
+	{
+		CHECK(succeeded[i]);
+		CHECK(actual_code[i] == expected_code[i]);
+	}
+}
+
+TEST_CASE(job_system_runs_higher_priority_first)
+{
+	reshade::job_system jobs(1);
+
+	// Keep the only worker thread busy, so that the remaining jobs pile up in its queue
+	std::atomic<bool> release = false;
+	std::atomic<bool> started = false;
+	reshade::job_system::group blocking_job;
+	jobs.submit(blocking_job, [&]() { started = true; while (!release) std::this_thread::yield(); });
+	while (!started)
+		std::this_thread::yield();
+
+	std::mutex order_mutex;
+	std::vector<int> order;
+	reshade::job_system::group ordered_jobs;
+	for (const reshade::job_system::priority priority : { reshade::job_system::priority::low, reshade::job_system::priority::normal, reshade::job_system::priority::high })
+		jobs.submit(ordered_jobs, [&order_mutex, &order, priority]() {
+			const std::unique_lock<std::mutex> lock(order_mutex);
+			order.push_back(static_cast<int>(priority));
+		}, priority);
+
+	// Waiting executes the queued jobs on this thread, while the worker thread is still blocked
+	jobs.wait(ordered_jobs);
+	release = true;
+	jobs.wait(blocking_job);
+
+	CHECK(order == std::vector<int>({ 2, 1, 0 }));
+}
+
+TEST_CASE(job_system_cancel_discards_queued_jobs)
+{
+	reshade::job_system jobs(1);
+
+	std::atomic<bool> release = false;
+	std::atomic<bool> started = false;
+	reshade::job_system::group blocking_job;
+	jobs.submit(blocking_job, [&]() { started = true; while (!release) std::this_thread::yield(); });
+	while (!started)
+		std::this_thread::yield();
+
+	std::atomic<size_t> num_executed = 0;
+	reshade::job_system::group cancelled_jobs;
+	for (size_t i = 0; i < 8; ++i)
+		jobs.submit(cancelled_jobs, [&num_executed]() { num_executed++; });
+
+	jobs.cancel(cancelled_jobs);
+	release = true;
+	jobs.wait(blocking_job);
+
+	CHECK(num_executed == 0);
+	CHECK(!cancelled_jobs.is_cancelled());
+}
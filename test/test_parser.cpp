@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <cstdio>
+
+/// <summary>
+/// Generates an effect with many global symbols, a function with deeply nested blocks and a very long function made of many sequential blocks, which all declare local variables.
+/// </summary>
+static std::string generate_stress_effect(size_t num_globals, size_t nesting_depth, size_t num_blocks)
+{
+	std::string source;
+
+	for (size_t i = 0; i < num_globals; ++i)
+		source += "static const float g" + std::to_string(i) + " = " + std::to_string(i) + ".0;\n";
+
+	source += "float Nested(float x)\n{\n";
+	for (size_t i = 0; i < nesting_depth; ++i)
+		source += "if (x > " + std::to_string(i) + ".0) { float n" + std::to_string(i) + " = x * g" + std::to_string(i % num_globals) + "; x += n" + std::to_string(i) + ";\n";
+	source += std::string(nesting_depth, '}');
+	source += "\nreturn x;\n}\n";
+
+	source += "float4 PS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\nfloat x = uv.x;\n";
+	for (size_t i = 0; i < num_blocks; ++i)
+		source += "{ float a = x + g" + std::to_string(i % num_globals) + "; float b = a * a; for (int k = 0; k < 2; ++k) { float c = b - k; x += c; } }\n";
+	source += "return Nested(x);\n}\n";
+
+	source += "void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD) { texcoord = float2((id == 2) ? 2.0 : 0.0, (id == 1) ? 2.0 : 0.0); position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0); }\n";
+	source += "technique T { pass { VertexShader = PostProcessVS; PixelShader = PS; } }\n";
+
+	return source;
+}
+
+BENCHMARK(parser_stress_effect)
+{
+	const std::string source = generate_stress_effect(3000, 200, 4000);
+
+	bool success = true;
+	const double duration = reshade::test::measure(5, [&]() {
+		// SPIR-V back-end does the least work per statement, so that this mostly measures the parser and symbol table
+		const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_spirv(true, false, false));
+
+		reshadefx::parser parser;
+		success &= parser.parse(source, codegen.get());
+	});
+	CHECK(success);
+
+	printf("  %zu KiB: %.3f ms\n", source.size() / 1024, duration);
+}
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_preprocessor.hpp"
+#include <cstdio>
+#include <chrono> // std::chrono::hours
+#include <algorithm> // std::sort
+
+/// <summary>
+/// Everything a preprocessor run produces that the runtime depends on, which has to be the same whether precompiled headers are used or not.
+/// </summary>
+struct preprocess_result
+{
+	bool success = false;
+	std::string output;
+	std::string errors;
+	std::vector<std::pair<std::string, std::string>> used_macro_definitions;
+	std::vector<std::string> referenced_predefined_macros;
+	std::vector<std::filesystem::path> missing_include_files;
+	std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> included_files;
+
+	bool operator==(const preprocess_result &other) const
+	{
+		return success == other.success && output == other.output && errors == other.errors && used_macro_definitions == other.used_macro_definitions && referenced_predefined_macros == other.referenced_predefined_macros && missing_include_files == other.missing_include_files && included_files == other.included_files;
+	}
+};
+
+/// <summary>
+/// Preprocesses the specified effect source as if it was stored in 'effect.fx' in the specified directory, with the specified predefined macros and include paths.
+/// </summary>
+static preprocess_result preprocess(const std::filesystem::path &directory, const std::string &source, bool precompiled_headers, const std::vector<std::pair<std::string, std::string>> &macros = {}, const std::vector<std::filesystem::path> &include_paths = {})
+{
+	reshadefx::preprocessor pp;
+	for (const std::filesystem::path &include_path : include_paths)
+		pp.add_include_path(include_path);
+	for (const std::pair<std::string, std::string> &definition : macros)
+		pp.add_macro_definition(definition.first, definition.second);
+	pp.enable_precompiled_headers(precompiled_headers);
+
+	preprocess_result result;
+	result.success = pp.append_string(source, directory / "effect.fx");
+	result.output = pp.output();
+	result.errors = pp.errors();
+	result.used_macro_definitions = pp.used_macro_definitions();
+	result.referenced_predefined_macros = pp.referenced_predefined_macros();
+	result.missing_include_files = pp.missing_include_files();
+	result.included_files = pp.included_files_with_modification_time();
+
+	// Order of these depends on hash tables, so sort them for comparison
+	std::sort(result.used_macro_definitions.begin(), result.used_macro_definitions.end());
+	std::sort(result.missing_include_files.begin(), result.missing_include_files.end());
+	std::sort(result.included_files.begin(), result.included_files.end());
+
+	return result;
+}
+
+/// <summary>
+/// Preprocesses the specified effect source without precompiled headers, then twice with them (first recording and then replaying all headers), and checks that all runs produce the same result.
+/// </summary>
+static preprocess_result check_precompiled_headers_match(const std::filesystem::path &directory, const std::string &source, const std::vector<std::pair<std::string, std::string>> &macros = {}, const std::vector<std::filesystem::path> &include_paths = {})
+{
+	reshadefx::preprocessor::clear_include_cache();
+
+	const preprocess_result reference = preprocess(directory, source, false, macros, include_paths);
+	CHECK(reference.success);
+
+	const preprocess_result recorded = preprocess(directory, source, true, macros, include_paths);
+	CHECK(recorded == reference);
+	const preprocess_result replayed = preprocess(directory, source, true, macros, include_paths);
+	CHECK(replayed == reference);
+
+	return reference;
+}
+
+TEST_CASE(preprocessor_precompiled_header_pragma_once)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_pragma_once");
+	CHECK(reshade::test::write_file(directory / "once.fxh", "#pragma once\nfloat Once() { return 1.0; }\n"));
+	CHECK(reshade::test::write_file(directory / "a.fxh", "#include \"once.fxh\"\nfloat A() { return Once(); }\n"));
+	CHECK(reshade::test::write_file(directory / "b.fxh", "#include \"once.fxh\"\nfloat B() { return Once(); }\n"));
+
+	// Second include of 'once.fxh' through 'b.fxh' has to be skipped when 'a.fxh' is replayed as well
+	const preprocess_result result = check_precompiled_headers_match(directory, "#include \"a.fxh\"\n#include \"b.fxh\"\n#include \"once.fxh\"\n");
+	size_t num_definitions = 0;
+	for (size_t offset = 0; (offset = result.output.find("float Once()", offset)) != std::string::npos; ++offset)
+		num_definitions++;
+	CHECK(num_definitions == 1);
+}
+
+TEST_CASE(preprocessor_precompiled_header_undef)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_undef");
+	CHECK(reshade::test::write_file(directory / "header.fxh", "#undef VALUE\n#define VALUE 2\n#undef OTHER\n#define ADDED 3\n"));
+
+	const preprocess_result result = check_precompiled_headers_match(directory, "#define VALUE 1\n#define OTHER 1\n#include \"header.fxh\"\nint a = VALUE; int b = ADDED;\n#ifdef OTHER\nint c;\n#endif\n");
+	CHECK(result.output.find("int a = 2; int b = 3;") != std::string::npos);
+	CHECK(result.output.find("int c;") == std::string::npos);
+}
+
+TEST_CASE(preprocessor_precompiled_header_nested_includes)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_nested_includes");
+	CHECK(reshade::test::write_file(directory / "outer.fxh", "#define OUTER 1\n#include \"inner.fxh\"\nfloat Outer() { return Inner() + OUTER; }\n"));
+	CHECK(reshade::test::write_file(directory / "inner.fxh", "#pragma reshade showfps\n#define INNER 2\nfloat Inner() { return INNER; }\n"));
+
+	const preprocess_result result = check_precompiled_headers_match(directory, "#include \"outer.fxh\"\nfloat x = OUTER + INNER;\n");
+	CHECK(result.output.find("float x = 1 + 2;") != std::string::npos);
+	CHECK(result.included_files.size() == 2);
+}
+
+TEST_CASE(preprocessor_precompiled_header_macro_states)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_macro_states");
+	CHECK(reshade::test::write_file(directory / "header.fxh", "#ifndef MODE\n#define MODE 0\n#endif\n#if MODE == 1\nfloat Mode() { return 1.0; }\n#else\nfloat Mode() { return BUFFER_WIDTH; }\n#endif\n"));
+
+	reshadefx::preprocessor::clear_include_cache();
+
+	// Record the header under one set of macros, then make sure it is not replayed under another
+	const char *const source = "#include \"header.fxh\"\n";
+	for (const std::vector<std::pair<std::string, std::string>> &macros : {
+			std::vector<std::pair<std::string, std::string>> { { "BUFFER_WIDTH", "1920" } },
+			std::vector<std::pair<std::string, std::string>> { { "BUFFER_WIDTH", "1280" } },
+			std::vector<std::pair<std::string, std::string>> { { "BUFFER_WIDTH", "1920" }, { "MODE", "1" } } })
+	{
+		const preprocess_result reference = preprocess(directory, source, false, macros);
+		CHECK(preprocess(directory, source, true, macros) == reference);
+		CHECK(preprocess(directory, source, true, macros) == reference);
+	}
+
+	// Same applies to macros defined by the effect itself before including the header
+	for (const char *const mode : { "0", "1" })
+	{
+		const std::string mode_source = std::string("#define MODE ") + mode + '\n' + source;
+		const preprocess_result reference = preprocess(directory, mode_source, false, { { "BUFFER_WIDTH", "1920" } });
+		CHECK(reference.output.find(mode[0] == '1' ? "return 1.0;" : "return 1920;") != std::string::npos);
+		CHECK(preprocess(directory, mode_source, true, { { "BUFFER_WIDTH", "1920" } }) == reference);
+	}
+}
+
+TEST_CASE(preprocessor_precompiled_header_reports_same_dependencies)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_reports_same_dependencies");
+	std::filesystem::create_directories(directory / "first");
+	std::filesystem::create_directories(directory / "second");
+	std::filesystem::create_directories(directory / "third");
+	CHECK(reshade::test::write_file(directory / "second" / "header.fxh", "#ifdef USED\n#endif\n#if BUFFER_HEIGHT > 0\n#endif\n#include \"nested.fxh\"\n"));
+	CHECK(reshade::test::write_file(directory / "third" / "nested.fxh", "#ifndef NESTED_OPTION\n#define NESTED_OPTION 2\n#endif\n"));
+
+	const preprocess_result result = check_precompiled_headers_match(directory, "#include \"header.fxh\"\n",
+		{ { "BUFFER_WIDTH", "1920" }, { "BUFFER_HEIGHT", "1080" }, { "USED", "1" } }, { directory / "first", directory / "second", directory / "third" });
+
+	CHECK((result.used_macro_definitions == std::vector<std::pair<std::string, std::string>>({ { "NESTED_OPTION", "2" }, { "USED", "1" } })));
+	CHECK(result.referenced_predefined_macros == std::vector<std::string>({ "BUFFER_HEIGHT", "USED" }));
+	// Probes for 'header.fxh' next to the effect and in the first include path, and for 'nested.fxh' next to the header and in the first and second include path
+	CHECK(result.missing_include_files == std::vector<std::filesystem::path>({ directory / "first" / "header.fxh", directory / "first" / "nested.fxh", directory / "header.fxh", directory / "second" / "nested.fxh" }));
+	CHECK(result.included_files.size() == 2);
+}
+
+TEST_CASE(preprocessor_precompiled_header_not_replayed_when_shadowed)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_not_replayed_when_shadowed");
+	std::filesystem::create_directories(directory / "headers");
+	std::filesystem::create_directories(directory / "first");
+	std::filesystem::create_directories(directory / "second");
+	CHECK(reshade::test::write_file(directory / "headers" / "header.fxh", "#include \"nested.fxh\"\n"));
+	CHECK(reshade::test::write_file(directory / "second" / "nested.fxh", "float Second;\n"));
+
+	const std::vector<std::filesystem::path> include_paths = { directory / "headers", directory / "first", directory / "second" };
+
+	reshadefx::preprocessor::clear_include_cache();
+	CHECK(preprocess(directory, "#include \"header.fxh\"\n", true, {}, include_paths).output.find("float Second;") != std::string::npos);
+
+	// New file in an earlier include directory takes precedence over the one the header was recorded with
+	CHECK(reshade::test::write_file(directory / "first" / "nested.fxh", "float First;\n"));
+
+	const preprocess_result result = preprocess(directory, "#include \"header.fxh\"\n", true, {}, include_paths);
+	CHECK(result.output.find("float First;") != std::string::npos);
+	CHECK(result.output.find("float Second;") == std::string::npos);
+	CHECK(result == preprocess(directory, "#include \"header.fxh\"\n", false, {}, include_paths));
+
+	reshadefx::preprocessor::clear_include_cache();
+}
+
+TEST_CASE(preprocessor_include_probes_report_missing_paths)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_include_probes_report_missing_paths");
+	std::filesystem::create_directories(directory / "first");
+	std::filesystem::create_directories(directory / "second");
+	CHECK(reshade::test::write_file(directory / "local.fxh", "float Local;\n"));
+	CHECK(reshade::test::write_file(directory / "first" / "both.fxh", "float First;\n"));
+	CHECK(reshade::test::write_file(directory / "second" / "both.fxh", "float Second;\n"));
+	CHECK(reshade::test::write_file(directory / "second" / "last.fxh", "float Last;\n"));
+
+	const std::vector<std::filesystem::path> include_paths = { directory / "first", directory / "second" };
+
+	// File next to the effect is found first and does not probe any include paths
+	preprocess_result result = preprocess(directory, "#include \"local.fxh\"\n", false, {}, include_paths);
+	CHECK(result.success && result.output.find("float Local;") != std::string::npos);
+	CHECK(result.missing_include_files.empty());
+
+	// Include paths are probed in order and the search stops at the first match
+	result = preprocess(directory, "#include \"both.fxh\"\n", false, {}, include_paths);
+	CHECK(result.success && result.output.find("float First;") != std::string::npos && result.output.find("float Second;") == std::string::npos);
+	CHECK(result.missing_include_files == std::vector<std::filesystem::path>({ directory / "both.fxh" }));
+
+	result = preprocess(directory, "#include \"last.fxh\"\n", false, {}, include_paths);
+	CHECK(result.success && result.output.find("float Last;") != std::string::npos);
+	CHECK(result.missing_include_files == std::vector<std::filesystem::path>({ directory / "first" / "last.fxh", directory / "last.fxh" }));
+
+	// File that does not exist anywhere fails, but every probed path is still reported, so that creating the file later triggers a reload
+	result = preprocess(directory, "#include \"none.fxh\"\n", false, {}, include_paths);
+	CHECK(!result.success);
+	CHECK(result.missing_include_files == std::vector<std::filesystem::path>({ directory / "first" / "none.fxh", directory / "none.fxh", directory / "second" / "none.fxh" }));
+	CHECK(result.included_files.empty());
+}
+
+TEST_CASE(preprocessor_included_files_modification_time_recorded_at_read)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_included_files_modification_time_recorded_at_read");
+	CHECK(reshade::test::write_file(directory / "header.fxh", "float Old;\n"));
+
+	// Use explicit modification times, so that the test does not depend on the file system timestamp resolution
+	const std::filesystem::file_time_type old_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(2);
+	const std::filesystem::file_time_type new_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+	std::filesystem::last_write_time(directory / "header.fxh", old_time);
+
+	reshadefx::preprocessor::clear_include_cache();
+
+	reshadefx::preprocessor pp;
+	CHECK(pp.append_string("#include \"header.fxh\"\n", directory / "effect.fx"));
+
+	// Modify the file after it was read, which must not affect the time reported for the contents that were actually used
+	CHECK(reshade::test::write_file(directory / "header.fxh", "float New;\n"));
+	std::filesystem::last_write_time(directory / "header.fxh", new_time);
+
+	CHECK(pp.output().find("float Old;") != std::string::npos);
+	CHECK((pp.included_files_with_modification_time() == std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>({ { directory / "header.fxh", old_time } })));
+
+	// Next run reads the modified file instead of using the cached contents and reports the new time
+	const preprocess_result result = preprocess(directory, "#include \"header.fxh\"\n", false);
+	CHECK(result.output.find("float New;") != std::string::npos);
+	CHECK((result.included_files == std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>({ { directory / "header.fxh", new_time } })));
+}
+
+TEST_CASE(preprocessor_precompiled_header_replay_reports_nested_dependencies)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_header_replay_reports_nested_dependencies");
+	std::filesystem::create_directories(directory / "headers");
+	CHECK(reshade::test::write_file(directory / "outer.fxh", "#include \"inner.fxh\"\nfloat Outer() { return Inner(); }\n"));
+	CHECK(reshade::test::write_file(directory / "headers" / "inner.fxh", "float Inner() { return 1.0; }\n"));
+
+	const std::filesystem::file_time_type outer_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(3);
+	const std::filesystem::file_time_type inner_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(2);
+	std::filesystem::last_write_time(directory / "outer.fxh", outer_time);
+	std::filesystem::last_write_time(directory / "headers" / "inner.fxh", inner_time);
+
+	const std::vector<std::filesystem::path> include_paths = { directory / "headers" };
+
+	reshadefx::preprocessor::clear_include_cache();
+
+	// Files only included by the replayed header have to be reported with the time they had when their contents were read
+	CHECK(preprocess(directory, "#include \"outer.fxh\"\n", true, {}, include_paths).success);
+	preprocess_result result = preprocess(directory, "#include \"outer.fxh\"\n", true, {}, include_paths);
+	CHECK(result.success && result.output.find("return 1.0;") != std::string::npos);
+	CHECK((result.included_files == std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>({ { directory / "headers" / "inner.fxh", inner_time }, { directory / "outer.fxh", outer_time } })));
+	CHECK(result.missing_include_files == std::vector<std::filesystem::path>({ directory / "inner.fxh" }));
+
+	// Modifying the nested file invalidates the recorded header, so the new contents and time are reported
+	const std::filesystem::file_time_type modified_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+	CHECK(reshade::test::write_file(directory / "headers" / "inner.fxh", "float Inner() { return 2.0; }\n"));
+	std::filesystem::last_write_time(directory / "headers" / "inner.fxh", modified_time);
+
+	result = preprocess(directory, "#include \"outer.fxh\"\n", true, {}, include_paths);
+	CHECK(result.success && result.output.find("return 2.0;") != std::string::npos);
+	CHECK((result.included_files == std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>({ { directory / "headers" / "inner.fxh", modified_time }, { directory / "outer.fxh", outer_time } })));
+	CHECK(result == preprocess(directory, "#include \"outer.fxh\"\n", false, {}, include_paths));
+
+	reshadefx::preprocessor::clear_include_cache();
+}
+
+/// <summary>
+/// Generates a shared header similar to 'ReShade.fxh', with the specified number of configuration macros, conditional blocks and helper functions.
+/// </summary>
+static std::string generate_header(size_t num_functions)
+{
+	std::string source = "#pragma once\n#ifndef BUFFER_WIDTH\n#define BUFFER_WIDTH 1920\n#endif\n#define BUFFER_PIXEL_SIZE float2(1.0 / BUFFER_WIDTH, 1.0 / 1080)\n";
+
+	for (size_t i = 0; i < num_functions; ++i)
+	{
+		const std::string index = std::to_string(i);
+
+		source += "#define CONFIG_" + index + " (" + index + " % 3)\n";
+		source += "#if CONFIG_" + index + " == 1 && defined(BUFFER_WIDTH)\n";
+		source += "float Helper" + index + "(float2 uv) { return dot(uv, BUFFER_PIXEL_SIZE) * CONFIG_" + index + "; }\n";
+		source += "#elif CONFIG_" + index + " == 2\n";
+		source += "float Helper" + index + "(float2 uv) { return uv.x * " + index + ".0 + uv.y; } // Second variant\n";
+		source += "#else\n";
+		source += "/* Default variant */ float Helper" + index + "(float2 uv) { return 0.0; }\n";
+		source += "#endif\n";
+	}
+
+	return source;
+}
+
+/// <summary>
+/// Preprocesses the specified number of effects that all include the same header, like the runtime does when loading effects, and returns their combined output.
+/// </summary>
+static std::string preprocess_effects(const std::filesystem::path &directory, size_t num_effects, bool precompiled_headers)
+{
+	std::string output;
+
+	for (size_t i = 0; i < num_effects; ++i)
+	{
+		reshadefx::preprocessor pp;
+		pp.add_include_path(directory);
+		pp.add_macro_definition("BUFFER_WIDTH", "1920");
+		pp.enable_precompiled_headers(precompiled_headers);
+
+		if (!pp.append_string("#include \"header.fxh\"\nfloat4 PS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target { return Helper" + std::to_string(i) + "(uv); }\n", directory / ("effect" + std::to_string(i) + ".fx")))
+			return std::string();
+
+		output += pp.output();
+	}
+
+	return output;
+}
+
+BENCHMARK(preprocessor_precompiled_headers)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_precompiled_headers");
+	CHECK(reshade::test::write_file(directory / "header.fxh", generate_header(1000)));
+
+	std::string cold_output, replayed_output;
+
+	reshadefx::preprocessor::clear_include_cache();
+	const double cold_duration = reshade::test::measure(1, [&]() { cold_output = preprocess_effects(directory, 50, false); });
+
+	// First effect records the header, all others replay it
+	reshadefx::preprocessor::clear_include_cache();
+	const double replayed_duration = reshade::test::measure(1, [&]() { replayed_output = preprocess_effects(directory, 50, true); });
+
+	CHECK(!cold_output.empty() && cold_output == replayed_output);
+
+	printf("  50 effects: cold %.3f ms, replayed %.3f ms\n", cold_duration, replayed_duration);
+
+	reshadefx::preprocessor::clear_include_cache();
+}
+
+/// <summary>
+/// Generates an effect with a chain of function-like macros that each expand to the previous one, like macro-based loop unrolling in shader libraries, and the specified number of expansions of the outermost macro.
+/// </summary>
+static std::string generate_nested_macros(size_t nesting_depth, size_t num_expansions)
+{
+	std::string source = "#define M0(x, y) ((x) * (y))\n";
+
+	for (size_t i = 1; i <= nesting_depth; ++i)
+		source += "#define M" + std::to_string(i) + "(x, y) M" + std::to_string(i - 1) + "(x, y)\n";
+
+	for (size_t i = 0; i < num_expansions; ++i)
+		source += "static const float value" + std::to_string(i) + " = M" + std::to_string(nesting_depth) + "(" + std::to_string(i) + ", 2);\n";
+
+	return source;
+}
+
+BENCHMARK(preprocessor_nested_macros)
+{
+	const std::string source = generate_nested_macros(200, 200);
+
+	bool success = true;
+	std::string output;
+	const double duration = reshade::test::measure(10, [&]() {
+		reshadefx::preprocessor pp;
+		success &= pp.append_string(source, "nested_macros.fx");
+		output = pp.output();
+	});
+	CHECK(success);
+	CHECK(output.find("value199 = ((199) * (2));") != std::string::npos);
+
+	printf("  200 levels, 200 expansions: %.3f ms\n", duration);
+}
+
+TEST_CASE(preprocessor_referenced_predefined_macros)
+{
+	const std::filesystem::path directory = reshade::test::create_temp_directory("preprocessor_referenced_predefined_macros");
+
+	const std::vector<std::pair<std::string, std::string>> macros = {
+		{ "BUFFER_WIDTH", "1920" }, { "BUFFER_HEIGHT", "1080" }, { "BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)" }, { "BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)" },
+		{ "DEFINED_CHECK", "1" }, { "IFDEF_CHECK", "1" }, { "IFNDEF_CHECK", "1" }, { "REDEFINED", "1" }, { "UNUSED", "1" } };
+
+	// Expanding 'BUFFER_RCP_WIDTH' expands 'BUFFER_WIDTH' as well, but macros that are not predefined and predefined macros that were replaced by the effect do not count
+	const std::string checks =
+		"float RcpWidth() { return BUFFER_RCP_WIDTH; }\n"
+		"#if defined(DEFINED_CHECK) && defined(NOT_PREDEFINED)\n#endif\n"
+		"#ifdef IFDEF_CHECK\n#endif\n"
+		"#ifndef IFNDEF_CHECK\n#endif\n"
+		"#undef REDEFINED\n#define REDEFINED 2\n"
+		"int Redefined() { return REDEFINED; }\n"
+		"#ifdef REDEFINED\n#endif\n";
+	const std::vector<std::string> expected_macros = { "BUFFER_RCP_WIDTH", "BUFFER_WIDTH", "DEFINED_CHECK", "IFDEF_CHECK", "IFNDEF_CHECK" };
+
+	const preprocess_result result = preprocess(directory, checks, false, macros);
+	CHECK(result.success);
+	CHECK(result.output.find("return (1.0 / 1920);") != std::string::npos);
+	CHECK(result.output.find("return 2;") != std::string::npos);
+	CHECK(result.referenced_predefined_macros == expected_macros);
+
+	// Same macros have to be reported when the checks are in a header that is replayed from the precompiled header cache
+	CHECK(reshade::test::write_file(directory / "checks.fxh", checks));
+	CHECK(check_precompiled_headers_match(directory, "#include \"checks.fxh\"\n", macros).referenced_predefined_macros == expected_macros);
+
+	// Only references on a path that is not skipped count
+	CHECK(preprocess(directory, "#if 0\nfloat x = BUFFER_RCP_HEIGHT;\n#ifdef IFDEF_CHECK\n#endif\n#endif\n", false, macros).referenced_predefined_macros.empty());
+}
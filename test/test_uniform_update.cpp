@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <reshade_api_device.hpp>
+#include <unordered_map>
+#include "runtime_internal.hpp"
+
+static const char s_synthetic_effect[] = R"(
+uniform float frame_time < source = "frametime"; >;
+uniform int random_value < source = "random"; min = 5; max = 10; >;
+uniform float2 ping_pong < source = "pingpong"; min = -1.0; max = 2.0; step = float2(0.5, 1.5); smoothing = 0.25; >;
+uniform bool key_toggle < source = "key"; keycode = 32; mode = "toggle"; >;
+uniform bool key_press < source = "key"; keycode = 13; mode = "press"; >;
+uniform bool key_out_of_range < source = "key"; keycode = 300; >;
+uniform bool key_toggle_legacy < source = "key"; keycode = 65; toggle = true; >;
+uniform bool mouse_button < source = "mousebutton"; keycode = 1; >;
+uniform bool mouse_button_out_of_range < source = "mousebutton"; keycode = 5; >;
+uniform float2 mouse_wheel < source = "mousewheel"; min = 0.0; max = 10.0; >;
+uniform bool overlay_open < source = "ui_open"; >;
+uniform float unknown_source < source = "bogus"; >;
+uniform float no_source = 1.0;
+
+void VS(uint id : SV_VertexID, out float4 position : SV_Position) { position = id; }
+float4 PS(float4 position : SV_Position) : SV_Target
+{
+	return frame_time + random_value + ping_pong.x + key_toggle + key_press + key_out_of_range + key_toggle_legacy + mouse_button + mouse_button_out_of_range + mouse_wheel.x + overlay_open + unknown_source + no_source;
+}
+
+technique T { pass { VertexShader = VS; PixelShader = PS; } }
+)";
+
+/// <summary>
+/// Compiles the synthetic effect and builds the list of uniform variables and their updates the same way the runtime does when loading an effect.
+/// </summary>
+static bool load_synthetic_effect(std::vector<reshade::uniform> &uniforms, std::vector<reshade::uniform_update> &updates)
+{
+	reshadefx::preprocessor pp;
+	if (!pp.append_string(s_synthetic_effect, "synthetic.fx"))
+		return false;
+
+	const std::unique_ptr<reshadefx::codegen> codegen(reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	if (!parser.parse(pp.output(), codegen.get()))
+		return false;
+
+	for (reshade::uniform variable : codegen->module().uniforms)
+	{
+		variable.special = reshade::special_uniform_from_source(variable.annotation_as_string("source"));
+
+		if (const reshade::uniform_update update(variable, uniforms.size());
+			update.special != reshade::special_uniform::none)
+			updates.push_back(update);
+
+		uniforms.push_back(std::move(variable));
+	}
+
+	return true;
+}
+
+static const reshade::uniform_update *find_update(const std::vector<reshade::uniform> &uniforms, const std::vector<reshade::uniform_update> &updates, const char *name)
+{
+	for (const reshade::uniform_update &update : updates)
+		if (uniforms[update.uniform_index].name == name)
+			return &update;
+	return nullptr;
+}
+
+TEST_CASE(uniform_update_resolves_annotations)
+{
+	std::vector<reshade::uniform> uniforms;
+	std::vector<reshade::uniform_update> updates;
+	CHECK(load_synthetic_effect(uniforms, updates));
+	CHECK(uniforms.size() == 13);
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "frame_time"); update != nullptr)
+		CHECK(update->special == reshade::special_uniform::frame_time);
+	else
+		CHECK(!"frame_time has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "random_value"); update != nullptr)
+	{
+		CHECK(update->special == reshade::special_uniform::random);
+		CHECK(update->int_range[0] == 5 && update->int_range[1] == 10);
+	}
+	else
+		CHECK(!"random_value has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "ping_pong"); update != nullptr)
+	{
+		CHECK(update->special == reshade::special_uniform::ping_pong);
+		CHECK(update->float_range[0] == -1.0f && update->float_range[1] == 2.0f);
+		CHECK(update->step[0] == 0.5f && update->step[1] == 1.5f);
+		CHECK(update->smoothing == 0.25f);
+	}
+	else
+		CHECK(!"ping_pong has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "key_toggle"); update != nullptr)
+	{
+		CHECK(update->special == reshade::special_uniform::key);
+		CHECK(update->keycode == 32 && update->mode == reshade::uniform_update::key_mode::toggle);
+	}
+	else
+		CHECK(!"key_toggle has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "key_press"); update != nullptr)
+		CHECK(update->keycode == 13 && update->mode == reshade::uniform_update::key_mode::press);
+	else
+		CHECK(!"key_press has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "key_toggle_legacy"); update != nullptr)
+		CHECK(update->keycode == 65 && update->mode == reshade::uniform_update::key_mode::toggle);
+	else
+		CHECK(!"key_toggle_legacy has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "mouse_button"); update != nullptr)
+	{
+		CHECK(update->special == reshade::special_uniform::mouse_button);
+		CHECK(update->keycode == 1 && update->mode == reshade::uniform_update::key_mode::down);
+	}
+	else
+		CHECK(!"mouse_button has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "mouse_wheel"); update != nullptr)
+	{
+		CHECK(update->special == reshade::special_uniform::mouse_wheel);
+		CHECK(update->float_range[0] == 0.0f && update->float_range[1] == 10.0f);
+		// Step defaults to one when not specified
+		CHECK(update->step[0] == 1.0f);
+	}
+	else
+		CHECK(!"mouse_wheel has no update");
+
+	if (const reshade::uniform_update *const update = find_update(uniforms, updates, "overlay_open"); update != nullptr)
+		CHECK(update->special == reshade::special_uniform::overlay_open);
+	else
+		CHECK(!"overlay_open has no update");
+}
+
+TEST_CASE(uniform_update_skips_variables_without_per_frame_work)
+{
+	std::vector<reshade::uniform> uniforms;
+	std::vector<reshade::uniform_update> updates;
+	CHECK(load_synthetic_effect(uniforms, updates));
+
+	// Out-of-range key codes, unknown sources and plain variables never get an update
+	CHECK(find_update(uniforms, updates, "key_out_of_range") == nullptr);
+	CHECK(find_update(uniforms, updates, "mouse_button_out_of_range") == nullptr);
+	CHECK(find_update(uniforms, updates, "unknown_source") == nullptr);
+	CHECK(find_update(uniforms, updates, "no_source") == nullptr);
+	CHECK(updates.size() == 9);
+
+	for (const reshade::uniform_update &update : updates)
+	{
+		CHECK(update.uniform_index < uniforms.size());
+		CHECK(update.special == uniforms[update.uniform_index].special);
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test.hpp"
+#include "recording_device.hpp"
+#include <reshade_api_device.hpp>
+#include <unordered_map>
+#include "runtime_internal.hpp"
+
+/// <summary>
+/// Creates an effect with a constant buffer and the specified amount of uniform data, which is all marked as modified, like after loading the effect.
+/// </summary>
+static reshade::effect create_effect(uint64_t cb, size_t size)
+{
+	reshade::effect effect;
+	effect.cb = { cb };
+	effect.uniform_data_storage.resize(size);
+	for (size_t i = 0; i < size; ++i)
+		effect.uniform_data_storage[i] = static_cast<uint8_t>(i);
+	effect.mark_uniform_data_dirty(0, size);
+	return effect;
+}
+
+/// <summary>
+/// Renders the specified number of techniques of every effect, which update the uniform data before each technique the same way the runtime does.
+/// </summary>
+static void render_frame(std::vector<reshade::effect> &effects, size_t num_techniques, reshade::test::recording_device &device, reshade::test::recording_command_list &cmd_list, uint32_t renderer_id)
+{
+	for (reshade::effect &effect : effects)
+		for (size_t i = 0; i < num_techniques; ++i)
+			effect.update_uniform_data(&device, &cmd_list, {}, renderer_id);
+}
+
+TEST_CASE(uniform_upload_once_per_effect_per_frame)
+{
+	for (const uint32_t renderer_id : { 0xb000u, 0xc000u, 0x14600u, 0x21000u })
+	{
+		reshade::test::recording_device device;
+		reshade::test::recording_command_list cmd_list(&device);
+
+		std::vector<reshade::effect> effects;
+		effects.push_back(create_effect(1, 64));
+		effects.push_back(create_effect(2, 256));
+
+		// Every effect is uploaded once, no matter how many of its techniques are rendered
+		render_frame(effects, 3, device, cmd_list, renderer_id);
+		CHECK(device.buffer_writes.size() == 2);
+		CHECK(device.buffer_contents[1] == effects[0].uniform_data_storage);
+		CHECK(device.buffer_contents[2] == effects[1].uniform_data_storage);
+
+		// Nothing is uploaded when no uniform variable changed
+		device.buffer_writes.clear();
+		render_frame(effects, 3, device, cmd_list, renderer_id);
+		CHECK(device.buffer_writes.empty());
+
+		// Only the effect with a modified variable is uploaded again
+		effects[1].uniform_data_storage[100] = 0xFF;
+		effects[1].mark_uniform_data_dirty(100, 1);
+		render_frame(effects, 3, device, cmd_list, renderer_id);
+		CHECK(device.buffer_writes.size() == 1);
+		CHECK(device.buffer_writes.empty() || device.buffer_writes[0].resource == effects[1].cb);
+		CHECK(device.buffer_contents[2] == effects[1].uniform_data_storage);
+
+		CHECK(cmd_list.push_constant_bytes == 0);
+	}
+}
+
+TEST_CASE(uniform_upload_writes_only_modified_range_on_d3d12_and_vulkan)
+{
+	for (const uint32_t renderer_id : { 0xc000u, 0xc100u, 0x20000u, 0x21000u })
+	{
+		reshade::test::recording_device device;
+		reshade::test::recording_command_list cmd_list(&device);
+
+		reshade::effect effect = create_effect(1, 64);
+		effect.update_uniform_data(&device, &cmd_list, {}, renderer_id);
+		device.buffer_writes.clear();
+
+		// Two separate modifications are merged into a single range spanning both
+		effect.uniform_data_storage[20] = 0xFF;
+		effect.mark_uniform_data_dirty(16, 8);
+		effect.uniform_data_storage[36] = 0xFF;
+		effect.mark_uniform_data_dirty(32, 8);
+		effect.update_uniform_data(&device, &cmd_list, {}, renderer_id);
+
+		CHECK(device.buffer_writes.size() == 1);
+		if (!device.buffer_writes.empty())
+		{
+			CHECK(device.buffer_writes[0].offset == 16);
+			CHECK(device.buffer_writes[0].size == 24);
+			// Must not discard, since the rest of the buffer still has to contain the previous data
+			CHECK(device.buffer_writes[0].access == reshade::api::map_access::write_only);
+		}
+		CHECK(device.buffer_contents[1] == effect.uniform_data_storage);
+	}
+}
+
+TEST_CASE(uniform_upload_writes_entire_buffer_on_d3d10_d3d11_and_opengl)
+{
+	for (const uint32_t renderer_id : { 0xa000u, 0xb000u, 0x14300u, 0x14600u })
+	{
+		reshade::test::recording_device device;
+		reshade::test::recording_command_list cmd_list(&device);
+
+		reshade::effect effect = create_effect(1, 64);
+		effect.update_uniform_data(&device, &cmd_list, {}, renderer_id);
+		device.buffer_writes.clear();
+
+		effect.mark_uniform_data_dirty(16, 8);
+		effect.update_uniform_data(&device, &cmd_list, {}, renderer_id);
+
+		CHECK(device.buffer_writes.size() == 1);
+		if (!device.buffer_writes.empty())
+		{
+			CHECK(device.buffer_writes[0].offset == 0);
+			CHECK(device.buffer_writes[0].size == 64);
+			CHECK(device.buffer_writes[0].access == reshade::api::map_access::write_discard);
+		}
+	}
+}
+
+TEST_CASE(uniform_upload_pushes_constants_on_d3d9)
+{
+	reshade::test::recording_device device;
+	reshade::test::recording_command_list cmd_list(&device);
+
+	// There is no constant buffer in D3D9
+	std::vector<reshade::effect> effects;
+	effects.push_back(create_effect(0, 64));
+
+	// Constant registers are shared with the application, so are set again before every technique, even when nothing changed
+	render_frame(effects, 3, device, cmd_list, 0x9000);
+	CHECK(device.buffer_writes.empty());
+	CHECK(cmd_list.push_constant_bytes == 3 * 64);
+}
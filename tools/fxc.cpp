@@ -6,10 +6,89 @@
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
+#include "job_system.hpp"
 #include "version.h"
+#include <atomic>
+#include <chrono>
+#include <new> // std::align_val_t, std::bad_alloc
+#include <cstdlib> // std::malloc, std::aligned_alloc, std::free
 #include <cstring>
+#include <thread>
 #include <fstream>
 #include <iostream>
+#include <iterator> // std::istreambuf_iterator
+#include <limits>
+#include <functional>
+#include <algorithm> // std::find_if, std::max, std::min, std::sort
+
+// Count heap allocations, so that they can be reported when benchmarking
+// Counting is only enabled in benchmark mode, so that normal compilation does not pay for the shared atomic counter
+static bool s_count_allocations = false;
+static std::atomic<size_t> s_allocation_count = 0;
+
+static void count_allocation()
+{
+	if (s_count_allocations)
+		s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void *allocate(size_t size)
+{
+	count_allocation();
+
+	if (size == 0)
+		size = 1;
+
+	if (void *const ptr = std::malloc(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+static void *allocate(size_t size, std::align_val_t alignment_value)
+{
+	count_allocation();
+
+	const size_t alignment = static_cast<size_t>(alignment_value);
+
+	if (size == 0)
+		size = 1;
+
+#ifdef _WIN32
+	if (void *const ptr = _aligned_malloc(size, alignment))
+		return ptr;
+#else
+	// Size has to be a multiple of the alignment for 'std::aligned_alloc'
+	if (void *const ptr = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1)))
+		return ptr;
+#endif
+	throw std::bad_alloc();
+}
+static void deallocate(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+static void deallocate(void *ptr, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	std::free(ptr);
+#endif
+}
+
+// Replace the allocation functions, so that every allocation is counted
+// Memory from the over-aligned forms has to be freed by the matching over-aligned form, since '_aligned_malloc' memory cannot be passed to 'free'
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void *operator new[](size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::align_val_t alignment) noexcept { deallocate(ptr, alignment); }
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept { deallocate(ptr, alignment); }
+void operator delete(void *ptr, size_t, std::align_val_t alignment) noexcept { deallocate(ptr, alignment); }
+void operator delete[](void *ptr, size_t, std::align_val_t alignment) noexcept { deallocate(ptr, alignment); }
 
 static void print_usage(const char *path)
 {
@@ -25,6 +104,8 @@ Options:
 
   -Fo <file>                Output SPIR-V binary to the given file.
   -Fe <file>                Output warnings and errors to the given file.
+  -Fm <file>                Output the effect module (reflection data and the code generated for the module and each entry point) in binary form to the given file.
+                            Input files containing such a binary effect module are loaded directly instead of being compiled again.
 
   --glsl                    Print GLSL code for the previously specified entry point.
   --hlsl                    Print HLSL code for the previously specified entry point.
@@ -37,156 +118,618 @@ Options:
   --vulkan-semantics        Generate GLSL/SPIR-V code under Vulkan semantics, instead of OpenGL semantics.
 
   -Zi                       Enable debug information.
+  -O                        Optimize the generated code (only applies to SPIR-V).
+
+  --bench <count>           Compile the input file, or every .fx file in the input directory, <count> times and print the time and number of heap allocations of each compilation phase as CSV.
+                            Uses all backends, unless '--glsl' or '--hlsl' is specified.
+
+  --batch <file>            Compile all jobs listed in the given manifest file, instead of a single input file.
+                            Each line of the manifest has the same format as the command-line (input file name and options like '-D', '--width', '--glsl' or '-Fo') and describes one job.
+                            Jobs inherit the options specified on the command-line, and a '-D' in the manifest replaces a definition of the same macro from there. Output is only written to the files specified with '-Fo', '-Fm' or '-P' in the manifest.
+                            Errors of all jobs are combined and written to standard output, or the file specified with '-Fe' on the command-line.
+  --threads <count>         Number of threads to compile batch jobs on. Defaults to the number of processor cores.
 	)", path);
 }
 
-int main(int argc, char *argv[])
+/// <summary>
+/// Options for compiling a single effect file, as specified on the command-line or in a line of a batch manifest.
+/// </summary>
+struct compile_options
 {
-	const char *filename = nullptr;
-	const char *preprocess = nullptr;
-	const char *errorfile = nullptr;
-	const char *objectfile = nullptr;
-	const char *buffer_width = "800";
-	const char *buffer_height = "600";
+	std::string filename;
+	std::string preprocess;
+	std::string errorfile;
+	std::string objectfile;
+	std::string modulefile;
+	std::string buffer_width = "800";
+	std::string buffer_height = "600";
 	bool print_glsl = false;
 	bool print_hlsl = false;
 	bool debug_info = false;
 	bool invert_y_axis = false;
+	bool optimize = false;
 	bool spec_constants = false;
 	bool vulkan_semantics = false;
 	unsigned int shader_model = 50;
+	std::vector<std::pair<std::string, std::string>> macros;
+	std::vector<std::filesystem::path> include_paths;
+};
+
+/// <summary>
+/// Parses the argument at the specified index and advances the index past any value it consumed.
+/// </summary>
+/// <returns><see langword="false"/> if the argument is an input file name, but one was already specified, <see langword="true"/> otherwise.</returns>
+static bool parse_argument(const std::vector<std::string> &args, size_t &i, compile_options &options)
+{
+	const std::string &arg = args[i];
+
+	if (arg.empty() || arg[0] != '-')
+	{
+		if (!options.filename.empty())
+			return false;
+
+		options.filename = arg;
+		return true;
+	}
+
+	if (arg == "-Zi")
+		options.debug_info = true;
+	else if (arg == "-O")
+		options.optimize = true;
+	else if (arg == "--glsl")
+		options.print_glsl = true;
+	else if (arg == "--hlsl")
+		options.print_hlsl = true;
+	else if (arg == "--invert-y")
+		options.invert_y_axis = true;
+	else if (arg == "--spec-constants")
+		options.spec_constants = true;
+	else if (arg == "--vulkan-semantics")
+		options.vulkan_semantics = true;
+
+	if (i + 1 >= args.size())
+		return true;
+	else if (arg == "-D")
+	{
+		const std::string &macro = args[++i];
+		const size_t value_offset = macro.find('=');
+		std::string name = macro.substr(0, value_offset);
+		std::string value = value_offset != std::string::npos ? macro.substr(value_offset + 1) : "1";
+
+		// A later definition of the same macro replaces the earlier one (e.g. a batch job overriding a definition inherited from the command-line)
+		if (const auto it = std::find_if(options.macros.begin(), options.macros.end(),
+				[&name](const std::pair<std::string, std::string> &definition) { return definition.first == name; });
+			it != options.macros.end())
+			it->second = std::move(value);
+		else
+			options.macros.emplace_back(std::move(name), std::move(value));
+	}
+	else if (arg == "-I")
+		options.include_paths.emplace_back(args[++i]);
+	else if (arg == "-P")
+		options.preprocess = args[++i];
+	else if (arg == "-Fe")
+		options.errorfile = args[++i];
+	else if (arg == "-Fo")
+		options.objectfile = args[++i];
+	else if (arg == "-Fm")
+		options.modulefile = args[++i];
+	else if (arg == "--shader-model")
+		options.shader_model = static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10));
+	else if (arg == "--width")
+		options.buffer_width = args[++i];
+	else if (arg == "--height")
+		options.buffer_height = args[++i];
+
+	return true;
+}
+
+static void init_preprocessor(reshadefx::preprocessor &pp, const compile_options &options)
+{
+	for (const std::filesystem::path &include_path : options.include_paths)
+		pp.add_include_path(include_path);
 
-	reshadefx::preprocessor pp;
 	pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
 	pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
 
-	// Parse command-line arguments
-	for (int i = 1; i < argc; ++i)
+	for (const std::pair<std::string, std::string> &macro : options.macros)
+		pp.add_macro_definition(macro.first, macro.second);
+
+	pp.add_macro_definition("BUFFER_WIDTH", options.buffer_width);
+	pp.add_macro_definition("BUFFER_HEIGHT", options.buffer_height);
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+}
+
+/// <summary>
+/// Preprocesses and compiles the effect file specified in the options.
+/// </summary>
+/// <param name="options">Options to compile with.</param>
+/// <param name="code">Receives the preprocessed source code if <see cref="compile_options::preprocess"/> is set, or the generated code otherwise.</param>
+/// <param name="errors">Receives the errors on failure.</param>
+/// <param name="jobs">Job system to spread work that can run in parallel across.</param>
+/// <param name="precompiled_headers">Set to <see langword="true"/> to reuse preprocessed included files between compilations.</param>
+static bool compile(const compile_options &options, std::string &code, std::string &errors, reshade::job_system &jobs, bool precompiled_headers = false)
+{
+	// Load binary effect modules directly, rather than treating them as source code
+	if (std::ifstream file(options.filename, std::ios::binary); file)
 	{
-		if (const char *arg = argv[i]; arg[0] == '-')
+		char signature[4] = {};
+		if (file.read(signature, sizeof(signature)) && reshadefx::is_serialized_module(std::string_view(signature, sizeof(signature))))
 		{
-			if (0 == std::strcmp(arg, "-h") || 0 == std::strcmp(arg, "--help"))
+			file.seekg(0);
+			const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+			reshadefx::effect_module module;
+			std::vector<std::string> entry_point_code;
+			if (!reshadefx::deserialize_module(data, module, code, entry_point_code))
 			{
-				print_usage(argv[0]);
-				return 0;
+				errors = options.filename + ": error: Binary effect module is corrupted or was written by a different version";
+				return false;
 			}
-			if (0 == std::strcmp(arg, "--version"))
+			if (!options.preprocess.empty())
 			{
-				printf("%s\n", VERSION_STRING_PRODUCT);
-				return 0;
+				errors = options.filename + ": error: Cannot preprocess a binary effect module";
+				return false;
 			}
 
-			if (0 == std::strcmp(arg, "-D"))
+			if (!options.modulefile.empty())
+				std::ofstream(options.modulefile, std::ios::binary).write(data.data(), data.size());
+			return true;
+		}
+	}
+
+	reshadefx::preprocessor pp;
+	pp.enable_precompiled_headers(precompiled_headers);
+	init_preprocessor(pp, options);
+
+	if (!pp.append_file(options.filename))
+	{
+		errors = pp.errors();
+		return false;
+	}
+
+	if (!options.preprocess.empty())
+	{
+		code = pp.output();
+		return true;
+	}
+
+	std::unique_ptr<reshadefx::codegen> backend;
+	if (options.print_glsl)
+		backend.reset(reshadefx::create_codegen_glsl(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis));
+	else if (options.print_hlsl)
+		backend.reset(reshadefx::create_codegen_hlsl(options.shader_model, options.debug_info, options.spec_constants));
+	else
+		backend.reset(reshadefx::create_codegen_spirv(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis));
+
+	reshadefx::parser parser;
+	if (!parser.parse(pp.output(), backend.get()))
+	{
+		errors = pp.errors() + parser.errors();
+		return false;
+	}
+
+	if (options.optimize)
+		backend->optimize_code();
+
+	code = backend->finalize_code();
+
+	if (!options.modulefile.empty())
+	{
+		const std::string data = reshadefx::serialize_module(backend->module(), code, backend->finalize_code_for_entry_points(
+			[&jobs](size_t count, const std::function<void(size_t)> &func) {
+				// Waiting on a group is safe from within another job (e.g. a batch job), since the waiting thread helps out with the jobs of the group
+				reshade::job_system::group entry_point_jobs;
+				for (size_t i = 0; i < count; ++i)
+					jobs.submit(entry_point_jobs, [&func, i]() { func(i); });
+				jobs.wait(entry_point_jobs);
+			}));
+		std::ofstream(options.modulefile, std::ios::binary).write(data.data(), data.size());
+	}
+
+	return true;
+}
+
+struct bench_backend
+{
+	std::string name;
+	std::function<reshadefx::codegen *()> create;
+};
+
+/// <summary>
+/// Accumulated time and allocations of a single compilation phase across all iterations.
+/// </summary>
+struct bench_phase
+{
+	explicit bench_phase(const char *name) : name(name) {}
+
+	/// <summary>
+	/// Runs the specified function and adds its wall time and number of heap allocations to this phase.
+	/// </summary>
+	template <typename F>
+	auto measure(F func)
+	{
+		const size_t allocations_before = s_allocation_count.load(std::memory_order_relaxed);
+		const auto time_before = std::chrono::steady_clock::now();
+
+		struct record_on_exit
+		{
+			bench_phase &phase;
+			size_t allocations_before;
+			std::chrono::steady_clock::time_point time_before;
+
+			~record_on_exit()
 			{
-				char *macro = argv[++i];
-				char *value = std::strchr(macro, '=');
-				if (value) *value++ = '\0';
-				pp.add_macro_definition(macro, value ? value : "1");
-				continue;
+				const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - time_before;
+				phase.total_time += time.count();
+				phase.min_time = std::min(phase.min_time, time.count());
+				phase.allocations += s_allocation_count.load(std::memory_order_relaxed) - allocations_before;
+				phase.iterations++;
+			}
+		} const record { *this, allocations_before, time_before };
+
+		return func();
+	}
+
+	void print(const std::filesystem::path &file, const std::string &backend) const
+	{
+		if (iterations == 0)
+			return;
+
+		std::cout << file.u8string() << ',' << backend << ',' << name << ',' << iterations << ',' << min_time << ',' << (total_time / iterations) << ',' << (allocations / iterations) << '\n';
+	}
+
+	const char *name;
+	unsigned int iterations = 0;
+	double min_time = std::numeric_limits<double>::max();
+	double total_time = 0.0;
+	size_t allocations = 0;
+};
+
+static bool benchmark(const compile_options &options, const std::vector<bench_backend> &backends, unsigned int iterations)
+{
+	// This is set before any threads are started, so does not need to be atomic
+	s_count_allocations = true;
+
+	const std::filesystem::path path = options.filename;
+
+	std::vector<std::filesystem::path> files;
+	if (std::error_code ec; std::filesystem::is_directory(path, ec))
+	{
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(path, ec))
+			if (entry.path().extension() == ".fx")
+				files.push_back(entry.path());
+
+		// Sort files, so that results are printed in a stable order
+		std::sort(files.begin(), files.end());
+	}
+	else
+	{
+		files.push_back(path);
+	}
+
+	bool success = true;
+
+	std::cout << "file,backend,phase,iterations,min_ms,mean_ms,allocations" << std::endl;
+
+	for (const std::filesystem::path &file : files)
+	{
+		reshadefx::preprocessor::clear_include_cache();
+
+		bench_phase preprocess_phase("preprocess");
+		std::string preprocessed;
+
+		for (unsigned int i = 0; i <= iterations; ++i)
+		{
+			reshadefx::preprocessor pp;
+			init_preprocessor(pp, options);
+
+			// The first iteration is not measured and only fills the include cache
+			const auto append_file = [&]() { return pp.append_file(file); };
+			if (!(i == 0 ? append_file() : preprocess_phase.measure(append_file)))
+			{
+				std::cerr << pp.errors() << std::endl;
+				success = false;
+				break;
 			}
 
-			if (0 == std::strcmp(arg, "-I"))
+			preprocessed = pp.output();
+		}
+
+		if (preprocess_phase.iterations != iterations)
+			continue;
+
+		preprocess_phase.print(file, "none");
+
+		for (const bench_backend &backend : backends)
+		{
+			// Code generation happens while parsing, so those two phases cannot be measured separately
+			bench_phase parse_phase("parse");
+			bench_phase optimize_phase("optimize");
+			bench_phase finalize_phase("finalize");
+			bench_phase finalize_entry_points_phase("finalize_entry_points");
+
+			for (unsigned int i = 0; i < iterations; ++i)
 			{
-				pp.add_include_path(argv[++i]);
-				continue;
+				const std::unique_ptr<reshadefx::codegen> codegen(backend.create());
+
+				reshadefx::parser parser;
+				if (!parse_phase.measure([&]() { return parser.parse(preprocessed, codegen.get()); }))
+				{
+					std::cerr << parser.errors() << std::endl;
+					success = false;
+					break;
+				}
+
+				if (options.optimize)
+					optimize_phase.measure([&]() { codegen->optimize_code(); });
+
+				finalize_phase.measure([&]() { return codegen->finalize_code(); });
+				finalize_entry_points_phase.measure([&]() { return codegen->finalize_code_for_entry_points(); });
 			}
 
-			if (0 == std::strcmp(arg, "-Zi"))
-				debug_info = true;
-			else if (0 == std::strcmp(arg, "--glsl"))
-				print_glsl = true;
-			else if (0 == std::strcmp(arg, "--hlsl"))
-				print_hlsl = true;
-			else if (0 == std::strcmp(arg, "--invert-y"))
-				invert_y_axis = true;
-			else if (0 == std::strcmp(arg, "--spec-constants"))
-				spec_constants = true;
-			else if (0 == std::strcmp(arg, "--vulkan-semantics"))
-				vulkan_semantics = true;
-
-			if (i + 1 >= argc)
+			if (finalize_phase.iterations != iterations)
 				continue;
-			else if (0 == std::strcmp(arg, "-P"))
-				preprocess = argv[++i];
-			else if (0 == std::strcmp(arg, "-Fe"))
-				errorfile = argv[++i];
-			else if (0 == std::strcmp(arg, "-Fo"))
-				objectfile = argv[++i];
-			else if (0 == std::strcmp(arg, "--shader-model"))
-				shader_model = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
-			else if (0 == std::strcmp(arg, "--width"))
-				buffer_width = argv[++i];
-			else if (0 == std::strcmp(arg, "--height"))
-				buffer_height = argv[++i];
+
+			parse_phase.print(file, backend.name);
+			optimize_phase.print(file, backend.name);
+			finalize_phase.print(file, backend.name);
+			finalize_entry_points_phase.print(file, backend.name);
+		}
+	}
+
+	return success;
+}
+
+/// <summary>
+/// Splits a line of a batch manifest into separate arguments at white space, keeping text enclosed in double quotes together.
+/// </summary>
+static std::vector<std::string> split_arguments(const std::string &line)
+{
+	std::vector<std::string> args;
+
+	std::string arg;
+	bool has_arg = false;
+	bool in_quotes = false;
+	for (const char c : line)
+	{
+		if (c == '\"')
+		{
+			in_quotes = !in_quotes;
+			has_arg = true;
+		}
+		else if (!in_quotes && (c == ' ' || c == '\t' || c == '\r'))
+		{
+			if (has_arg)
+				args.push_back(std::move(arg));
+			arg.clear();
+			has_arg = false;
 		}
 		else
 		{
-			if (filename != nullptr)
+			arg += c;
+			has_arg = true;
+		}
+	}
+
+	if (has_arg)
+		args.push_back(std::move(arg));
+
+	return args;
+}
+
+static bool compile_batch(const std::string &manifest_path, const compile_options &base_options, reshade::job_system &compile_jobs)
+{
+	struct batch_job
+	{
+		size_t line = 0;
+		compile_options options;
+		std::string errors;
+		bool success = false;
+	};
+
+	std::vector<batch_job> jobs;
+	std::string errors;
+
+	std::ifstream manifest(manifest_path);
+	if (!manifest)
+	{
+		errors += "error: Failed to open batch manifest '" + manifest_path + "'\n";
+	}
+
+	size_t line_number = 0;
+	for (std::string line; std::getline(manifest, line);)
+	{
+		line_number++;
+
+		const std::vector<std::string> args = split_arguments(line);
+		// Skip empty lines and comments
+		if (args.empty() || args[0][0] == '#')
+			continue;
+
+		batch_job &job = jobs.emplace_back();
+		job.line = line_number;
+		job.options = base_options;
+		// Inputs and outputs are per job and must not be inherited from the command-line
+		job.options.filename.clear();
+		job.options.preprocess.clear();
+		job.options.errorfile.clear();
+		job.options.objectfile.clear();
+		job.options.modulefile.clear();
+
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			if (!parse_argument(args, i, job.options))
 			{
-				std::cout << "error: More than one input file specified" << std::endl;
-				return 1;
+				errors += manifest_path + '(' + std::to_string(line_number) + "): error: More than one input file specified\n";
+				break;
 			}
+		}
+
+		if (job.options.filename.empty())
+			errors += manifest_path + '(' + std::to_string(line_number) + "): error: No input file specified\n";
+	}
+
+	if (errors.empty())
+	{
+		reshade::job_system::group batch_jobs;
+
+		for (batch_job &job : jobs)
+		{
+			compile_jobs.submit(batch_jobs, [&job, &compile_jobs]() {
+				std::string code;
+				job.success = compile(job.options, code, job.errors, compile_jobs, true);
+
+				if (!job.success)
+				{
+					if (!job.options.errorfile.empty())
+						std::ofstream(job.options.errorfile) << job.errors;
+					return;
+				}
+
+				if (!job.options.preprocess.empty())
+				{
+					if (job.options.preprocess != "-")
+						std::ofstream(job.options.preprocess) << code;
+				}
+				else if (!job.options.objectfile.empty())
+				{
+					std::ofstream(job.options.objectfile, std::ios::binary).write(code.data(), code.size());
+				}
+			});
+		}
 
-			filename = arg;
+		// The calling thread helps out with compiling, so it counts towards the number of threads too
+		compile_jobs.wait(batch_jobs);
+
+		size_t num_failed = 0;
+		for (const batch_job &job : jobs)
+		{
+			if (job.success)
+				continue;
+
+			num_failed++;
+			errors += manifest_path + '(' + std::to_string(job.line) + "): error: Failed to compile '" + job.options.filename + "':\n" + job.errors;
+			if (!job.errors.empty() && job.errors.back() != '\n')
+				errors += '\n';
 		}
+
+		if (num_failed != 0)
+			errors += std::to_string(num_failed) + " of " + std::to_string(jobs.size()) + " jobs failed\n";
 	}
 
-	if (filename == nullptr)
+	if (base_options.errorfile.empty())
+		std::cout << errors << std::flush;
+	else
+		std::ofstream(base_options.errorfile) << errors;
+
+	return errors.empty();
+}
+
+int main(int argc, char *argv[])
+{
+	compile_options options;
+	std::string manifest;
+	unsigned int num_threads = std::thread::hardware_concurrency();
+	unsigned int bench_iterations = 0;
+
+	// Parse command-line arguments
+	const std::vector<std::string> args(argv + 1, argv + argc);
+	for (size_t i = 0; i < args.size(); ++i)
 	{
-		print_usage(argv[0]);
-		return 1;
+		const std::string &arg = args[i];
+
+		if (arg == "-h" || arg == "--help")
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+		if (arg == "--version")
+		{
+			printf("%s\n", VERSION_STRING_PRODUCT);
+			return 0;
+		}
+
+		if (i + 1 < args.size())
+		{
+			if (arg == "--bench")
+			{
+				bench_iterations = static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10));
+				continue;
+			}
+			if (arg == "--batch")
+			{
+				manifest = args[++i];
+				continue;
+			}
+			if (arg == "--threads")
+			{
+				num_threads = static_cast<unsigned int>(std::strtoul(args[++i].c_str(), nullptr, 10));
+				continue;
+			}
+		}
+
+		if (!parse_argument(args, i, options))
+		{
+			std::cout << "error: More than one input file specified" << std::endl;
+			return 1;
+		}
 	}
 
-	pp.add_macro_definition("BUFFER_WIDTH", buffer_width);
-	pp.add_macro_definition("BUFFER_HEIGHT", buffer_height);
-	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
-	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	// The thread waiting on jobs helps out executing them, so create one less worker thread than requested
+	reshade::job_system jobs(std::max(num_threads, 2u) - 1);
 
-	if (!pp.append_file(filename))
+	if (!manifest.empty())
 	{
-		if (errorfile == nullptr)
-			std::cout << pp.errors() << std::endl;
-		else
-			std::ofstream(errorfile) << pp.errors();
-		return 1;
+		return compile_batch(manifest, options, jobs) ? 0 : 1;
 	}
 
-	if (preprocess != nullptr)
+	if (options.filename.empty())
 	{
-		if (std::strcmp(preprocess, "-") == 0)
-			std::cout << pp.output() << std::endl;
-		else
-			std::ofstream(preprocess) << pp.output();
-		return 0;
+		print_usage(argv[0]);
+		return 1;
 	}
 
-	std::unique_ptr<reshadefx::codegen> backend;
-	if (print_glsl)
-		backend.reset(reshadefx::create_codegen_glsl(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
-	else if (print_hlsl)
-		backend.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, spec_constants));
-	else
-		backend.reset(reshadefx::create_codegen_spirv(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
+	if (bench_iterations != 0)
+	{
+		std::vector<bench_backend> backends;
+		if (!options.print_hlsl)
+			backends.push_back({ "glsl", [&options]() { return reshadefx::create_codegen_glsl(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis); } });
+		if (!options.print_glsl)
+			for (unsigned int shader_model : { 30u, 40u, 50u })
+				if (!options.print_hlsl || shader_model == options.shader_model)
+					backends.push_back({ "hlsl" + std::to_string(shader_model), [&options, shader_model]() { return reshadefx::create_codegen_hlsl(shader_model, options.debug_info, options.spec_constants); } });
+		if (!options.print_glsl && !options.print_hlsl)
+			backends.push_back({ "spirv", [&options]() { return reshadefx::create_codegen_spirv(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis); } });
 
-	reshadefx::parser parser;
-	if (!parser.parse(pp.output(), backend.get()))
+		return benchmark(options, backends, bench_iterations) ? 0 : 1;
+	}
+
+	std::string code, errors;
+	if (!compile(options, code, errors, jobs))
 	{
-		if (errorfile == nullptr)
-			std::cout << pp.errors() << parser.errors() << std::endl;
+		if (options.errorfile.empty())
+			std::cout << errors << std::endl;
 		else
-			std::ofstream(errorfile) << pp.errors() << parser.errors();
+			std::ofstream(options.errorfile) << errors;
 		return 1;
 	}
 
-	std::basic_string<char> code = backend->finalize_code();
-
-	if (print_glsl || print_hlsl)
+	if (!options.preprocess.empty())
+	{
+		if (options.preprocess == "-")
+			std::cout << code << std::endl;
+		else
+			std::ofstream(options.preprocess) << code;
+	}
+	else if (options.print_glsl || options.print_hlsl)
 	{
 		std::cout.write(code.data(), code.size()).flush();
 	}
-	else if (objectfile != nullptr)
+	else if (!options.objectfile.empty())
 	{
-		std::ofstream(objectfile, std::ios::binary).write(code.data(), code.size());
+		std::ofstream(options.objectfile, std::ios::binary).write(code.data(), code.size());
 	}
 
 	return 0;